@@ -53,12 +53,13 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 
 /**
 *  all the pool threads are initially in a waiting state until jobs are available for execution.
+*  The threads live as long as the pool, so that a single pool runs all the processing phases
+*  and index parts. 'waitAll' is the barrier at the end of a phase or an index part.
 */
 class ThreadPool
 {
 protected:
-	std::mutex job_queue_mx; // lock for pop/push on jobs_
-	std::mutex job_done_mx; // lock for checking jobs_.empty and shutdown
+	std::mutex job_queue_mx; // lock for pop/push on jobs_, and the running threads count
 	std::condition_variable cv_jobs;
 	std::condition_variable cv_done;
 	std::atomic_bool shutdown_;
@@ -90,6 +91,9 @@ public:
 		PRN_MEM("ThreadPool destructor done.");
 	}
 
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
 protected:
 		void threadEntry(int i)
 		{
@@ -101,15 +105,10 @@ protected:
 					std::unique_lock<std::mutex> lk(job_queue_mx);
 
 					// Sleep until there is a job to execute or a shutdown flag set
-					while (!shutdown_.load() && jobs_.empty())
-						cv_jobs.wait(lk); // works
-					//cv_jobs.wait(lk, [this] { return !shutdown_.load() && jobs_.empty(); });
+					cv_jobs.wait(lk, [this] { return shutdown_.load() || !jobs_.empty(); });
 
 					if (jobs_.empty()) // No jobs to do and shutting down
-					{
-						INFO("Thread  ", std::this_thread::get_id(), " job done");
 						return;
-					}
 
 					job = std::move(jobs_.front());
 					jobs_.pop();
@@ -118,11 +117,15 @@ protected:
 				// mutex 'job_queue_mx' released here
 
 				job(); // Do the job without holding any locks
-				--running_threads;
-
-				INFO("number of running_threads= ", running_threads.load(), " jobs queue is empty= ", jobs_.empty());
+				job = nullptr; // release the captures before signaling done
 
-				cv_done.notify_one(); // wake up the main thread waiting in 'waitAll'. Keep it here for multi-reference cases.
+				{
+					// under the lock, so that 'waitAll' cannot miss the notification between its check and wait
+					std::lock_guard<std::mutex> lk(job_queue_mx);
+					--running_threads;
+					if (running_threads.load() == 0 && jobs_.empty())
+						cv_done.notify_all(); // wake up the main thread waiting in 'waitAll'
+				}
 			} // ~for
 		} // ~threadEntry
 
@@ -137,10 +140,10 @@ public:
 		cv_jobs.notify_one();
 	}
 
-	// wait till no jobs running
+	// wait till no jobs queued or running. The threads stay for the next jobs
 	void waitAll()
 	{
-		std::unique_lock<std::mutex> lk(job_done_mx);
+		std::unique_lock<std::mutex> lk(job_queue_mx);
 		cv_done.wait(lk, [this] { return running_threads.load() == 0 && jobs_.empty(); });
 	}
 
@@ -148,7 +151,8 @@ public:
 	void joinAll()
 	{
 		for (auto& thread : threads_)
-			thread.join();
+			if (thread.joinable()) thread.join();
 	}
-}; // ~class ThreadPool
 
+	std::size_t size() const { return threads_.size(); }
+}; // ~class ThreadPool
@@ -0,0 +1,90 @@
+/*
+@copyright 2016-2026 Clarity Genomics BVBA
+@copyright 2012-2016 Bonsai Bioinformatics Research Group
+@copyright 2014-2016 Knight Lab, Department of Pediatrics, UCSD, La Jolla
+
+@parblock
+SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+
+This is a free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SortMeRNA is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+@endparblock
+
+@contributors Jenya Kopylova   jenya.kopylov@gmail.com
+              Laurent Noé      laurent.noe@lifl.fr
+              Pierre Pericard  pierre.pericard@lifl.fr
+              Daniel McDonald  wasade@gmail.com
+              Mikaël Salson    mikael.salson@lifl.fr
+              Hélène Touzet    helene.touzet@lifl.fr
+              Rob Knight       robknight@ucsd.edu
+              biocodz          biocodz@protonmail.com
+*/
+
+/**
+ * FILE: aligncache.hpp
+ * Created: Oct 19, 2026 Mon
+ *
+ * Cache of alignment results keyed on the read sequence. Used to skip the seed search
+ * and SW for exact duplicate reads (amplicons, deep metatranscriptomes) - see 'align2'.
+ *
+ * Only the reads without prior alignment results (nothing in KVDB) are cached, so that
+ * identical sequences are guaranteed to produce identical results on the given index part.
+ * The cache has to be cleared when the next index part is loaded.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+class AlignCache {
+public:
+	/*
+	 * Alignment outcome of the first occurrence of a sequence
+	 */
+	struct Entry {
+		std::string bin; // Read::toBinString after the alignment. Empty if no alignment was found
+		bool is_hit; // read.is_hit
+		bool is_new_hit; // read.is_new_hit
+		bool is_done; // read.is_done
+	};
+
+	/*
+	 * @param max_size  max number of sequences to keep. When reached, no new sequences are added
+	 * @param num_shards  number of independently locked shards
+	 */
+	AlignCache(size_t max_size, unsigned num_shards = 64);
+
+	bool find(const std::string& seq, Entry& entry);
+	void put(const std::string& seq, Entry entry);
+	void clear();
+	bool is_enabled() { return max_size > 0; }
+
+	std::atomic<uint64_t> num_lookup; // number of lookups
+	std::atomic<uint64_t> num_hit; // number of lookups that found the sequence
+
+private:
+	struct Shard {
+		std::mutex mx;
+		std::unordered_map<std::string, Entry> map;
+	};
+
+	Shard& get_shard(const std::string& seq);
+
+	size_t max_size;
+	size_t max_shard_size;
+	std::vector<Shard> shards;
+}; // ~class AlignCache
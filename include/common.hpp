@@ -60,6 +60,7 @@ enum class FEED_TYPE : unsigned {
     MAX = SPLIT_READS
 };
 enum class BlastFormat { TABULAR, REGULAR}; // format of the Blast output
+enum class KVDB_PROFILE : unsigned { DEFAULT = 0, BULK = 1, SMALL = 2 }; // RocksDB tuning. See KeyValueDatabase
 
 /*! @brief Map nucleotides to integers.
 Ambiguous letters map to 4.
@@ -38,6 +38,7 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <vector>
+#include <string>
 #include <cstdint>
 
 // forward
@@ -73,4 +74,11 @@ struct Index {
 	//~Index() {}
 	void load(uint32_t idx_num, uint32_t idx_part, std::vector<std::pair<std::string, std::string>>& indexfiles, Refstats & refstats);
 	void unload();
+
+	/*
+	 * Read through the files of an index part to bring them into the OS file cache,
+	 * so that the following 'load' of the part does not wait on the disk.
+	 * Runs on an idle pool thread while the current part is processed. Missing files are skipped.
+	 */
+	static void prefetch(uint32_t idx_num, uint32_t idx_part, const std::vector<std::pair<std::string, std::string>>& indexfiles);
 }; // ~struct Index
@@ -83,11 +83,20 @@ struct NodeElement
 	char flag;
 };
 
+// index format version, stored with the flags at the end of the '.stats' file. Indexes without it are version 1
+#define INDEX_VERSION 2
+// '.stats' flag: the reverse complement of the references is indexed too ('--index_rc')
+#define INDEX_FLAG_RC 0x1
+// 'seq_pos.seq' flag: the 19-mer is on the reverse complement of the sequence ('--index_rc')
+#define SEQ_POS_RC 0x80000000
+
 // the reference sequence number and position at which a 19-mer exists on the sequence; these values *must* be positive
+// A 19-mer at 'p' on the reverse complement of a sequence of length 'n' has 'pos = n - p - L', so that the
+// hit of the read window at 'w' has the diagonal of the reversed read window at 'readlen - w - L'
 struct seq_pos
 {
 	uint32_t pos; // position on the sequence
-	uint32_t seq; // the sequence number (in the original reference files?)
+	uint32_t seq; // the sequence number (in the original reference files?) | SEQ_POS_RC
 };
 
 struct kmer_origin
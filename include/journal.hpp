@@ -0,0 +1,75 @@
+/*
+@copyright 2016-2026 Clarity Genomics BVBA
+@copyright 2012-2016 Bonsai Bioinformatics Research Group
+@copyright 2014-2016 Knight Lab, Department of Pediatrics, UCSD, La Jolla
+
+@parblock
+SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+
+This is a free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SortMeRNA is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+@endparblock
+
+@contributors Jenya Kopylova   jenya.kopylov@gmail.com
+              Laurent Noé      laurent.noe@lifl.fr
+              Pierre Pericard  pierre.pericard@lifl.fr
+              Daniel McDonald  wasade@gmail.com
+              Mikaël Salson    mikael.salson@lifl.fr
+              Hélène Touzet    helene.touzet@lifl.fr
+              Rob Knight       robknight@ucsd.edu
+              biocodz          biocodz@protonmail.com
+*/
+
+/**
+ * FILE: journal.hpp
+ * Created: Oct 19, 2026 Mon
+ *
+ * Alignment progress journal kept in KVDB next to the Readstats. Records the last index part
+ * aligned completely, so that a restarted run skips the parts already done - see 'align'.
+ *
+ * The journal is only valid for the same inputs: the fingerprint covers the reads and reference
+ * files (path, size, modification time) and the command line.
+ */
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+class KeyValueDatabase;
+struct Readstats;
+struct Runopts;
+
+class Journal {
+public:
+	enum class STATE { NONE, MATCH, MISMATCH };
+
+	Journal(Runopts& opts, Readstats& readstats);
+
+	/* look up the journal of a previous run. On MATCH the parts done are skipped by 'is_done' */
+	STATE restore(KeyValueDatabase& kvdb);
+	/* record the part done. Called after all the results of the part are in KVDB */
+	void store(KeyValueDatabase& kvdb, Readstats& readstats, uint32_t idx_num, uint32_t idx_part);
+	bool is_done(uint32_t idx_num, uint32_t idx_part) const;
+	bool is_enabled() const { return is_enabled_; }
+
+private:
+	static const uint8_t VERSION = 2; // 2: 'KeyValueDatabase::read_key' with the 2 bytes slot index
+
+	bool is_enabled_; // no journal for reads streams and the in-memory results
+	std::string dbkey; // 'journal_' + Readstats::dbkey
+	std::string fingerprint;
+	bool is_restored = false;
+	uint32_t done_num = 0; // last index done
+	uint32_t done_part = 0; // last part of the 'done_num' index done
+}; // ~class Journal
@@ -40,16 +40,182 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include "rocksdb/db.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/options.h"
+#include "rocksdb/write_batch.h"
+
+#include "common.hpp" // KVDB_PROFILE
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
 
 class KeyValueDatabase {
 public:
-	KeyValueDatabase(std::string const &kvdbPath);
-	~KeyValueDatabase() { delete kvdb; }
+	/*
+	 * Batches the puts of a single thread into a WriteBatch, which is written to the DB
+	 * when it grows over BATCH_SIZE, on 'flush', and on destruction i.e. at the end
+	 * of the thread processing an index part.
+	 * The records are not visible to 'get' until written.
+	 *
+	 * With 'is_sst' the records are instead sorted and written to external SST files, one per
+	 * reads slot, on 'flush' e.g. at the end of a chunk, or at SST_SIZE of the records.
+	 * 'KeyValueDatabase::ingest' adds them to the DB bypassing the memtables.
+	 */
+	class Writer {
+	public:
+		explicit Writer(KeyValueDatabase& kvdb, bool is_sst = false) : kvdb(kvdb), is_sst(is_sst && !kvdb.is_mem) {}
+		~Writer() { flush(); }
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		void put(const std::string& key, const std::string& val);
+		void flush();
+	private:
+		static const std::size_t BATCH_SIZE = 1 << 20; // 1 MB of the batch data triggers the write
+		static const std::size_t SST_SIZE = 64 << 20; // 64 MB of the records trigger an SST file
+		KeyValueDatabase& kvdb;
+		rocksdb::WriteBatch batch;
+		bool is_sst;
+		std::vector<std::pair<std::string, std::string>> records; // 'is_sst' records to sort
+		std::size_t records_size = 0;
+	}; // ~class Writer
+
+	/*
+	 * Reads the results back in the key order with an iterator per reads slot (see 'read_key'),
+	 * instead of a point lookup per read. For a thread looking up the reads of its chunks in the
+	 * reads file order, the iterators mostly step forward to the next key. Missing keys
+	 * i.e. reads without results are skipped over. Going back re-seeks.
+	 * Only the iterators of the last MAX_CURSORS slots are kept i.e. the FWD and REV slots
+	 * of the chunk being read. Moving on to the next chunk reuses the least recently used one.
+	 * The DB is not expected to change while the Scanner is in use.
+	 */
+	class Scanner {
+	public:
+		explicit Scanner(KeyValueDatabase& kvdb) : kvdb(kvdb) {}
+		Scanner(const Scanner&) = delete;
+		Scanner& operator=(const Scanner&) = delete;
+
+		std::string get(const std::string& key);
+	private:
+		static const unsigned MAX_NEXT = 16; // steps forward before falling back to a Seek
+		static const std::size_t READAHEAD_SIZE = 2 << 20;
+		static const std::size_t MAX_CURSORS = 2; // FWD and REV
+		struct Cursor {
+			std::unique_ptr<rocksdb::Iterator> it;
+			std::string last; // the key looked up last
+			uint64_t used = 0; // 'tick' of the last use
+		};
+		KeyValueDatabase& kvdb;
+		std::array<Cursor, MAX_CURSORS> cursors; // by the slot bytes of the read key, see 'last'
+		uint64_t tick = 0;
+	}; // ~class Scanner
+
+	static const std::size_t GET_BATCH = 256; // reads the processors look up in a single 'multi_get'
+	static const std::size_t READ_KEY_SIZE = 11;
+	static const std::size_t READ_SLOT_SIZE = 2; // bytes of the slot index in the read key
+	static const std::size_t MAX_READ_SLOTS = std::size_t(1) << (8 * READ_SLOT_SIZE);
+	static const char READ_KEY_TAG = 0; // first byte of the read keys. The other keys are printable e.g. 'journal_..'
+	static const uint8_t FORMAT_VERSION = 2; // 1: the read ID string keys, 2: 'read_key'. Stored with the Readstats
+
+	/*
+	 * Key of the read results: tag + 2 bytes big-endian reads slot index + 8 bytes big-endian read number.
+	 * The slot is the index of the read ID prefix i.e. 'Readfeed' chunk * num_sense + sense, up to MAX_READ_SLOTS,
+	 * the read number counts the reads of the slot.
+	 * Fixed width, so that the bytewise order of the keys is the order of the reads in the slots
+	 */
+	static std::string read_key(std::size_t slot_idx, uint64_t read_num);
+	/* @return false if the key is not a 'read_key' */
+	static bool parse_read_key(const std::string& key, std::size_t& slot_idx, uint64_t& read_num);
+
+	/*
+	 * @param is_wal   write the RocksDB Write Ahead Log
+	 * @param is_mem   keep the records in memory. RocksDB is only opened to spill the records
+	 *                 over 'mem_max' bytes. Nothing is left on disk for a later run to resume from.
+	 * @param mem_max  memory limit in bytes for 'is_mem'. 0 - no limit
+	 * @param profile  RocksDB tuning:
+	 *                 DEFAULT  zlib (Xpress on Windows), RocksDB defaults otherwise
+	 *                 BULK     write heavy alignment: LZ4, large memtables, no WAL, bloom filters,
+	 *                          compactions deferred to a single 'compact' after the alignment
+	 *                 SMALL    smaller DB for more CPU: zstd, bloom filters
+	 */
+	KeyValueDatabase(std::string const &kvdbPath, bool is_wal = true, bool is_mem = false, uint64_t mem_max = 0,
+		KVDB_PROFILE profile = KVDB_PROFILE::DEFAULT);
+	~KeyValueDatabase();
+
+	/*
+	 * 'is_mem': lay out the in-memory table for the reads slots of the feed. Call before the first put
+	 * @param num_slots       reads slots i.e. 'Readfeed' num_chunks x num_sense
+	 * @param reads_per_slot  average reads in a slot, sizes the table segments. 0 - unknown
+	 */
+	void init_mem(std::size_t num_slots, uint64_t reads_per_slot);
 
 	void put(std::string key, std::string val);
 	std::string get(std::string key);
+	/* look up the keys in a single call. Empty string for the keys not found */
+	std::vector<std::string> multi_get(const std::vector<std::string>& keys);
+	/* compact the whole DB if the compactions were deferred (BULK profile) and re-enable them */
+	void compact();
+	/*
+	 * add the SST files written by the 'is_sst' Writers so far. Call when the writers are done.
+	 * The files of different slots do not overlap and are added by a single call
+	 */
+	void ingest();
+	/* make the records written so far survive a crash. Flushes the memtables if there is no WAL */
+	void sync();
 	int clear(std::string dbPath);
 private:
-	rocksdb::DB* kvdb;
+	/*
+	 * In-memory record. The read results are keyed by 'read_key'
+	 * and stored in a dense table [slot_idx][read_num] allocated by segments.
+	 * The other records, and the reads of the slots over 'init_mem' ones, are kept in 'mem_misc'.
+	 * Both count against 'mem_max' and spill.
+	 */
+	struct MemSlot {
+		std::string val;
+		bool is_spilled = false; // the record is in RocksDB
+	};
+	static const std::size_t MEM_SEGMENT_MIN = 1 << 8; // reads per segment
+	static const std::size_t MEM_SEGMENT_MAX = 1 << 16;
+
+	void write(rocksdb::WriteBatch& batch);
+	MemSlot* mem_slot(const std::string& key, bool is_create);
+	void mem_put(std::string& key, std::string& val);
+	void mem_put_misc(std::string& key, std::string& val);
+	/* @return true if the value of 'old_size' bytes can be replaced with 'new_size' bytes within 'mem_max' */
+	bool mem_reserve(std::size_t old_size, std::size_t new_size);
+	void spill(const std::string& key, const std::string& val);
+	std::string mem_get(const std::string& key);
+	void open(); // open RocksDB. Lazily on the first spill if 'is_mem'
+	void write_sst(std::vector<std::pair<std::string, std::string>>& records);
+	void write_sst_file(std::vector<std::pair<std::string, std::string>>& records, std::size_t begin, std::size_t end);
+	void set_profile(KVDB_PROFILE profile);
+
+	std::string path;
+	KVDB_PROFILE profile;
+	rocksdb::DB* kvdb = nullptr;
 	rocksdb::Options options;
+	rocksdb::WriteOptions write_options; // disableWAL if opened without the WAL
+	std::once_flag open_flag;
+
+	struct SstFile {
+		std::string path;
+		std::string first; // smallest key
+		std::string last; // largest key
+	};
+	std::vector<SstFile> sst_files; // written, not yet ingested. In the order written
+	unsigned sst_count = 0; // names the SST files
+	std::mutex sst_lock;
+
+	bool is_mem;
+	uint64_t mem_max;
+	std::atomic<uint64_t> mem_size = 0; // bytes of the values held in memory
+	std::atomic<uint64_t> num_spilled = 0;
+	std::size_t mem_segment_size = MEM_SEGMENT_MAX; // reads per segment, see 'init_mem'
+	std::vector<std::vector<std::unique_ptr<MemSlot[]>>> mem_table; // [slot_idx][read_num / mem_segment_size]
+	std::shared_mutex mem_lock; // guards the 'mem_table' layout. The slots are written by a single thread each
+	std::unordered_map<std::string, std::string> mem_misc; // records not in 'mem_table' e.g. Readstats. Spilled ones erased
+	std::mutex misc_lock;
 };
@@ -113,6 +113,7 @@ OPT_DBG_PUT_DB = "dbg_put_db",
 OPT_TMPDIR = "tmpdir",
 OPT_INTERVAL = "interval",
 OPT_MAX_POS = "max_pos",
+OPT_INDEX_RC = "index_rc",
 OPT_READFEED = "readfeed",
 OPT_ZIP_OUT = "zip-out",
 OPT_INDEX = "index",
@@ -120,7 +121,20 @@ OPT_ALIGN = "align",  // TODO: on hold
 OPT_FILTER = "filter",  // TODO: on hold
 OPT_DBG_LEVEL = "dbg-level",
 OPT_MAX_READ_LEN = "max_read_len",
-OPT_SCORE_SPLIT = "score_split";
+OPT_SCORE_SPLIT = "score_split",
+OPT_DEDUP = "dedup",
+OPT_XDROP = "xdrop",
+OPT_READ_CACHE = "read_cache",
+OPT_CHUNKS = "chunks",
+OPT_NO_PRESCAN = "no_prescan",
+OPT_IO_URING = "io_uring",
+OPT_NO_WAL = "no_wal",
+OPT_KVDB_MEM = "kvdb_mem",
+OPT_KVDB_PROFILE = "kvdb_profile",
+OPT_KVDB_INGEST = "kvdb_ingest",
+OPT_FUSED = "fused",
+OPT_NO_SW_PRUNE = "no_sw_prune",
+OPT_NO_SKIP_DONE = "no_skip_done";
 
 // help strings
 const std::string \
@@ -135,10 +149,14 @@ help_ref =
 	"       Use mutliple times, once per a reference file\n\n",
 
 help_reads = 
-	"Raw reads file (FASTA/FASTQ/FASTA.GZ/FASTQ.GZ).\n\n"
+	"Raw reads file (FASTA/FASTQ flat or compressed with gzip/BGZF/bzip2/zstd).\n\n"
 	"       Use twice for files with paired reads.\n"
 	"       The file extensions are Not important. The program automatically\n"
-	"       recognizes the file format as flat/compressed, fasta/fastq\n\n",
+	"       recognizes the file format as flat/compressed, fasta/fastq\n"
+	"       A single frame zstd file is read by one thread, compress it\n"
+	"       in frames e.g. using 'pzstd' for the parallel reading\n"
+	"       '-' or a named pipe: the reads are streamed i.e. read once,\n"
+	"       flat fasta/fastq only e.g. 'zcat reads.fq.gz | sortmerna --reads -'\n\n",
 
 help_aligned = 
 	"Aligned reads file prefix [dir/][pfx]       WORKDIR/out/aligned\n\n"
@@ -384,6 +402,14 @@ help_max_pos =
 	"                                            store for each unique L-mer.\n"
 	"                                            If 0 - all positions are stored.\n",
 
+help_index_rc =
+	"Indexing: index the reverse complement of the           False\n"
+	"                                            references too, so that a single search of the read\n"
+	"                                            finds the hits on both strands, and SW runs only on\n"
+	"                                            the strand of the hits. About doubles the index size.\n"
+	"                                            Kept apart from the forward-only index in '-idx-dir'.\n"
+	"                                            Give it also when aligning on the index.\n",
+
 help_zip_out =
 	"Controls the output compression                        '-1'\n\n"
 	"       By default the report files are produced in the same format as the input i.e.\n"
@@ -420,7 +446,96 @@ help_score_split =
 	"Calculate minimal SW score per split rather than        False\n"
     "                                            all reads. This has an effect similar to increasing\n"
     "                                            e-value i.e. lowers the filtering threshold to less\n"
-    "                                            sensitive (see issue 453)\n"
+    "                                            sensitive (see issue 453)\n",
+
+help_dedup =
+	"Reuse the alignment of the first occurrence of a read   0\n"
+	"                                            for its exact duplicates. Optional value: max number\n"
+	"                                            of distinct sequences to cache (default 1000000).\n"
+	"                                            Useful for amplicon and deeply sequenced libraries.\n",
+
+help_no_sw_prune =
+	"Run full SW on every candidate window, also the ones    False\n"
+	"                                            whose score upper bound cannot pass the E-value\n"
+	"                                            threshold (skipped) or replace a kept alignment\n"
+	"                                            (score-only). For checking the pruning\n",
+
+help_no_skip_done =
+	"Feed also the reads done on a previous index part to    False\n"
+	"                                            the alignment of the next parts, which then passes\n"
+	"                                            them over. For checking the skipping in the feed\n",
+
+help_xdrop =
+	"Ungapped X-drop prefilter before SW. Positive integer:  0\n"
+	"                                            X-drop score. A candidate window is not aligned if\n"
+	"                                            its ungapped score along the seed diagonal, plus a\n"
+	"                                            match on every read position outside the ungapped\n"
+	"                                            segment, cannot pass the E-value threshold.\n"
+	"                                            0 - no prefilter. Heuristic, may lower sensitivity\n",
+
+help_read_cache =
+	"Cache the reads in a binary 2-bit encoded file on the   False\n"
+	"                                            first pass through the reads, and replay the cache on\n"
+	"                                            the following passes (index parts, OTU map, reports)\n"
+	"                                            instead of decompressing and parsing the reads again.\n"
+	"                                            The cache files are stored in '" + OPT_READB + "' directory\n"
+	"                                            and reused by later runs on the same reads files.\n",
+
+help_chunks =
+	"Number of read chunks per processing thread.            4\n"
+	"                                            Alignment threads pull the chunks from a shared queue\n"
+	"                                            so that a thread getting slow (e.g. rRNA rich) reads\n"
+	"                                            does not hold up the others. 1 - a fixed part per thread\n",
+
+help_no_prescan =
+	"Do not count the reads before the alignment. The reads  False\n"
+	"                                            statistics used for the E-value are estimated from the\n"
+	"                                            first 4 MB of the reads file, and the exact counts are\n"
+	"                                            taken from the first pass through the reads. Only for a\n"
+	"                                            single uncompressed file of single-end reads. Compressed\n"
+	"                                            (gz, bz2, zst) or paired reads are counted as without\n"
+	"                                            the option. A matching reads index skips the count anyway\n",
+
+help_io_uring =
+	"Read the compressed reads files (gzip, bzip2) through   False\n"
+	"                                            io_uring, keeping several 1 MB reads in flight ahead of\n"
+	"                                            the decompression of each processing thread. Can help on\n"
+	"                                            high latency e.g. network file systems, not on a local\n"
+	"                                            disk with the reads in the page cache. Linux only,\n"
+	"                                            falls back to the blocking reads if not available\n",
+
+help_no_wal =
+	"Do not write the key-value database Write Ahead Log.    False\n"
+	"                                            The alignment results are flushed to the database files\n"
+	"                                            at the end of each index part instead. Faster, but a\n"
+	"                                            crashed run has to restart the current index part\n",
+
+help_kvdb_mem =
+	"Keep the alignment results in memory instead of the     0\n"
+	"                                            key-value database, for the runs aligning and reporting\n"
+	"                                            in one go. INT is the memory limit in MB above which the\n"
+	"                                            results spill to the key-value database. 0 - no limit.\n"
+	"                                            The results are not kept for a later run to resume from\n",
+
+help_kvdb_profile =
+	"Key-value database tuning: default | bulk | small       default\n"
+	"                                            bulk: LZ4, large memtables, no WAL, bloom filters and a\n"
+	"                                                  single compaction after the alignment. Meant for\n"
+	"                                                  the write heavy alignment of large samples\n"
+	"                                            small: zstd, bloom filters. Trades CPU for a smaller\n"
+	"                                                   database. The gains depend on the data and disk\n",
+
+help_kvdb_ingest =
+	"Write the alignment results of each processing thread   False\n"
+	"                                            to sorted SST files, added to the key-value database at\n"
+	"                                            the end of each index part. Bypasses the memtables and\n"
+	"                                            most of the compaction. For very large samples\n",
+
+help_fused =
+	"Compute the %ID/%COV statistics, the OTU map and the    False\n"
+	"                                            reports during the alignment in a single pass through\n"
+	"                                            the reads. Only when the index is a single part,\n"
+	"                                            the reads are not streamed and not '--no_prescan'\n"
 //help_align =
 //    "Perform the alignment                                   False\n\n"
 //	"       Search a single best alignment per read\n\n",
@@ -521,9 +636,20 @@ public:
 	bool is_align = false;
 	bool is_filter = false;
     bool is_score_split = false;  // if true - calculate the SW score per split rather then for all reads
+	bool is_read_cache = false; // OPT_READ_CACHE cache reads on the first pass, replay on the following passes
+	bool is_prescan = true; // OPT_NO_PRESCAN if false - estimate the reads statistics instead of counting before the alignment
+	bool is_io_uring = false; // OPT_IO_URING read the compressed reads files asynchronously
+	bool is_wal = true; // OPT_NO_WAL if false - do not write the KVDB Write Ahead Log
+	bool is_kvdb_mem = false; // OPT_KVDB_MEM keep the alignment results in memory
+	uint64_t kvdb_mem_max = 0; // OPT_KVDB_MEM memory limit in bytes. 0 - no limit
+	KVDB_PROFILE kvdb_profile = KVDB_PROFILE::DEFAULT; // OPT_KVDB_PROFILE
+	bool is_kvdb_ingest = false; // OPT_KVDB_INGEST write the alignment results as SST files
+	bool is_fused = false; // OPT_FUSED post-processing and reports in the alignment pass
+	bool is_kvdb_resume = false; // KVDB directory is not empty - resume the alignment if it holds a journal of the same run. See 'Journal'
 
 	// Option derived Flags
 	bool is_as_percent = false; // derived from OPT_EDGES
+	bool is_cigar = true; // derived from the output options. False if no report needs CIGAR i.e. score-only SW. See 'validate'
 
 	// Other flags
 	bool exit_early = false; // TODO: has no action? Flag to exit processing when either the reads or the reference file is empty or not FASTA/FASTQ
@@ -551,6 +677,11 @@ public:
 
 	unsigned queue_size_max = 1000; // max number of Reads in the Read and Write queues. 10 works OK.
     uint64_t max_read_len = MAX_READ_LEN; // max allowed read len
+	uint64_t dedup_max = 0; // OPT_DEDUP max number of sequences in the duplicate reads cache. 0 - no dedup
+	int32_t xdrop = 0; // OPT_XDROP X-drop score for the ungapped prefilter. 0 - no prefilter
+	bool is_sw_prune = true; // OPT_NO_SW_PRUNE if false - no SW score upper bound pruning (see 'compute_lis_alignment')
+	bool is_skip_done = true; // OPT_NO_SKIP_DONE if false - the feed does not skip the done reads (see 'Readfeed::set_done')
+	unsigned num_chunks = 4; // OPT_CHUNKS number of read chunks per processing thread
 	/*
 	* 0 (false) | 1 (true) | -1 (not set)
 	* read.is_zip  zip_out  out_zip
@@ -587,6 +718,7 @@ public:
 	uint32_t seed_win_len = 18; // OPT_L seed lmer length
 	uint32_t interval = 1; // size of k-mer window shift. Default 1 is the min possible to generate max number of k-mers.
 	uint32_t max_pos = 10000;
+	bool is_index_rc = false; // OPT_INDEX_RC the index holds the reverse complement of the references too (see 'build_index')
 	// ~ END indexing options
 
 	std::vector<std::string> blastops; // [1]
@@ -679,8 +811,22 @@ private:
 	void opt_m(const std::string &val);
 	void opt_L(const std::string &val);
 	void opt_max_pos(const std::string &val);
+	void opt_index_rc(const std::string &val);
 	void opt_readfeed(const std::string& val);
 	void opt_score_split(const std::string& val);
+	void opt_dedup(const std::string& val);
+	void opt_xdrop(const std::string& val);
+	void opt_no_sw_prune(const std::string& val);
+	void opt_no_skip_done(const std::string& val);
+	void opt_read_cache(const std::string& val);
+	void opt_chunks(const std::string& val);
+	void opt_no_prescan(const std::string& val);
+	void opt_io_uring(const std::string& val);
+	void opt_no_wal(const std::string& val);
+	void opt_kvdb_mem(const std::string& val);
+	void opt_kvdb_profile(const std::string& val);
+	void opt_kvdb_ingest(const std::string& val);
+	void opt_fused(const std::string& val);
 	/*
 	 * true: 1,yes,Yes,Y,y,T,t, false: 0,No,NO,no,N,n,F,f
 	*/
@@ -715,7 +861,7 @@ private:
 	std::multimap<std::string, std::string> mopt;
 
 	// OPTIONS Map - specifies all possible options
-	const std::array<opt_6_tuple, 56> options = {
+	const std::array<opt_6_tuple, 70> options = {
 		std::make_tuple(OPT_REF,            "PATH",        COMMON,      true,  help_ref, &Runopts::opt_ref),
 		std::make_tuple(OPT_READS,          "PATH",        COMMON,      true,  help_reads, &Runopts::opt_reads),
 		//std::make_tuple(OPT_ALIGN,          "BOOL",        COMMON,      true,  help_align, &Runopts::opt_align),
@@ -761,6 +907,17 @@ private:
 		std::make_tuple(OPT_FULL_SEARCH,    "INT",         ADVANCED,    false, help_full_search, &Runopts::opt_full_search),
 		std::make_tuple(OPT_PID,            "BOOL",        ADVANCED,    false, help_pid, &Runopts::opt_pid),
 		std::make_tuple(OPT_A,              "INT",         ADVANCED,    false, help_a, &Runopts::opt_a),
+		std::make_tuple(OPT_DEDUP,          "INT",         ADVANCED,    false, help_dedup, &Runopts::opt_dedup),
+		std::make_tuple(OPT_XDROP,          "INT",         ADVANCED,    false, help_xdrop, &Runopts::opt_xdrop),
+		std::make_tuple(OPT_READ_CACHE,     "BOOL",        ADVANCED,    false, help_read_cache, &Runopts::opt_read_cache),
+		std::make_tuple(OPT_CHUNKS,         "INT",         ADVANCED,    false, help_chunks, &Runopts::opt_chunks),
+		std::make_tuple(OPT_NO_PRESCAN,     "BOOL",        ADVANCED,    false, help_no_prescan, &Runopts::opt_no_prescan),
+		std::make_tuple(OPT_IO_URING,       "BOOL",        ADVANCED,    false, help_io_uring, &Runopts::opt_io_uring),
+		std::make_tuple(OPT_NO_WAL,         "BOOL",        ADVANCED,    false, help_no_wal, &Runopts::opt_no_wal),
+		std::make_tuple(OPT_KVDB_MEM,       "INT",         ADVANCED,    false, help_kvdb_mem, &Runopts::opt_kvdb_mem),
+		std::make_tuple(OPT_KVDB_PROFILE,   "STR",         ADVANCED,    false, help_kvdb_profile, &Runopts::opt_kvdb_profile),
+		std::make_tuple(OPT_KVDB_INGEST,    "BOOL",        ADVANCED,    false, help_kvdb_ingest, &Runopts::opt_kvdb_ingest),
+		std::make_tuple(OPT_FUSED,          "BOOL",        ADVANCED,    false, help_fused, &Runopts::opt_fused),
 		std::make_tuple(OPT_THREADS,        "INT",         ADVANCED,    false, help_threads, &Runopts::opt_threads),
 		std::make_tuple(OPT_INDEX,          "INT",         INDEXING,    false, help_index, &Runopts::opt_index),
 		std::make_tuple(OPT_L,              "DOUBLE",      INDEXING,    false, help_L, &Runopts::opt_L),
@@ -768,11 +925,14 @@ private:
 		std::make_tuple(OPT_V,              "BOOL",        INDEXING,    false, help_v, &Runopts::opt_v),
 		std::make_tuple(OPT_INTERVAL,       "INT",         INDEXING,    false, help_interval, &Runopts::opt_interval),
 		std::make_tuple(OPT_MAX_POS,        "INT",         INDEXING,    false, help_max_pos, &Runopts::opt_max_pos),
+		std::make_tuple(OPT_INDEX_RC,       "BOOL",        INDEXING,    false, help_index_rc, &Runopts::opt_index_rc),
 		std::make_tuple(OPT_H,              "BOOL",        HELP,        false, help_h, &Runopts::opt_h),
 		std::make_tuple(OPT_VERSION,        "BOOL",        HELP,        false, help_version, &Runopts::opt_version),
 		std::make_tuple(OPT_DBG_PUT_DB,     "BOOL",        DEVELOPER,   false, help_dbg_put_db, &Runopts::opt_dbg_put_db),
 		std::make_tuple(OPT_CMD,            "BOOL",        DEVELOPER,   false, help_cmd, &Runopts::opt_cmd),
 		std::make_tuple(OPT_TASK,           "INT",         DEVELOPER,   false, help_task, &Runopts::opt_task),
+		std::make_tuple(OPT_NO_SW_PRUNE,    "BOOL",        DEVELOPER,   false, help_no_sw_prune, &Runopts::opt_no_sw_prune),
+		std::make_tuple(OPT_NO_SKIP_DONE,   "BOOL",        DEVELOPER,   false, help_no_skip_done, &Runopts::opt_no_skip_done),
 		std::make_tuple(OPT_DBG_LEVEL,      "INT",         DEVELOPER,   false, help_dbg_level, &Runopts::opt_dbg_level)
 		//std::make_tuple(OPT_THREP,          "INT:INT",     DEVELOPER,   false, help_threp, &Runopts::opt_threp)
 	};
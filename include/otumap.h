@@ -43,12 +43,20 @@ struct Readstats;
 class Readfeed;
 class References;
 class KeyValueDatabase;
+class Read;
+class ThreadPool;
 
 class OtuMap {
+	// read ID and the position of the read in the feed, see 'merge'
+	struct OtuRead {
+		std::size_t readfile_idx; // reads slot
+		std::size_t read_num; // number in the slot
+		std::string id;
+	};
 	// Clustering of reads around references by similarity i.e. {ref: [read, read, ...] , ref : [read, read...] , ...}
 	// calculated after alignment is done on all reads
 	//  TODO: Store in DB ? Can be very big.
-	std::vector<std::map<std::string, std::vector<std::string>>> mapv;
+	std::vector<std::map<std::string, std::vector<OtuRead>>> mapv;
 	//std::map<std::string, std::vector<std::string>> otu_map;
 	//          |_Ref_ID       |_Read_IDs
 public:
@@ -56,11 +64,12 @@ public:
 	uint64_t total_otu; // total count of OTU groups in otu_map
 public:
 	OtuMap(int numThreads=1);
-	void push(int idx, std::string& ref_seq_str, std::string& read_seq_str);
+	void push(int idx, std::string& ref_seq_str, std::string& read_seq_str, std::size_t readfile_idx, std::size_t read_num);
 	void merge();
 	void write();
 	void init(Runopts& opts);
 	size_t count_otu();
 };
 
-void fill_otu_map(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, Runopts& opts, bool is_write=true);
+unsigned push_otu(int id, OtuMap& otumap, Read& read, References& refs, Runopts& opts);
+void fill_otu_map(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts, bool is_write=true);
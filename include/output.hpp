@@ -54,8 +54,13 @@ struct Readstats;
 struct Runopts;
 class KeyValueDatabase;
 class Readfeed;
+class ThreadPool;
 
-void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, Runopts& opts);
+class Output;
+
+void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts);
+void report_reads(const uint32_t& id, std::vector<Read>& reads, References& refs, Refstats& refstats, Output& output, Runopts& opts);
+void closeReports(Readfeed& readfeed, Output& output, Runopts& opts);
 
 class Output {
 public:
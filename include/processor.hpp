@@ -45,6 +45,20 @@ struct Runopts;
 struct Index;
 struct Readstats;
 class KeyValueDatabase;
+class Output;
+class OtuMap;
+class ThreadPool;
 
-void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatabase& kvdb, Runopts& opts);
-void denovo_stats(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, Runopts& opts);
+/*
+ * '--fused' single pass: the post-alignment processing done by the alignment threads
+ * on each read while the read and the references are loaded
+ */
+struct FusedPass {
+	Output* output = nullptr; // write the reports. Null - no reports
+	OtuMap* otumap = nullptr; // fill the OTU groups. Null - no OTU map
+	bool is_denovo_stats = false; // classify the alignments by %ID and %COV
+};
+
+void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts, FusedPass* fused = nullptr);
+void align_fused(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts);
+void denovo_stats(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts);
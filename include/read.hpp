@@ -38,7 +38,9 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 #include <algorithm> // std::find_if
@@ -68,6 +70,21 @@ struct alignment_struct2
 	void clear();
 };
 
+/*
+ * Non-owning view of a read record 'read_id \n header \n sequence [\n quality]' as produced
+ * by 'Readfeed::next'. The fields point into the record string, which has to outlive the view.
+ */
+struct ReadView
+{
+	std::string_view id;
+	std::string_view header;
+	std::string_view sequence;
+	std::string_view quality; // empty for fasta
+
+	/* single memchr pass over the record. @return false if the record has too many lines */
+	bool parse(std::string_view rec);
+};
+
 /* 
  * 1. id_win_hits  std::vector<id_win> id_win_hits
  *	  array of positions of window hits on the reference sequence in given index/part.
@@ -83,8 +100,8 @@ class Read
 {
 public:
 	std::string id; // Read ID: combination 'readsfile-number_read-number' e.g. 0_0, 1_103, etc.
-	std::size_t read_num; // Read number in the reads file starting from 0
-	std::size_t readfile_idx; // index into Runopts::readfiles
+	std::size_t read_num; // Read number in the reads slot starting from 0
+	std::size_t readfile_idx; // reads slot index i.e. the ID prefix. See Readfeed::get_id_idx
 	bool isValid; // flags the record valid/non-valid
 	bool isEmpty; // flags the Read object is empty i.e. just a placeholder for copy assignment
 	bool is_too_short; // calculate for each reference file
@@ -95,6 +112,8 @@ public:
 	// store in database ------------>
 	unsigned lastIndex; // last index number this read was aligned against. Set in Processor::callback
 	unsigned lastPart; // last part number this read was aligned against.  Set in Processor::callback
+	bool is_part_hit; // 'is_hit' was set on the part 'lastIndex/lastPart' i.e. counted in Readstats::num_aligned
+	std::vector<uint16_t> part_db_moves; // Readstats::reads_matched_per_db decremented on the part 'lastIndex/lastPart' (and lastIndex incremented)
 	// matching results
 	unsigned c_yid_ycov; // count of alignments passing both ID + COV
 	unsigned n_yid_ncov; // count of alignments ID + !COV
@@ -152,6 +171,20 @@ public:
 	/* serialize to binary string to store in DB */
 	std::string toBinString(); 
 	bool load_db(KeyValueDatabase& kvdb);
+	bool load_db(KeyValueDatabase::Scanner& scanner);
+	/* the results in DB are of the index part or a later one i.e. stored by a run resumed from. See 'Journal' */
+	bool is_aligned_on(unsigned idx_num, unsigned idx_part) const;
+	/* re-apply the Readstats changes made by the alignment on the part 'lastIndex/lastPart' */
+	void replay_part_stats(std::atomic<uint64_t>& num_aligned, std::vector<uint64_t>& reads_matched_per_db) const;
+	/* key of this read in DB. See KeyValueDatabase::read_key */
+	std::string db_key() const;
+	/* deserialize from the binary string stored in DB. Stops the run on a record of another version or a corrupt one */
+	bool fromBinString(const std::string& bstr);
+	enum class RECORD { OK, VERSION, CORRUPT };
+	/* deserialize a non-empty record made by 'toBinString'. Does not stop the run, see 'fromBinString' */
+	RECORD decodeBinString(const std::string& bstr);
+	/* load a block of reads with a single DB lookup. See KeyValueDatabase::GET_BATCH */
+	static void load_db(KeyValueDatabase& kvdb, std::vector<Read>& reads);
 	void seqToIntStr();
 	void revIntStr();
 	/* convert isequence to alphabetic form i.e. to A,C,G,T,N */
@@ -170,4 +203,5 @@ public:
 	std::string getSeqId();
 	uint32_t hashKmer(uint32_t pos, uint32_t len);
 	bool from_string(std::string& readstr);
+	bool from_view(const ReadView& view);
 }; // ~class Read
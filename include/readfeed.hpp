@@ -44,6 +44,13 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include <filesystem>
 #include <memory>
 #include <cstdint>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "common.hpp"
 #include "izlib.hpp"
@@ -52,7 +59,9 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 
 /*
  * Per-thread slot for reading a byte-range chunk of a flat (non-gzipped) file.
- * Each slot holds an open ifstream seeked to bytes_start and reads up to bytes_end.
+ * The chunk is memory-mapped where possible: the lines are found with memchr in the mapping and handed out
+ * as views i.e. copied only into the read string. Otherwise an open ifstream seeked to bytes_start
+ * is read up to bytes_end through 'buf'.
  */
 struct FlatSlot {
     std::string file_path;
@@ -66,25 +75,44 @@ struct FlatSlot {
     std::vector<char> buf;
     size_t buf_pos = 0;
     size_t buf_len = 0;
+    std::string line_buf; // line read through 'buf', see 'getline(std::string_view&)'
+
+    // memory-mapped chunk, see 'map'
+    static constexpr size_t WILLNEED_SIZE = 1U << 23; // 8 MiB read-ahead
+    const char* map_data = nullptr; // mapping of [map_base, bytes_end)
+    uint64_t map_base = 0; // bytes_start rounded down to the page size
+    size_t map_len = 0;
+    size_t map_pos = 0; // start of the next line
+    size_t map_advised = 0; // end of the range given MADV_WILLNEED
 
     FlatSlot() : buf(BUF_SIZE) {}
+    FlatSlot(FlatSlot&&) = default; // only moved while not mapped i.e. on 'flat_slots.resize'
+    ~FlatSlot() { unmap(); }
 
     // Refill buf from ifs; returns false when chunk is exhausted
     bool fill_buf();
     // Returns RL_OK, RL_END, RL_ERR (from izlib.hpp)
     int getline(std::string& line);
+    // Same as above. The view is into the mapping or 'line_buf', valid until the next call
+    int getline(std::string_view& line);
+    /* map [bytes_start, bytes_end) of the file. @return false if not possible, the chunk is then read through 'ifs' */
+    bool map();
+    void unmap();
+    /* back to bytes_start */
+    void rewind();
 };
 
-// Opaque wrapper around rapidgzip::ParallelGzipReader — defined only in readfeed.cpp
-// to avoid pulling rapidgzip headers (and their non-inline constexpr LUTs) into every TU.
+// Opaque decoder of a compressed file (rapidgzip::ParallelGzipReader, indexed_bzip2::ParallelBZ2Reader, zstd)
+// — defined only in readfeed.cpp to avoid pulling rapidgzip headers (and their non-inline constexpr LUTs) into every TU.
 struct GzReaderImpl;
 // Custom deleter declared here but defined in readfeed.cpp so GCC never checks
 // sizeof(GzReaderImpl) in any other translation unit.
 struct GzReaderDeleter { void operator()(GzReaderImpl*) noexcept; };
 
 /*
- * Per-thread slot for reading a byte-range chunk of a gzipped file
- * using ParallelGzipReader (seekable parallel decompression).
+ * Per-thread slot for reading a byte-range chunk of a compressed file: gzip and BGZF
+ * using ParallelGzipReader, bzip2 using ParallelBZ2Reader, zstd frame by frame (seekable decompression).
+ * A slot may be empty (bytes_start == bytes_end) e.g. of a single frame zstd file, then it has no reader.
  */
 struct GzSlot {
     std::string file_path;
@@ -107,6 +135,119 @@ struct GzSlot {
     int getline(std::string& line);
 };
 
+/* identifies a reads file by size, modification time and a fingerprint of its first and last 64 KiB */
+struct FileId {
+	uint64_t size = 0;
+	int64_t  mtime = 0;
+	uint64_t fingerprint = 0;
+
+	FileId() = default;
+	explicit FileId(const std::filesystem::path& file);
+	bool operator==(const FileId& other) const {
+		return size == other.size && mtime == other.mtime && fingerprint == other.fingerprint;
+	}
+	bool operator!=(const FileId& other) const { return !(*this == other); }
+};
+
+/*
+ * Binary cache of the reads of a single slot (option '--read_cache'). Written on the first pass
+ * through the slot, then memory-mapped and replayed on the following passes (index parts, post-processing,
+ * reports) so that the original file is neither decompressed nor parsed again.
+ *
+ * File: [header][record]...
+ *   header: magic, version, source file size, mtime, fingerprint (see FileId), slot bytes_start, bytes_end,
+ *           number of records, is_complete
+ *   record: header_len, header, seq_len, num_exc, num_exc x [pos, char], 2-bit sequence, qual_len, quality
+ *           exceptions are the sequence positions not in 'ACGT' e.g. N or lower case.
+ */
+struct ReadCache {
+	enum class MODE { NONE, WRITE, READ };
+
+	static constexpr uint32_t MAGIC   = 0x43524D53; // 'SMRC'
+	static constexpr uint32_t VERSION = 2;
+	static constexpr size_t HEADER_SIZE = 4 + 4 + 8 + 8 + 8 + 8 + 8 + 8 + 1;
+
+	std::filesystem::path path;
+	MODE mode = MODE::NONE;
+	uint64_t num_reads = 0;
+
+	// WRITE
+	std::ofstream ofs;
+	std::string buf; // encoded record
+
+	// READ
+	const char* data = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+	std::vector<char> mem; // file content when no mmap is available
+
+	ReadCache() = default;
+	ReadCache(ReadCache&&) = default; // only moved while closed i.e. on 'read_caches.resize'
+	~ReadCache() { close(); }
+
+	/* open the existing cache if complete and made for the given source and byte range */
+	bool open_read(const FileId& src, uint64_t bytes_start, uint64_t bytes_end);
+	void open_write(const FileId& src, uint64_t bytes_start, uint64_t bytes_end);
+	void put(std::string_view header, std::string_view sequence, std::string_view quality);
+	/* mark the cache complete i.e. usable by the next pass, and close */
+	void finish();
+	/* append the next 'header \n sequence [\n quality]' to the readstr. @return false at the end of cache */
+	bool get(std::string& readstr) { return get(pos, readstr); }
+	/* move past the next record without decoding it. @return false at the end of cache */
+	bool skip() { return skip(pos); }
+	/* as above from the offset 'at', moved past the record. Several readers can share the open cache */
+	bool get(size_t& at, std::string& readstr) const;
+	bool skip(size_t& at) const;
+	void close();
+};
+
+/*
+ * Sidecar index of an original reads file (INDEXED feed), stored in the reads DB directory as 'readindex_<hash>.bin',
+ * plus the decoder seek points in 'readindex_<hash>.gzi' for compressed files. Lets a run on an already seen file
+ * skip the pre-scan (read counting and chunking) and seek in the compressed file without decompressing up to the chunk.
+ * The file is matched by its FileId.
+ *
+ * File: magic, version, file_size, mtime, fingerprint, lines_per_record, num_reads, length_all, min_len, max_len,
+ *       num_records, recs_per_checkpoint, num_checkpoints, checkpoints
+ */
+struct ReadIndex {
+	static constexpr uint32_t MAGIC   = 0x49524D53; // 'SMRI'
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint64_t MAX_CHECKPOINTS = 1U << 16;
+
+	std::filesystem::path path; // sidecar
+	std::filesystem::path readfile;
+	FileId file_id;
+	uint32_t lines_per_record = 0;
+
+	// read statistics as calculated by 'count_reads_parallel'
+	uint64_t num_reads = 0;
+	uint64_t length_all = 0;
+	uint32_t min_len = 0;
+	uint32_t max_len = 0;
+
+	uint64_t num_records = 0; // number of complete records i.e. num lines / lines_per_record
+	uint64_t recs_per_checkpoint = 1;
+	std::vector<uint64_t> checkpoints; // byte offset (decompressed) of record 'i x recs_per_checkpoint'. Last: end of data
+	bool is_loaded = false;
+
+	/* identify the reads file, see FileId */
+	void init(const std::filesystem::path& basedir, const std::filesystem::path& readfile, uint32_t lines_per_record);
+	/* @return true if the sidecar exists and was made for the same reads file */
+	bool load();
+	void store();
+	/* 
+	 * @param newline_ends  offset after every newline in the file
+	 * @param rec_unit      checkpoint granularity in records e.g. 2 for interleaved pairs
+	 */
+	void set_checkpoints(const std::vector<uint64_t>& newline_ends, uint64_t rec_unit);
+	/* start record of the chunk 'i' of 'num_chunks'. Aligned to the checkpoints, 'num_records' for i == num_chunks */
+	uint64_t chunk_start(uint64_t i, uint64_t num_chunks) const;
+	/* byte offset of the record 'rec' as returned by 'chunk_start' */
+	uint64_t offset(uint64_t rec) const;
+	std::filesystem::path gz_index_path() const { return std::filesystem::path(path).replace_extension(".gzi"); }
+};
+
  // forward
 class Read;
 class KeyValueDatabase;
@@ -118,10 +259,24 @@ struct Runopts;
 class Readfeed {
 public:
 	Readfeed(FEED_TYPE type, std::vector<std::string>& readfiles, std::filesystem::path& basedir, bool is_paired);
-	Readfeed(FEED_TYPE type, std::vector<std::string>& readfiles, const unsigned num_parts, std::filesystem::path& basedir, bool is_paired);
+	/*
+	 * @param num_parts  number of processing threads
+	 * @param chunks_per_part  INDEXED: number of read chunks per processing thread, see 'next_chunk'
+	 * @param is_prescan  if false - estimate the read statistics where possible, see 'estimate_reads'
+	 * @param is_io_uring  read the compressed files through io_uring where available
+	 */
+	Readfeed(FEED_TYPE type, std::vector<std::string>& readfiles, const unsigned num_parts, std::filesystem::path& basedir, 
+		bool is_paired, const unsigned chunks_per_part = 1, const bool is_prescan = true, const bool is_io_uring = false);
+	~Readfeed();
 
 	void run();
 	bool next(int inext, std::string& readstr);
+	/*
+	 * claim the next unprocessed chunk of reads. Each chunk is handed out once per pass (until 'rewind_in').
+	 * The chunk's streams are 'chunk * num_sense' (+1 for REV) and are read only by the claiming thread.
+	 * @return false when all chunks have been claimed
+	 */
+	bool next_chunk(unsigned& chunk);
 	void reset();
 	void rewind();
 	void rewind_in();
@@ -132,7 +287,7 @@ public:
 	//void init_vstate_in();
 	bool split();
 	/*
-     * - define input files format (FASTA, FASTQ) and compression (gz, non-gz)
+     * - define input files format (FASTA, FASTQ) and compression (gzip, BGZF, bzip2, zstd, flat)
      * - test reading by getting one read
      *
      * logic:
@@ -140,12 +295,22 @@ public:
    	 *    1F 8B 08 08 61 78 C5 5E 00 03 53 52 52 31 36 33 35 38 36 34 5F 31 5F 35 4B 2E 66 61 73 74 71 00
    	 *     0 byte at 8th position_|  |  |_file name starts in ASCII                   file name end_|  |_ 0 byte
    	 *                      ETX byte_|
+   	 *   BGZF:  gz with the extra field 'BC' at offset 12
+   	 *   bzip2: 'BZh'
+   	 *   zstd:  28 B5 2F FD
    	 * flat:
    	 *   first 100 bytes are ascii (<=127 x7F), first char is '@' (x40), and can infer fasta or fastq
     */
 	bool define_format(const int& dbg = 0);
 	void count_reads();
 	void count_reads_parallel();
+	/*
+	 * estimate the read statistics (num_reads_tot, length_all, min/max_read_len) from the first 'SAMPLE_SIZE' bytes
+	 * instead of counting all the reads. Single uncompressed single-end file only, where the chunks are cut by size.
+	 * The exact statistics are counted on the first pass, see 'reconcile_counts'
+	 */
+	void estimate_reads();
+	static constexpr uint64_t SAMPLE_SIZE = 1U << 22; // 4 MiB
 	void write_descriptor();
 	/*
      * verify the split was already performed and the feed is ready
@@ -173,6 +338,24 @@ public:
 	* @return  count of deleted split files
 	*/
 	int clean();
+	/*
+	 * flag the read done i.e. all its alignments were found. While 'is_skip_done' is set
+	 * the following passes skip the read in 'next' without returning it.
+	 * Called only by the thread consuming the slot the read came from, hence no locking.
+	 * Stream: under 'stream_lock' as the bits are shared by the chunks replaying the spool.
+	 *
+	 * @param readfile_idx, read_num  as in the read ID 'readfile_idx_read_num'
+	 */
+	void set_done(std::size_t readfile_idx, std::size_t read_num);
+	/* count of reads skipped by 'next' as done, all slots */
+	uint64_t get_num_skipped_done();
+	/*
+	 * replace the estimated read statistics with the ones counted on the first pass through the reads.
+	 * @return true if replaced, false if not estimated or the first pass is not complete yet
+	 */
+	bool reconcile_counts();
+	/* '-' (stdin) or a named pipe i.e. the reads can be read only once, see 'init_stream' */
+	static bool is_stream_path(const std::string& path);
 	static bool hasnext(std::ifstream& ifs);
 	static bool loadReadByIdx(Read& read);
 	static bool loadReadById(Read& read);
@@ -214,6 +397,24 @@ private:
      */
 	bool next_flat(int inext, std::string& readstr, bool is_orig);
 	/*
+     * Read next record from the read cache of the slot. Same format as next_gz()
+     */
+	bool next_cached(int inext, int slot_idx, std::string& readstr);
+	/* slot holding the reader of the stream 'inext'. Interleaved paired: REV shares the FWD slot */
+	int get_slot_idx(int inext);
+	/*
+	 * first part of the read ID. Interleaved paired gz: FWD/REV by the record number in the slot,
+	 * so that the ID does not depend on which of the two streams the caller asked for.
+	 */
+	int get_id_idx(int inext, int slot_idx);
+	/*
+     * Open the read cache of the slot for reading if complete, otherwise for writing.
+     * @return true if the cache is replayed i.e. the original file is not needed for the slot
+     */
+	bool init_read_cache(std::size_t slot_idx, const std::string& file_path, uint64_t bytes_start, uint64_t bytes_end);
+	/* store the record produced by next_gz/next_flat in the read cache of the slot */
+	void put_read_cache(int slot_idx, const std::string& readstr);
+	/*
      * Pass-1 scan of every orig gz file to compute per-slot byte boundaries.
      * Populates gz_slots[].bytes_start/end and gz_slot_files[].numreads.
      */
@@ -223,6 +424,38 @@ private:
      * Populates flat_slots[].bytes_start/end and flat_slot_files[].numreads.
      */
 	void build_flat_chunk_offsets();
+	/*
+	 * load the reads index of every original file (see ReadIndex) and set the read counts and lengths from it.
+	 * @return false if any of the files has no valid index i.e. the pre-scan is necessary
+	 */
+	bool load_read_index();
+	/* store the reads index of the files that were scanned */
+	void store_read_index();
+	/* record-aligned byte ranges of a flat file, found by seeking i.e. without reading the file */
+	std::vector<uint64_t> split_by_bytes(const Readfile& file, size_t num_parts);
+	/* count the read returned on the first pass when estimated */
+	void count_slot(int slot_idx, bool is_next, const std::string& readstr);
+	/*
+	 * streaming input: detect the format and estimate the read statistics from the first 'SAMPLE_SIZE' bytes.
+	 * The records are parsed by a single producer thread ('stream_run') and handed to the processors through
+	 * a bounded queue. Each processing thread claims one chunk, and takes the records from the queue
+	 * until the end of the stream. When the reads are needed by more than one pass ('is_spool') the first pass
+	 * stores them in the read cache format, and the following passes replay the cache. The replay gives each chunk
+	 * a contiguous range of the records like a reads file, so that the per-thread reports merge into the stream order.
+	 */
+	void init_stream();
+	/* split the spooled stream into the chunk ranges for the replaying passes. Under 'stream_lock' */
+	void init_stream_replay();
+	/* producer of the stream queue for the current pass */
+	void stream_run();
+	/* join the producer of the previous pass */
+	void stream_join();
+	/* read the next record 'header \n sequence [\n quality]' from the input stream. @return false at the end */
+	bool read_stream(std::string& readstr);
+	/* next line of the input stream, starting with the sample taken by 'init_stream' */
+	bool stream_getline(std::string& line);
+	/* pop the next record from the stream queue, or the replayed range, for the chunk of the stream 'inext' */
+	bool next_stream(int inext, std::string& readstr);
 
 public:
 	FEED_TYPE type;
@@ -233,12 +466,22 @@ public:
 	bool is_paired;
 	unsigned num_orig_files;  // number of original reads files
 	unsigned num_splits;  // equals number of processing threads as specified by '-threads' option
+	unsigned num_chunks;  // number of read chunks (slots per sense). INDEXED: num_splits x chunks_per_split, otherwise num_splits
+	unsigned chunks_per_split;  // chunks [id x chunks_per_split, (id + 1) x chunks_per_split) are in the order of the reads file
 	unsigned num_split_files;  // for paired reads there are 2 types of split files: FWD and REV.
 	uint32_t num_sense;  // number of read's senses (fwd/rev) i.e. max 2
 	uint64_t num_reads_tot;  // count of reads in all streams
 	uint64_t length_all;  // length of all reads from all files
 	uint32_t min_read_len;
 	uint32_t max_read_len;
+	bool is_read_cache; // OPT_READ_CACHE cache the reads on the first pass and replay on the next passes
+	bool is_skip_done; // skip the reads flagged with 'set_done'. Only during the alignment
+	bool is_prescan; // count the reads before processing. See 'estimate_reads'
+	bool is_io_uring; // OPT_IO_URING compressed files are read through io_uring
+	bool is_estimated; // num_reads_tot, length_all, min/max_read_len are estimates until 'reconcile_counts'
+	bool is_stream; // the reads come from stdin or a named pipe, see 'init_stream'
+	bool is_spool; // stream: keep a copy of the reads for the following passes. Not needed for a single pass
+	bool is_stream_replay; // stream: the current pass replays the spool in the chunk ranges i.e. in the stream order. Set by 'init_reading'
 	std::filesystem::path& basedir; // root directory for split files (opts.readb)
 	std::vector<Readfile> orig_files;
 private:
@@ -256,6 +499,60 @@ private:
 	std::vector<FlatSlot>  flat_slots;      // [thread_0_fwd, thread_0_rev, thread_1_fwd, ...]
 	std::vector<Readfile>  flat_slot_files; // metadata parallel to flat_slots
 
+	std::atomic<unsigned> chunk_next; // next chunk to be claimed, see 'next_chunk'
+
+	// read cache (INDEXED) - one per slot, see 'is_read_cache'
+	std::vector<ReadCache> read_caches;
+
+	// reads index (INDEXED) - one per original file
+	std::vector<ReadIndex> read_index;
+
+	// done reads (INDEXED) - bit per read number in the slot, see 'set_done'
+	std::vector<std::vector<uint64_t>> done_bits;
+	std::vector<uint64_t> num_skipped_done; // per slot
+
+	// read statistics counted per slot on the first pass when 'is_estimated'
+	struct SlotCount {
+		uint64_t num_reads = 0;
+		uint64_t length = 0;
+		uint32_t min_len = 0;
+		uint32_t max_len = 0;
+		bool is_done = false;
+	};
+	std::vector<SlotCount> slot_counts;
+
+	// streaming input - one producer, processors take the records from the queue
+	struct StreamRec {
+		std::string fwd;
+		std::string rev; // paired: the mate is kept with the FWD so that both go to the same processor
+	};
+	static constexpr size_t STREAM_QUEUE_MAX = 1U << 12; // records
+	std::ifstream stream_ifs;
+	std::istream* stream_in = nullptr;
+	std::string stream_sample; // start of the stream read by 'init_stream'
+	size_t stream_sample_pos = 0;
+	std::string stream_header; // FASTA: header of the next record, read with the previous one
+	bool is_stream_read = false; // the input stream is consumed, the following passes replay 'stream_spool'
+	ReadCache stream_spool;
+	std::thread stream_thread;
+	std::mutex stream_lock;
+	std::condition_variable stream_cv_put;
+	std::condition_variable stream_cv_get;
+	std::deque<StreamRec> stream_queue;
+	bool is_stream_started = false; // producer started, or the replay set up, for the current pass
+	bool is_stream_end = false; // producer done with the current pass
+	bool is_stream_abort = false; // stop the producer, see '~Readfeed'
+	std::vector<std::string> stream_pending; // per chunk: REV of the last popped pair
+	// replay of 'stream_spool' per chunk: the records from 'rec_start' at the offsets [start, end)
+	struct StreamRange {
+		size_t start = 0;
+		size_t end = 0;
+		size_t pos = 0;
+		uint64_t rec_start = 0;
+		uint64_t rec = 0;
+	};
+	std::vector<StreamRange> stream_ranges;
+
     // used by all types of readfeed
 	std::vector<Readstate> vstate_in;
 
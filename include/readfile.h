@@ -33,12 +33,17 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <filesystem>
+#include <cstdint>
+
+// compression of a reads file, by the magic bytes. See 'Readfeed::define_format'
+enum class COMPRESSION : uint8_t { NONE, GZIP, BGZF, BZIP2, ZSTD };
 
 struct Readfile {
-	Readfile() : isFastq(false), isFasta(false), isZip(false), numreads(0), size(0) {}
+	Readfile() : isFastq(false), isFasta(false), isZip(false), codec(COMPRESSION::NONE), numreads(0), size(0) {}
 	bool isFastq; // file is FASTQ
 	bool isFasta; // file is FASTA
 	bool isZip;   // true (compressed) | false (flat)
+	COMPRESSION codec; // isZip: decoder of the file
 	unsigned numreads;  // max reads expected to be processed
 	std::filesystem::path path;
 	std::streampos size;
@@ -80,12 +80,20 @@ struct Readstats
 	std::atomic<uint64_t> n_yid_ycov; // [2] SW + ID + COV i.e. aligned passing ID, passing COV
 	std::atomic<uint64_t> num_denovo; // [4] SW - ID - COV i.e. 'de novo' reads, aligned failing ID, failing COV
 	std::atomic<uint64_t> num_short; // count of reads shorter than a threshold of N nucleotides. Reset for each index.
+	std::atomic<uint64_t> num_dedup_lookup; // reads looked up in the duplicate reads cache (see 'AlignCache')
+	std::atomic<uint64_t> num_dedup_hit; // reads that reused the alignment of an identical read
+	std::atomic<uint64_t> num_sw; // SW alignments performed. NO DB store.
+	std::atomic<uint64_t> num_sw_pruned; // SW skipped: score upper bound cannot enter the results. NO DB store.
+	std::atomic<uint64_t> num_sw_pruned_best; // SW score-only: score upper bound is below the kept alignments ('--best'). NO DB store.
+	std::atomic<uint64_t> num_sw_xdrop; // SW skipped: rejected by the ungapped X-drop prefilter. NO DB store.
 
 	std::vector<uint64_t> reads_matched_per_db; // [3] reads matched per database.
     //              |_TODO: should be atomic std::atomic<uint64_t> 20201019
 
 	bool is_stats_calc; // flags 'computeStats' was called.
 	bool is_set_aligned_id_cov; // flag 'total_aligned_id_cov' was calculated (so no need to calculate no more)
+	bool is_cigar; // the alignments in KVDB have CIGAR i.e. were not computed score-only (see 'Runopts::is_cigar')
+	uint8_t kvdb_format; // 'KeyValueDatabase::FORMAT_VERSION' of the KVDB the statistics were restored from
 
 	Readstats(uint64_t all_reads_count, uint64_t all_reads_len, uint32_t min_read_len, uint32_t max_read_len, KeyValueDatabase& kvdb, Runopts& opts);
 
@@ -95,4 +103,6 @@ struct Readstats
 	bool restoreFromDb(KeyValueDatabase & kvdb);
 	void store_to_db(KeyValueDatabase & kvdb);
 	void set_is_set_aligned_id_cov();
+	/* exit if the alignments in KVDB have no CIGAR, which 'what' needs e.g. a later '-task 2' with a SAM report */
+	void check_cigar(const std::string& what, Runopts& opts);
 }; // ~struct Readstats
@@ -70,6 +70,8 @@ public:
 	uint32_t min_read_len;
 	uint32_t max_read_len;
 	uint64_t all_reads_len;
+	uint64_t num_dedup_lookup; // reads looked up in the duplicate reads cache
+	uint64_t num_dedup_hit; // duplicate reads that reused a cached alignment
 	std::vector<std::pair<std::string, float>> db_matches;
 
 	// methods
@@ -0,0 +1,143 @@
+# @copyright 2016-2026 Clarity Genomics BVBA
+# @copyright 2012-2016 Bonsai Bioinformatics Research Group
+# @copyright 2014-2016 Knight Lab, Department of Pediatrics, UCSD, La Jolla
+#
+# SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+#
+# This is a free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# SortMeRNA is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+
+'''
+file: bench.py
+
+Compare the run time and the key-value database size of sortmerna option variants
+on the same inputs. The reports of all the variants have to be identical.
+
+  python scripts/bench.py kvdb --smr-exe dist/bin/sortmerna
+  python scripts/bench.py kvdb --smr-exe dist/bin/sortmerna -r 3 -t 8 \\
+      --ref data/set7_arc_bac_16S_database_match.fasta --reads data/set4_mate_pairs_metatranscriptomics_1.fastq
+  python scripts/bench.py io_uring --smr-exe dist/bin/sortmerna --cold --reads /mnt/nfs/reads.fq.gz
+
+The index is built once in WORKDIR/idx and shared by all the runs. Each run starts
+with an empty key-value database. The time is the median wall time of the repeats.
+'--cold' drops the reads files from the page cache before each run, so that the reads
+come from the disk or the network file system, which is what '--io_uring' is about.
+'''
+
+import os
+import sys
+import shutil
+import statistics
+import subprocess
+import time
+import filecmp
+from argparse import ArgumentParser
+from pathlib import Path
+
+SMR_SRC = Path(__file__).resolve().parent.parent
+DATA_DIR = SMR_SRC / 'data'
+REF = DATA_DIR / 'set7_arc_bac_16S_database_match.fasta'
+READS = DATA_DIR / 'set4_mate_pairs_metatranscriptomics_1.fastq'
+READS_GZ = DATA_DIR / 'set4_mate_pairs_metatranscriptomics_1.fastq.gz'
+REPORTS = ['aligned.blast', 'aligned.fq', 'other.fq']
+
+def dir_size(path:Path) -> int:
+    return sum(f.stat().st_size for f in path.rglob('*') if f.is_file()) if path.exists() else 0
+
+def drop_cache(files:list):
+    '''
+    evict the files from the page cache. Linux only, a no-op elsewhere
+    '''
+    if not hasattr(os, 'posix_fadvise'):
+        return
+    for path in files:
+        fd = os.open(path, os.O_RDONLY)
+        try:
+            os.posix_fadvise(fd, 0, 0, os.POSIX_FADV_DONTNEED)
+        finally:
+            os.close(fd)
+
+def run_variant(smr:str, name:str, opts:list, args) -> dict:
+    '''
+    run sortmerna 'args.repeat' times with the given extra options
+    @return  median time, DB size, output dir of the last run
+    '''
+    workdir = Path(args.workdir)
+    rundir = workdir / name
+    cmd = [smr, '-ref', str(args.ref), '-threads', str(args.threads),
+           '-workdir', str(rundir), '-idx-dir', str(workdir / 'idx'),
+           '-fastx', '-other', '-blast', '1'] + opts
+    for reads in args.reads:
+        cmd += ['-reads', str(reads)]
+    times = []
+    for _ in range(args.repeat):
+        shutil.rmtree(rundir, ignore_errors=True)
+        if args.cold:
+            drop_cache(args.reads)
+        start = time.perf_counter()
+        with open(workdir / f'{name}.log', 'w') as log:
+            ret = subprocess.run(cmd, stdout=log, stderr=subprocess.STDOUT)
+        times.append(time.perf_counter() - start)
+        if ret.returncode != 0:
+            print(f'{name}: sortmerna failed with {ret.returncode}. See {workdir / name}.log')
+            sys.exit(1)
+    return {'time': statistics.median(times), 'kvdb': dir_size(rundir / 'kvdb'), 'out': rundir / 'out'}
+
+def bench(variants:list, args):
+    '''
+    run the variants and print the table. The first variant is the baseline
+    '''
+    smr = args.smr_exe or shutil.which('sortmerna')
+    if not smr:
+        print('sortmerna executable not found. Use --smr-exe or add it to the PATH')
+        sys.exit(1)
+    Path(args.workdir).mkdir(parents=True, exist_ok=True)
+    results = {}
+    for name, opts in variants:
+        results[name] = run_variant(smr, name, opts, args)
+        print(f'{name:<12} {results[name]["time"]:8.2f} sec  kvdb {results[name]["kvdb"] / 2**20:8.2f} MB', flush=True)
+
+    base, base_res = variants[0][0], results[variants[0][0]]
+    is_same = True
+    for name, res in results.items():
+        if name == base:
+            continue
+        for report in REPORTS:
+            f0, f1 = base_res['out'] / report, res['out'] / report
+            if f0.exists() and not (f1.exists() and filecmp.cmp(f0, f1, shallow=False)):
+                print(f'{name}: {report} differs from {base}')
+                is_same = False
+        print(f'{name:<12} time x{base_res["time"] / res["time"]:.2f} vs {base}'
+              + (f'  kvdb x{res["kvdb"] / base_res["kvdb"]:.2f}' if base_res['kvdb'] else ''))
+    sys.exit(0 if is_same else 1)
+
+if __name__ == '__main__':
+    parser = ArgumentParser()
+    subpar = parser.add_subparsers(dest='cmd', required=True)
+    pkv = subpar.add_parser('kvdb', help="'--kvdb_profile' default, bulk, small")
+    pio = subpar.add_parser('io_uring', help="blocking reads vs '--io_uring' on compressed reads")
+    for p in [pkv, pio]:
+        p.add_argument('--smr-exe', dest='smr_exe', help='path to sortmerna executable')
+        p.add_argument('--ref', default=REF, help='reference file')
+        p.add_argument('--reads', action='append', help='reads file. Twice for paired files')
+        p.add_argument('-t', '--threads', type=int, default=os.cpu_count(), help='number of threads')
+        p.add_argument('-r', '--repeat', type=int, default=1, help='runs of each variant')
+        p.add_argument('-w', '--workdir', default=Path.home() / 'sortmerna' / 'bench', help='working directory')
+        p.add_argument('--cold', action='store_true', help='drop the reads from the page cache before each run')
+    args = parser.parse_args()
+    args.reads = args.reads or [READS_GZ if args.cmd == 'io_uring' else READS]
+
+    if args.cmd == 'kvdb':
+        bench([(profile, ['-kvdb_profile', profile]) for profile in ['default', 'bulk', 'small']], args)
+    elif args.cmd == 'io_uring':
+        bench([('blocking', []), ('io_uring', ['-io_uring'])], args)
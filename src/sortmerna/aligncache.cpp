@@ -0,0 +1,93 @@
+/*
+@copyright 2016-2026 Clarity Genomics BVBA
+@copyright 2012-2016 Bonsai Bioinformatics Research Group
+@copyright 2014-2016 Knight Lab, Department of Pediatrics, UCSD, La Jolla
+
+@parblock
+SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+
+This is a free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SortMeRNA is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+@endparblock
+
+@contributors Jenya Kopylova   jenya.kopylov@gmail.com
+              Laurent Noé      laurent.noe@lifl.fr
+              Pierre Pericard  pierre.pericard@lifl.fr
+              Daniel McDonald  wasade@gmail.com
+              Mikaël Salson    mikael.salson@lifl.fr
+              Hélène Touzet    helene.touzet@lifl.fr
+              Rob Knight       robknight@ucsd.edu
+              biocodz          biocodz@protonmail.com
+*/
+
+/*
+ * FILE: aligncache.cpp
+ * Created: Oct 19, 2026 Mon
+ */
+
+#include <functional> // std::hash
+
+#include "aligncache.hpp"
+
+AlignCache::AlignCache(size_t max_size, unsigned num_shards)
+	:
+	num_lookup(0),
+	num_hit(0),
+	max_size(max_size),
+	max_shard_size(max_size / num_shards + 1),
+	shards(num_shards)
+{}
+
+AlignCache::Shard& AlignCache::get_shard(const std::string& seq)
+{
+	return shards[std::hash<std::string>{}(seq) % shards.size()];
+}
+
+/*
+ * thread safe
+ * @return true if the sequence was found. The entry is then copied into 'entry'
+ */
+bool AlignCache::find(const std::string& seq, Entry& entry)
+{
+	if (max_size == 0) return false;
+	num_lookup.fetch_add(1, std::memory_order_relaxed);
+	auto& shard = get_shard(seq);
+	std::lock_guard<std::mutex> lmx(shard.mx);
+	auto it = shard.map.find(seq);
+	if (it == shard.map.end())
+		return false;
+	entry = it->second;
+	num_hit.fetch_add(1, std::memory_order_relaxed);
+	return true;
+} // ~AlignCache::find
+
+/*
+ * thread safe. Bounded - the sequence is not added if its shard is full.
+ * The first entry wins if two threads align the same sequence concurrently.
+ */
+void AlignCache::put(const std::string& seq, Entry entry)
+{
+	if (max_size == 0) return;
+	auto& shard = get_shard(seq);
+	std::lock_guard<std::mutex> lmx(shard.mx);
+	if (shard.map.size() < max_shard_size)
+		shard.map.emplace(seq, std::move(entry));
+} // ~AlignCache::put
+
+void AlignCache::clear()
+{
+	for (auto& shard : shards) {
+		std::lock_guard<std::mutex> lmx(shard.mx);
+		shard.map.clear();
+	}
+} // ~AlignCache::clear
@@ -97,6 +97,55 @@ void find_lis( deque<pair<uint32_t, uint32_t>>& a, vector<uint32_t>& b )
 		b[u] = static_cast<uint32_t>(v);
 } // ~find_lis
 
+/*
+ * ungapped X-drop extension along the diagonal of a seed i.e. no profile, no DP matrix.
+ * Extends to the right and to the left of the seed start until the running score drops 
+ * more than 'xdrop' below the best score seen in that direction.
+ *
+ * @param que  read sequence in 04 alphabet
+ * @param ref  reference sequence
+ * @param que_beg, que_end  read segment to consider [que_beg, que_end)
+ * @param que_seed  seed start position on the read
+ * @param diag  seed position on reference minus seed position on the read
+ * @param mat  scoring matrix 5x5 see 'Read::initScoringMatrix'
+ * @return pair<score, length> of the best ungapped segment through the seed start
+ */
+std::pair<int32_t, uint32_t> xdrop_ungapped(const std::string& que, const std::string& ref, 
+	uint32_t que_beg, uint32_t que_end, uint32_t que_seed, int64_t diag, const int8_t* mat, int32_t xdrop)
+{
+	int32_t score = 0;
+	int32_t best_r = 0;
+	int32_t best_l = 0;
+	uint32_t len_r = 0;
+	uint32_t len_l = 0;
+	int64_t reflen = static_cast<int64_t>(ref.length());
+
+	// right including the seed start
+	for (uint32_t q = que_seed; q < que_end && q + diag < reflen; ++q)
+	{
+		score += mat[que[q] * 5 + ref[q + diag]];
+		if (score > best_r) {
+			best_r = score;
+			len_r = q - que_seed + 1;
+		}
+		else if (best_r - score > xdrop) break;
+	}
+
+	// left
+	score = 0;
+	for (uint32_t q = que_seed; q > que_beg && static_cast<int64_t>(q) - 1 + diag >= 0; --q)
+	{
+		score += mat[que[q - 1] * 5 + ref[q - 1 + diag]];
+		if (score > best_l) {
+			best_l = score;
+			len_l = que_seed - q + 1;
+		}
+		else if (best_l - score > xdrop) break;
+	}
+
+	return { best_r + best_l, len_r + len_l };
+} // ~xdrop_ungapped
+
 void compute_lis_alignment( Read& read, Runopts& opts,
 							Index& index, References& refs, 
 							Readstats& readstats, Refstats& refstats,
@@ -114,6 +163,11 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 	uint32_t max_ref = 0; // reference with max kmer occurrences
 	uint32_t max_occur = 0; // number of kmer occurrences on the 'max_ref'
 
+	// '--index_rc': the hits on the reverse complement of a reference (SEQ_POS_RC) are a candidate of
+	// their own, aligned with the reversed read. The '-F' / '-R' strand is kept only
+	bool is_rc_searched = opts.is_index_rc && !(opts.is_forward && !opts.is_reverse);
+	bool is_fwd_searched = !(opts.is_index_rc && opts.is_reverse && !opts.is_forward);
+
 	// 1. For each candidate reference compute the number of kmer hits belonging to it
 	for (auto const& hit: read.id_win_hits)
 	{
@@ -122,6 +176,8 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 		for (uint32_t j = 0; j < index.positions_tbl[hit.id].size; j++)
 		{
 			uint32_t seq = positions_tbl_ptr++->seq;
+			if ((seq & SEQ_POS_RC) ? !is_rc_searched : !is_fwd_searched)
+				continue;
 			if ((map_it = refs_kmer_count_map.find(seq)) != refs_kmer_count_map.end())
 				map_it->second++; // sequence already in the map, increment its frequency value
 			else
@@ -151,7 +207,9 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 	auto is_search_candidates = true;
 	for (uint32_t k = 0; k < refs_kmer_count_vec.size() && is_search_candidates; k++)
 	{
-		max_ref = refs_kmer_count_vec[k].first;
+		auto candidate = refs_kmer_count_vec[k].first; // the reference | SEQ_POS_RC
+		bool is_rc = candidate & SEQ_POS_RC;
+		max_ref = candidate & ~SEQ_POS_RC;
 		max_occur = refs_kmer_count_vec[k].second;
               
 		// not enough hits on the reference, try to collect more hits or next read
@@ -185,9 +243,11 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 			// loop through every position of id
 			for (uint32_t j = 0; j < num_hits; j++)
 			{
-				if (positions_tbl_ptr->seq == max_ref)
+				if (positions_tbl_ptr->seq == candidate)
 				{
-					hits_on_ref.push_back(uint32pair(positions_tbl_ptr->pos, hit.win));
+					// the window on the reversed read, see 'seq_pos'
+					auto win = is_rc ? read.sequence.length() - hit.win - refstats.lnwin[index.index_num] : hit.win;
+					hits_on_ref.push_back(uint32pair(positions_tbl_ptr->pos, win));
 				}
 				positions_tbl_ptr++;
 			}
@@ -200,6 +260,10 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 			return (e1.first ASCENDING e2.first);
 		}); // smallest
 
+		// '--index_rc': align the read on the strand of the hits
+		if (opts.is_index_rc && is_rc != read.reversed)
+			read.revIntStr();
+
 		// iterate over the set of hits, searching for windows of
 		// win.len == read.len which have at least ratio hits
 		vector<uint32pair>::iterator hits_on_ref_iter = hits_on_ref.begin();
@@ -356,33 +420,79 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 							}
 						}
 
+						// upper bound of the SW score on this window: every nucleotide of the read
+						// segment scores a match. Skip SW if the candidate cannot pass the E-value threshold.
+						// If it only cannot replace the lowest scoring alignment kept so far (is_best),
+						// SW still runs score-only: whether the window passes the threshold steers the
+						// search below ('is_aligned', 'search'), and the score alone decides that.
+						// Only the traceback is skipped, so the alignments are the same as without pruning
+						auto score_ub = static_cast<uint32_t>(align_length - head - tail) * std::max(opts.match, opts.score_N);
+						bool is_pruned = opts.is_sw_prune && score_ub <= refstats.minimal_score[index.index_num];
+						bool is_pruned_best = false;
+						if (opts.is_sw_prune && !is_pruned && opts.is_best && opts.num_alignments > 0 
+							&& read.alignment.alignv.size() == opts.num_alignments)
+						{
+							auto min_idx = (read.alignment.min_index == 0 && read.alignment.max_index == 0) 
+								? findMinIndex(read.alignment.alignv) : read.alignment.min_index;
+							is_pruned_best = score_ub < read.alignment.alignv[min_idx].score1;
+						}
+
+						if (is_pruned)
+							readstats.num_sw_pruned.fetch_add(1, std::memory_order_relaxed);
+						if (is_pruned_best)
+							readstats.num_sw_pruned_best.fetch_add(1, std::memory_order_relaxed);
+
 						// put read into 04 encoding before SSW
-						if (read.is03) 
+						if (!is_pruned && read.is03)
 							read.flip34();
-                       
-						// create profile for read
-						s_profile* profile = 0;
-						profile = ssw_init((int8_t*)(&read.isequence[0] + align_que_start), 
-                                                    (align_length - head - tail), 
-                                                    &read.scoring_matrix[0], 5, 2);
+
+						// ungapped X-drop prefilter along the LIS diagonal. Reject if the ungapped score
+						// plus a match on every read position outside the ungapped segment (gap allowance)
+						// cannot pass the E-value threshold
+						if (!is_pruned && opts.xdrop > 0)
+						{
+							auto hsp = xdrop_ungapped(read.isequence, refs.buffer[max_ref].sequence,
+								static_cast<uint32_t>(align_que_start), static_cast<uint32_t>(align_que_start + align_length - head - tail),
+								lcs_que_start, static_cast<int64_t>(lcs_ref_start) - lcs_que_start,
+								&read.scoring_matrix[0], opts.xdrop);
+							int64_t xdrop_ub = hsp.first + static_cast<int64_t>(align_length - head - tail - hsp.second) * opts.match;
+							if (xdrop_ub <= static_cast<int64_t>(refstats.minimal_score[index.index_num])) {
+								is_pruned = true;
+								readstats.num_sw_xdrop.fetch_add(1, std::memory_order_relaxed);
+							}
+						}
 
 						s_align* result = 0;
 
-						result = ssw_align(
-							profile,
-							(int8_t*)refs.buffer[max_ref].sequence.c_str() + align_ref_start - head,
-							align_length,
-							opts.gap_open,
-							opts.gap_extension,
-							2,
-							refstats.minimal_score[index.index_num], // minimal_score_index_num
-							0,
-							0
-						);
-
-						// deallocate memory for profile, no longer needed
-						if (profile != 0) 
-							init_destroy(&profile);
+						if (!is_pruned)
+						{
+							readstats.num_sw.fetch_add(1, std::memory_order_relaxed);
+
+							// create profile for read
+							s_profile* profile = 0;
+							profile = ssw_init((int8_t*)(&read.isequence[0] + align_que_start), 
+	                                                    (align_length - head - tail), 
+	                                                    &read.scoring_matrix[0], 5, 2);
+
+							// flag 2: begin positions and CIGAR for alignments scoring >= minimal score
+							// flag 0: score-only i.e. no reverse pass and no traceback (see 'Runopts::is_cigar'
+							//         and 'is_pruned_best' above)
+							result = ssw_align(
+								profile,
+								(int8_t*)refs.buffer[max_ref].sequence.c_str() + align_ref_start - head,
+								align_length,
+								opts.gap_open,
+								opts.gap_extension,
+								opts.is_cigar && !is_pruned_best ? 2 : 0,
+								refstats.minimal_score[index.index_num], // minimal_score_index_num
+								0,
+								0
+							);
+
+							// deallocate memory for profile, no longer needed
+							if (profile != 0) 
+								init_destroy(&profile);
+						}
 
 						// check alignment passes the threshold
 						is_aligned = (result != 0 && result->score1 > refstats.minimal_score[index.index_num]);
@@ -393,9 +503,12 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 
 							// add the offset calculated by the LCS (from the beginning of the sequence)
 							// to the offset computed by SW alignment
-							result->ref_begin1 += (align_ref_start - head);
+							// begin positions are -1 (not calculated) in score-only mode
+							if (opts.is_cigar && !is_pruned_best) {
+								result->ref_begin1 += (align_ref_start - head);
+								result->read_begin1 += align_que_start;
+							}
 							result->ref_end1 += (align_ref_start - head);
-							result->read_begin1 += align_que_start;
 							result->read_end1 += align_que_start;
 							result->readlen = read.sequence.length();
 							result->ref_num = max_ref;
@@ -411,6 +524,7 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 							if (!read.is_hit)
 							{
 								read.is_hit = true;
+								read.is_part_hit = true; // replayed by a run resuming the part
 								readstats.num_aligned.fetch_add(1, std::memory_order_relaxed);
 								++readstats.reads_matched_per_db[index.index_num];
 							}
@@ -451,10 +565,12 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 									}
 
 									// decrement number of reads mapped to database with lower score
-									--readstats.reads_matched_per_db[read.alignment.alignv[min_score_index].index_num];
-									//                                                           |_old min index
+									auto old_db = read.alignment.alignv[min_score_index].index_num;
+									--readstats.reads_matched_per_db[old_db];
+									//                               |_old min index
 									// increment number of reads mapped to database with higher score
 									++readstats.reads_matched_per_db[index.index_num];
+									read.part_db_moves.push_back(old_db); // replayed by a run resuming the part
 								}
 							}//~if
 
@@ -506,6 +622,10 @@ void compute_lis_alignment( Read& read, Runopts& opts,
 			}
 		}//~for all matching k-mers on a reference
 	}//~for all reference candidates
+
+	// '--index_rc': the seeds of the next pass are searched on the forward read
+	if (opts.is_index_rc && read.reversed)
+		read.revIntStr();
 } // ~compute_lis_alignment
 
 s_align2 copyAlignment(s_align* pAlign)
@@ -74,6 +74,8 @@ Index::Index(Runopts& opts) : index_num(0), part(0), number_elements(0), is_read
 			if (opts.indexfiles[idx].second.size() == 0) {
 				auto refpath_base = std::filesystem::path(opts.indexfiles[idx].first).filename();
 				auto idx_file_pfx = opts.idxdir / string_hash(refpath_base.generic_string()); // idxdir is set in Runopts::validate_idxdir
+				if (opts.is_index_rc)
+					idx_file_pfx += "_rc"; // does not replace the forward-only index, nor is taken for it
 				opts.indexfiles[idx].second = idx_file_pfx.generic_string();
 			}
 
@@ -356,6 +358,17 @@ void Index::load(uint32_t idx_num, uint32_t idx_part, std::vector<std::pair<std:
 	part = idx_part;
 } // ~Index::load
 
+void Index::prefetch(uint32_t idx_num, uint32_t idx_part, const std::vector<std::pair<std::string, std::string>>& indexfiles)
+{
+	static const std::size_t BUF_SIZE = 1 << 20;
+	std::vector<char> buf(BUF_SIZE);
+	auto sfx = "_" + std::to_string(idx_part) + ".dat";
+	for (auto const& name : { ".kmer", ".bursttrie", ".pos" }) {
+		std::ifstream ifs(indexfiles[idx_num].second + name + sfx, std::ios::in | std::ios::binary);
+		while (ifs.read(buf.data(), buf.size()) || ifs.gcount() > 0); // the data is not used
+	}
+} // ~Index::prefetch
+
 void Index::unload()
 {
 	// lookup_tbl
@@ -50,6 +50,7 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include <iostream>
 #include <filesystem>
 #include <chrono>
+#include <algorithm> // std::reverse
 
 #include <sys/stat.h> //for creating tmp dir
 
@@ -1126,6 +1127,8 @@ int build_index(Runopts& opts)
 
 	pread_gv = opts.seed_win_len + 1;
 	partialwin_gv = opts.seed_win_len / 2;
+	// '--index_rc' indexes each sequence twice: forward and reverse complement
+	const int num_strands = opts.is_index_rc ? 2 : 1;
 
 	mask32 = (1 << opts.seed_win_len) - 1;
 	mask64 = (2ULL << ((pread_gv * 2) - 1)) - 1;
@@ -1381,7 +1384,7 @@ int build_index(Runopts& opts)
 
 				// check the addition of this sequence will not overflow the
 				// maximum memory (estimated memory 10 bytes per L-mer)
-				double estimated_seq_mem = (len - pread_gv + 1)*9.5e-6; // MB
+				double estimated_seq_mem = (len - pread_gv + 1)*9.5e-6*num_strands; // MB
 
 				// the sequence alone is too large, it will not fit into maximum
 				// memory, skip it
@@ -1425,121 +1428,130 @@ int build_index(Runopts& opts)
 					numseq_part++;
 				}
 
-				// create a reverse sequence using the forward
-				unsigned char* ptr = &myseq[len - 1];
-				for (_j = 0; _j < len; _j++) {
-					myseqr[_j] = *ptr--;
-				}
-				
-				// 9-mer prefix of 19-mer
-				uint32_t kmer_key_short_f = 0;
-				// 9-mer suffix of 19-mer i.e. prefix of the reversed seq
-				uint32_t kmer_key_short_r = 0;
-				// pointer to next letter to add to 9-mer prefix
-				unsigned char* kmer_key_short_f_p = &myseq[0];
-				// pointer to next letter to add to 9-mer suffix
-				unsigned char* kmer_key_short_r_p = &myseq[partialwin_gv + 1];
-				// pointer to 10-mer of reverse 19-mer to insert
-				// into the mini-burst trie
-				unsigned char* kmer_key_short_r_rp = &myseqr[len - partialwin_gv - 1];
-				// 19-mer
-				unsigned long long int kmer_key = 0;
-				// pointer to 19-mer
-				unsigned char* kmer_key_ptr = &myseq[0];
-
-				// initialize the prefix and suffix 9-mers
-				for (uint32_t j = 0; j < partialwin_gv; j++)
+				// '--index_rc': then the reverse complement of the sequence, in place
+				for (int strand = 0; strand < num_strands; ++strand)
 				{
-					(kmer_key_short_f <<= 2) |= (int)*kmer_key_short_f_p++;
-					(kmer_key_short_r <<= 2) |= (int)*kmer_key_short_r_p++;
-				}
-
-				// initialize the 19-mer
-				for (uint32_t j = 0; j < pread_gv; j++) (kmer_key <<= 2) |= (int)*kmer_key_ptr++;
-
-				uint32_t numwin = (len - pread_gv + opts.interval) / opts.interval; //TESTING
-				uint32_t index_pos = 0;
+					if (strand == 1) {
+						std::reverse(myseq, myseq + len);
+						for (_j = 0; _j < len; _j++) myseq[_j] = complement[myseq[_j]];
+					}
 
-				// for all 19-mers on the sequence
-				for (uint32_t j = 0; j < numwin; j++) //TESTING
-				{
-					lookup_table[kmer_key_short_f].count++;
-					incremented_by_forward[kmer_key_short_f] = true;
-					// increment 9-mer count only if it wasn't already
-					// incremented by kmer_key_short_f before
-					if (!incremented_by_forward[kmer_key_short_r]) {
-						lookup_table[kmer_key_short_r].count++;
+					// create a reverse sequence using the forward
+					unsigned char* ptr = &myseq[len - 1];
+					for (_j = 0; _j < len; _j++) {
+						myseqr[_j] = *ptr--;
+					}
+				
+					// 9-mer prefix of 19-mer
+					uint32_t kmer_key_short_f = 0;
+					// 9-mer suffix of 19-mer i.e. prefix of the reversed seq
+					uint32_t kmer_key_short_r = 0;
+					// pointer to next letter to add to 9-mer prefix
+					unsigned char* kmer_key_short_f_p = &myseq[0];
+					// pointer to next letter to add to 9-mer suffix
+					unsigned char* kmer_key_short_r_p = &myseq[partialwin_gv + 1];
+					// pointer to 10-mer of reverse 19-mer to insert
+					// into the mini-burst trie
+					unsigned char* kmer_key_short_r_rp = &myseqr[len - partialwin_gv - 1];
+					// 19-mer
+					unsigned long long int kmer_key = 0;
+					// pointer to 19-mer
+					unsigned char* kmer_key_ptr = &myseq[0];
+
+					// initialize the prefix and suffix 9-mers
+					for (uint32_t j = 0; j < partialwin_gv; j++)
+					{
+						(kmer_key_short_f <<= 2) |= (int)*kmer_key_short_f_p++;
+						(kmer_key_short_r <<= 2) |= (int)*kmer_key_short_r_p++;
 					}
 
-					// ****** add the forward 19-mer
+					// initialize the 19-mer
+					for (uint32_t j = 0; j < pread_gv; j++) (kmer_key <<= 2) |= (int)*kmer_key_ptr++;
 
-					// new position for 18-mer in positions_tbl
-					bool new_position = true;
+					uint32_t numwin = (len - pread_gv + opts.interval) / opts.interval; //TESTING
+					uint32_t index_pos = 0;
 
-					// forward 19-mer does not exist in the burst trie (duplicates not allowed)
-					if (lookup_table[kmer_key_short_f].trie_F == NULL ||
-						(lookup_table[kmer_key_short_f].trie_F != NULL && 
-						!search_burst_trie(lookup_table[kmer_key_short_f].trie_F, kmer_key_short_f_p, new_position)))
+					// for all 19-mers on the sequence
+					for (uint32_t j = 0; j < numwin; j++) //TESTING
 					{
-						// create a trie node if it doesn't exist
-						if (lookup_table[kmer_key_short_f].trie_F == NULL)
+						lookup_table[kmer_key_short_f].count++;
+						incremented_by_forward[kmer_key_short_f] = true;
+						// increment 9-mer count only if it wasn't already
+						// incremented by kmer_key_short_f before
+						if (!incremented_by_forward[kmer_key_short_r]) {
+							lookup_table[kmer_key_short_r].count++;
+						}
+
+						// ****** add the forward 19-mer
+
+						// new position for 18-mer in positions_tbl
+						bool new_position = true;
+
+						// forward 19-mer does not exist in the burst trie (duplicates not allowed)
+						if (lookup_table[kmer_key_short_f].trie_F == NULL ||
+							(lookup_table[kmer_key_short_f].trie_F != NULL && 
+							!search_burst_trie(lookup_table[kmer_key_short_f].trie_F, kmer_key_short_f_p, new_position)))
 						{
-							lookup_table[kmer_key_short_f].trie_F = (NodeElement*)malloc(4 * sizeof(NodeElement));
+							// create a trie node if it doesn't exist
 							if (lookup_table[kmer_key_short_f].trie_F == NULL)
 							{
-								std::cerr << RED << "  ERROR" << COLOFF << ": could not allocate memory for trie_node in indexdb.cpp" << std::endl;
-								exit(EXIT_FAILURE);
+								lookup_table[kmer_key_short_f].trie_F = (NodeElement*)malloc(4 * sizeof(NodeElement));
+								if (lookup_table[kmer_key_short_f].trie_F == NULL)
+								{
+									std::cerr << RED << "  ERROR" << COLOFF << ": could not allocate memory for trie_node in indexdb.cpp" << std::endl;
+									exit(EXIT_FAILURE);
+								}
+								memset(lookup_table[kmer_key_short_f].trie_F, 0, 4 * sizeof(NodeElement));
 							}
-							memset(lookup_table[kmer_key_short_f].trie_F, 0, 4 * sizeof(NodeElement));
-						}
 
-						insert_prefix(lookup_table[kmer_key_short_f].trie_F, kmer_key_short_f_p);
-					}
+							insert_prefix(lookup_table[kmer_key_short_f].trie_F, kmer_key_short_f_p);
+						}
 
-					// 18-mer doesn't exist in the burst trie, add it to keys file
-					if (new_position)
-					{
-						// increment number of unique 18-mers
-						number_elements++;
-						fprintf(keys, "%llu\n", (kmer_key >> 2));
-					}
+						// 18-mer doesn't exist in the burst trie, add it to keys file
+						if (new_position)
+						{
+							// increment number of unique 18-mers
+							number_elements++;
+							fprintf(keys, "%llu\n", (kmer_key >> 2));
+						}
 
-					// ****** add the reverse 19-mer
-					new_position = true;
+						// ****** add the reverse 19-mer
+						new_position = true;
 
-					// reverse 19-mer does not exist in the burst trie
-					if (lookup_table[kmer_key_short_r].trie_R == NULL ||
-						((lookup_table[kmer_key_short_r].trie_R != NULL) && 
-						!search_burst_trie(lookup_table[kmer_key_short_r].trie_R, kmer_key_short_r_rp, new_position)))
-					{
-						// create a trie node if it doesn't exist
-						if (lookup_table[kmer_key_short_r].trie_R == NULL)
+						// reverse 19-mer does not exist in the burst trie
+						if (lookup_table[kmer_key_short_r].trie_R == NULL ||
+							((lookup_table[kmer_key_short_r].trie_R != NULL) && 
+							!search_burst_trie(lookup_table[kmer_key_short_r].trie_R, kmer_key_short_r_rp, new_position)))
 						{
-							lookup_table[kmer_key_short_r].trie_R = (NodeElement*)malloc(4 * sizeof(NodeElement));
+							// create a trie node if it doesn't exist
 							if (lookup_table[kmer_key_short_r].trie_R == NULL)
 							{
-								std::cerr << RED << "  ERROR" << COLOFF << ": could not allocate memory for trie_node in indexdb.cpp" << std::endl;
-								exit(EXIT_FAILURE);
+								lookup_table[kmer_key_short_r].trie_R = (NodeElement*)malloc(4 * sizeof(NodeElement));
+								if (lookup_table[kmer_key_short_r].trie_R == NULL)
+								{
+									std::cerr << RED << "  ERROR" << COLOFF << ": could not allocate memory for trie_node in indexdb.cpp" << std::endl;
+									exit(EXIT_FAILURE);
+								}
+								memset(lookup_table[kmer_key_short_r].trie_R, 0, 4 * sizeof(NodeElement));
 							}
-							memset(lookup_table[kmer_key_short_r].trie_R, 0, 4 * sizeof(NodeElement));
-						}
 
-						insert_prefix(lookup_table[kmer_key_short_r].trie_R, kmer_key_short_r_rp);
-					}
+							insert_prefix(lookup_table[kmer_key_short_r].trie_R, kmer_key_short_r_rp);
+						}
 
-					// shift 19-mer window and both 9-mers
-					if (j != numwin - 1)
-					{
-						for (uint32_t shift = 0; shift < opts.interval; shift++)
+						// shift 19-mer window and both 9-mers
+						if (j != numwin - 1)
 						{
-							((kmer_key_short_f <<= 2) &= mask32) |= (int)*kmer_key_short_f_p++;
-							((kmer_key_short_r <<= 2) &= mask32) |= (int)*kmer_key_short_r_p++;
-							((kmer_key <<= 2) &= mask64) |= (int)*kmer_key_ptr++;
-							kmer_key_short_r_rp--;
-							index_pos++;
+							for (uint32_t shift = 0; shift < opts.interval; shift++)
+							{
+								((kmer_key_short_f <<= 2) &= mask32) |= (int)*kmer_key_short_f_p++;
+								((kmer_key_short_r <<= 2) &= mask32) |= (int)*kmer_key_short_r_p++;
+								((kmer_key <<= 2) &= mask64) |= (int)*kmer_key_ptr++;
+								kmer_key_short_r_rp--;
+								index_pos++;
+							}
 						}
-					}
-				}//~for all 19-mers on the sequence
+					}//~for all 19-mers on the sequence
+				}//~for strands
 
 				delete[] myseq;
 				delete[] myseqr;
@@ -1656,7 +1668,7 @@ int build_index(Runopts& opts)
 				if (nt != EOF) ungetc(nt, fp); // put back the '>'
 
 				// check the addition of this sequence will not overflow the maximum memory
-				double estimated_seq_mem = (len - pread_gv + 1)*9.5e-6;
+				double estimated_seq_mem = (len - pread_gv + 1)*9.5e-6*num_strands;
 
 				// the sequence alone is too large, it will not fit into maximum memory, skip it
 				if (estimated_seq_mem > opts.max_file_size) continue;
@@ -1677,64 +1689,76 @@ int build_index(Runopts& opts)
 					index_size += estimated_seq_mem;
 				}
 
-				// create a reverse sequence using the forward
-				unsigned char* ptr = &myseq[len - 1];
+				// '--index_rc': then the reverse complement of the sequence, in place
+				for (int strand = 0; strand < num_strands; ++strand)
+				{
+					if (strand == 1) {
+						std::reverse(myseq, myseq + len);
+						for (_j = 0; _j < len; _j++) myseq[_j] = complement[myseq[_j]];
+					}
 
-				for (_j = 0; _j < len; _j++) myseqr[_j] = *ptr--;
+					// create a reverse sequence using the forward
+					unsigned char* ptr = &myseq[len - 1];
 
-				uint32_t kmer_key_short_f = 0;
-				uint32_t kmer_key_short_r = 0;
-				unsigned char* kmer_key_short_f_p = &myseq[0];
-				unsigned char* kmer_key_short_r_p = &myseq[partialwin_gv + 1];
-				unsigned char* kmer_key_short_r_rp = &myseqr[len - partialwin_gv - 1];
-				unsigned long long int kmer_key = 0;
-				unsigned char* kmer_key_ptr = &myseq[0];
+					for (_j = 0; _j < len; _j++) myseqr[_j] = *ptr--;
 
-				// initialize the 9-mers
-				for (uint32_t j = 0; j < partialwin_gv; j++)
-				{
-					(kmer_key_short_f <<= 2) |= (int)*kmer_key_short_f_p++;
-					(kmer_key_short_r <<= 2) |= (int)*kmer_key_short_r_p++;
-				}
+					uint32_t kmer_key_short_f = 0;
+					uint32_t kmer_key_short_r = 0;
+					unsigned char* kmer_key_short_f_p = &myseq[0];
+					unsigned char* kmer_key_short_r_p = &myseq[partialwin_gv + 1];
+					unsigned char* kmer_key_short_r_rp = &myseqr[len - partialwin_gv - 1];
+					unsigned long long int kmer_key = 0;
+					unsigned char* kmer_key_ptr = &myseq[0];
 
-				// initialize the 19-mer
-				for (uint32_t j = 0; j < pread_gv; j++)
-					(kmer_key <<= 2) |= (int)*kmer_key_ptr++;
+					// initialize the 9-mers
+					for (uint32_t j = 0; j < partialwin_gv; j++)
+					{
+						(kmer_key_short_f <<= 2) |= (int)*kmer_key_short_f_p++;
+						(kmer_key_short_r <<= 2) |= (int)*kmer_key_short_r_p++;
+					}
 
-				uint32_t numwin = (len - pread_gv + opts.interval) / opts.interval; //TESTING
-				uint32_t id = 0;
+					// initialize the 19-mer
+					for (uint32_t j = 0; j < pread_gv; j++)
+						(kmer_key <<= 2) |= (int)*kmer_key_ptr++;
 
-				uint32_t index_pos = 0; //TESTING
+					uint32_t numwin = (len - pread_gv + opts.interval) / opts.interval; //TESTING
+					uint32_t id = 0;
 
-				// for all 19-mers on the sequence
-				for (uint32_t j = 0; j < numwin; j++) //TESTING
-				{
-					// character array to hold an unsigned long long integer for CMPH
-					char a[38] = { 0 };
-					sprintf(a, "%llu", (kmer_key >> 2));
-					const char *key = a;
-					id = cmph_search(hash, key, (cmph_uint32)strlen(key));
+					uint32_t index_pos = 0; //TESTING
 
-					//cout << "\t" << id << "=" << (kmer_key>>2); //TESTING
+					// for all 19-mers on the sequence
+					for (uint32_t j = 0; j < numwin; j++) //TESTING
+					{
+						// character array to hold an unsigned long long integer for CMPH
+						char a[38] = { 0 };
+						sprintf(a, "%llu", (kmer_key >> 2));
+						const char *key = a;
+						id = cmph_search(hash, key, (cmph_uint32)strlen(key));
 
-					add_id_to_burst_trie(lookup_table[kmer_key_short_f].trie_F, kmer_key_short_f_p, id);
-					add_id_to_burst_trie(lookup_table[kmer_key_short_r].trie_R, kmer_key_short_r_rp, id);
+						//cout << "\t" << id << "=" << (kmer_key>>2); //TESTING
 
-					add_kmer_to_table(positions_tbl + id, i, index_pos, opts.max_pos);
+						add_id_to_burst_trie(lookup_table[kmer_key_short_f].trie_F, kmer_key_short_f_p, id);
+						add_id_to_burst_trie(lookup_table[kmer_key_short_r].trie_R, kmer_key_short_r_rp, id);
 
-					// shift the 19-mer and 9-mers
-					if (j != numwin - 1)
-					{
-						for (uint32_t shift = 0; shift < opts.interval; shift++)
+						if (strand == 0)
+							add_kmer_to_table(positions_tbl + id, i, index_pos, opts.max_pos);
+						else
+							add_kmer_to_table(positions_tbl + id, i | SEQ_POS_RC, len - index_pos - opts.seed_win_len, opts.max_pos); // see 'seq_pos'
+
+						// shift the 19-mer and 9-mers
+						if (j != numwin - 1)
 						{
-							((kmer_key_short_f <<= 2) &= mask32) |= (int)*kmer_key_short_f_p++;
-							((kmer_key_short_r <<= 2) &= mask32) |= (int)*kmer_key_short_r_p++;
-							((kmer_key <<= 2) &= mask64) |= (int)*kmer_key_ptr++;
-							kmer_key_short_r_rp--;
-							index_pos++;
+							for (uint32_t shift = 0; shift < opts.interval; shift++)
+							{
+								((kmer_key_short_f <<= 2) &= mask32) |= (int)*kmer_key_short_f_p++;
+								((kmer_key_short_r <<= 2) &= mask32) |= (int)*kmer_key_short_r_p++;
+								((kmer_key <<= 2) &= mask64) |= (int)*kmer_key_ptr++;
+								kmer_key_short_r_rp--;
+								index_pos++;
+							}
 						}
-					}
-				} 
+					} 
+				}//~for strands
 
 				delete[] myseq;
 				delete[] myseqr;
@@ -2078,6 +2102,12 @@ int build_index(Runopts& opts)
 				// the length of the sequence itself
 				stats.write(reinterpret_cast<const char*>(&(samheader.second)), sizeof(uint32_t));
 			}
+
+			// index format version and flags. Appended, so that a version 1 reader still loads the stats
+			uint32_t version = INDEX_VERSION;
+			stats.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+			uint32_t flags = opts.is_index_rc ? INDEX_FLAG_RC : 0;
+			stats.write(reinterpret_cast<const char*>(&flags), sizeof(uint32_t));
 			stats.close();
 
 			INFO_NS("  done.\n\n");
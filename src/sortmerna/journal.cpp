@@ -0,0 +1,135 @@
+/*
+@copyright 2016-2026 Clarity Genomics BVBA
+@copyright 2012-2016 Bonsai Bioinformatics Research Group
+@copyright 2014-2016 Knight Lab, Department of Pediatrics, UCSD, La Jolla
+
+@parblock
+SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+
+This is a free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SortMeRNA is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+@endparblock
+
+@contributors Jenya Kopylova   jenya.kopylov@gmail.com
+              Laurent Noé      laurent.noe@lifl.fr
+              Pierre Pericard  pierre.pericard@lifl.fr
+              Daniel McDonald  wasade@gmail.com
+              Mikaël Salson    mikael.salson@lifl.fr
+              Hélène Touzet    helene.touzet@lifl.fr
+              Rob Knight       robknight@ucsd.edu
+              biocodz          biocodz@protonmail.com
+*/
+
+/*
+ * FILE: journal.cpp
+ * Created: Oct 19, 2026 Mon
+ */
+
+#include <filesystem>
+#include <sstream>
+#include <cstring> // memcpy
+#include <system_error>
+
+#include "journal.hpp"
+#include "kvdb.hpp"
+#include "readstats.hpp"
+#include "options.hpp"
+#include "readfeed.hpp" // is_stream_path
+
+std::string string_hash(const std::string& val); // util.cpp
+
+namespace {
+	// path, size and modification time of a file
+	void add_file(std::stringstream& ss, const std::string& path)
+	{
+		std::error_code ec;
+		auto fpath = std::filesystem::absolute(path, ec);
+		ss << fpath.string() << '|' << std::filesystem::file_size(fpath, ec) << '|'
+			<< std::filesystem::last_write_time(fpath, ec).time_since_epoch().count() << '\n';
+	}
+}
+
+Journal::Journal(Runopts& opts, Readstats& readstats)
+	: is_enabled_(!opts.is_kvdb_mem), dbkey("journal_" + readstats.dbkey)
+{
+	std::stringstream ss;
+	for (auto const& readfile : opts.readfiles) {
+		if (Readfeed::is_stream_path(readfile))
+			is_enabled_ = false; // cannot be read again
+		add_file(ss, readfile);
+	}
+	for (auto const& idx : opts.indexfiles)
+		add_file(ss, idx.first);
+	ss << opts.cmdline;
+	fingerprint = string_hash(ss.str());
+} // ~Journal::Journal
+
+Journal::STATE Journal::restore(KeyValueDatabase& kvdb)
+{
+	if (!is_enabled_)
+		return STATE::NONE;
+
+	std::string bstr = kvdb.get(dbkey);
+	if (bstr.size() == 0)
+		return STATE::NONE;
+
+	// version, fingerprint length, fingerprint, done index, done part
+	uint8_t version = 0;
+	uint32_t fp_len = 0;
+	std::size_t offset = 0;
+	std::memcpy(static_cast<void*>(&version), bstr.data() + offset, sizeof(version));
+	offset += sizeof(version);
+	if (version != VERSION || bstr.size() < offset + sizeof(fp_len))
+		return STATE::MISMATCH;
+	std::memcpy(static_cast<void*>(&fp_len), bstr.data() + offset, sizeof(fp_len));
+	offset += sizeof(fp_len);
+	if (bstr.size() != offset + fp_len + sizeof(done_num) + sizeof(done_part))
+		return STATE::MISMATCH;
+	if (bstr.compare(offset, fp_len, fingerprint) != 0)
+		return STATE::MISMATCH;
+	offset += fp_len;
+	std::memcpy(static_cast<void*>(&done_num), bstr.data() + offset, sizeof(done_num));
+	offset += sizeof(done_num);
+	std::memcpy(static_cast<void*>(&done_part), bstr.data() + offset, sizeof(done_part));
+
+	is_restored = true;
+	INFO("Resuming the alignment of a previous run. Done index: ", done_num, " part: ", done_part + 1);
+	return STATE::MATCH;
+} // ~Journal::restore
+
+void Journal::store(KeyValueDatabase& kvdb, Readstats& readstats, uint32_t idx_num, uint32_t idx_part)
+{
+	if (!is_enabled_)
+		return;
+
+	readstats.store_to_db(kvdb); // the statistics as of this part
+
+	std::string buf;
+	uint32_t fp_len = static_cast<uint32_t>(fingerprint.size());
+	buf.push_back(static_cast<char>(VERSION));
+	buf.append(static_cast<const char*>(static_cast<const void*>(&fp_len)), sizeof(fp_len));
+	buf += fingerprint;
+	buf.append(static_cast<const char*>(static_cast<const void*>(&idx_num)), sizeof(idx_num));
+	buf.append(static_cast<const char*>(static_cast<const void*>(&idx_part)), sizeof(idx_part));
+	kvdb.put(dbkey, buf);
+	kvdb.sync();
+
+	is_restored = true;
+	done_num = idx_num;
+	done_part = idx_part;
+} // ~Journal::store
+
+bool Journal::is_done(uint32_t idx_num, uint32_t idx_part) const
+{
+	return is_restored && (idx_num < done_num || (idx_num == done_num && idx_part <= done_part));
+}
@@ -36,22 +36,98 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
  */
 #include "kvdb.hpp"
 #include "common.hpp"
+#include "rocksdb/table.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/sst_file_writer.h"
 
 #include <iostream>
 #include <filesystem>
+#include <chrono>
+#include <algorithm> // stable_sort
+#include <cassert>
 
-KeyValueDatabase::KeyValueDatabase(std::string const &kvdbPath) 
+KeyValueDatabase::KeyValueDatabase(std::string const &kvdbPath, bool is_wal, bool is_mem, uint64_t mem_max, KVDB_PROFILE profile)
+	: path(kvdbPath), profile(profile), is_mem(is_mem), mem_max(mem_max)
 {
 	// init and open key-value database for read matches
+	set_profile(profile);
+	options.create_if_missing = true;
+	// without the WAL the records only live in the memtables until flushed - see the destructor.
+	// The spilled in-memory records do not outlive the run anyway.
+	write_options.disableWAL = !is_wal || is_mem || profile == KVDB_PROFILE::BULK;
+	if (is_mem) {
+		INFO("Keeping the alignment results in memory", mem_max > 0 ? " up to " + std::to_string(mem_max >> 20) + " MB" : "");
+	}
+	else
+		open();
+}
+
+void KeyValueDatabase::init_mem(std::size_t num_slots, uint64_t reads_per_slot)
+{
+	if (!is_mem)
+		return;
+	std::unique_lock lock(mem_lock);
+	mem_table.clear();
+	mem_table.resize(num_slots);
+	// a segment about the reads of a slot: the table of many small slots is not mostly empty segments
+	mem_segment_size = MEM_SEGMENT_MIN;
+	while (mem_segment_size < MEM_SEGMENT_MAX && mem_segment_size < reads_per_slot)
+		mem_segment_size <<= 1;
+	if (reads_per_slot == 0)
+		mem_segment_size = MEM_SEGMENT_MAX;
+} // ~KeyValueDatabase::init_mem
+
+void KeyValueDatabase::set_profile(KVDB_PROFILE profile)
+{
 	options.IncreaseParallelism();
+	switch (profile)
+	{
+	case KVDB_PROFILE::BULK:
+		options.PrepareForBulkLoad(); // no auto compactions, no L0 write stalls
+		options.compression = rocksdb::kLZ4Compression;
+		options.write_buffer_size = 256 << 20;
+		options.max_write_buffer_number = 4;
+		options.min_write_buffer_number_to_merge = 2;
+		break;
+	case KVDB_PROFILE::SMALL:
+		options.compression = rocksdb::kZSTD;
+		break;
+	default:
 #if defined(_WIN32)
-	options.compression = rocksdb::kXpressCompression;
+		options.compression = rocksdb::kXpressCompression;
 #else
-	options.compression = rocksdb::kZlibCompression;
+		options.compression = rocksdb::kZlibCompression;
 #endif
-	options.create_if_missing = true;
-	rocksdb::Status s = rocksdb::DB::Open(options, kvdbPath, &kvdb);
-	assert(s.ok());
+		break;
+	}
+
+	if (profile != KVDB_PROFILE::DEFAULT) {
+		// whole key filters: the read keys have a fixed width i.e. a prefix filter would be the same
+		rocksdb::BlockBasedTableOptions table_options;
+		table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10));
+		table_options.whole_key_filtering = true;
+		options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+	}
+} // ~KeyValueDatabase::set_profile
+
+KeyValueDatabase::~KeyValueDatabase()
+{
+	if (is_mem)
+		INFO("In-memory results: ", mem_size >> 20, " MB. Records spilled to the key-value database: ", num_spilled.load());
+	if (kvdb && write_options.disableWAL && !is_mem) {
+		rocksdb::Status s = kvdb->Flush(rocksdb::FlushOptions()); // persist the memtables
+		if (!s.ok())
+			WARN("failed to flush the key-value database: ", s.ToString());
+	}
+	delete kvdb;
+} // ~KeyValueDatabase::~KeyValueDatabase
+
+void KeyValueDatabase::open()
+{
+	std::call_once(open_flag, [this] {
+		rocksdb::Status s = rocksdb::DB::Open(options, path, &kvdb);
+		assert(s.ok());
+	});
 }
 
 /* 
@@ -64,12 +140,386 @@ int KeyValueDatabase::clear(std::string dbpath)
 
 void KeyValueDatabase::put(std::string key, std::string val)
 {
-	rocksdb::Status s = kvdb->Put(rocksdb::WriteOptions(), key, val);
+	if (is_mem) {
+		mem_put(key, val);
+		return;
+	}
+	rocksdb::Status s = kvdb->Put(write_options, key, val);
+}
+
+void KeyValueDatabase::write(rocksdb::WriteBatch& batch)
+{
+	rocksdb::Status s = kvdb->Write(write_options, &batch);
+	if (!s.ok()) {
+		ERR("failed to write to the key-value database: ", s.ToString());
+		exit(EXIT_FAILURE);
+	}
+}
+
+void KeyValueDatabase::Writer::put(const std::string& key, const std::string& val)
+{
+	if (kvdb.is_mem) {
+		kvdb.put(key, val); // nothing to batch
+		return;
+	}
+	if (is_sst) {
+		records.emplace_back(key, val);
+		records_size += key.size() + val.size();
+		if (records_size >= SST_SIZE)
+			flush();
+		return;
+	}
+	batch.Put(key, val);
+	if (batch.GetDataSize() >= BATCH_SIZE)
+		flush();
 }
 
+void KeyValueDatabase::Writer::flush()
+{
+	if (is_sst) {
+		if (records.size() > 0)
+			kvdb.write_sst(records);
+		records.clear();
+		records_size = 0;
+		return;
+	}
+	if (batch.Count() == 0)
+		return;
+	kvdb.write(batch);
+	batch.Clear();
+} // ~KeyValueDatabase::Writer::flush
+
 std::string KeyValueDatabase::get(std::string key)
 {
+	if (is_mem)
+		return mem_get(key);
 	std::string val;
 	rocksdb::Status s = kvdb->Get(rocksdb::ReadOptions(), key, &val);
 	return val;
-}
\ No newline at end of file
+}
+
+std::string KeyValueDatabase::read_key(std::size_t slot_idx, uint64_t read_num)
+{
+	assert(slot_idx < MAX_READ_SLOTS);
+	std::string key(READ_KEY_SIZE, 0);
+	key[0] = READ_KEY_TAG;
+	for (std::size_t i = READ_SLOT_SIZE; i > 0; --i, slot_idx >>= 8)
+		key[i] = static_cast<char>(slot_idx & 0xFF);
+	for (std::size_t i = READ_KEY_SIZE - 1; i > READ_SLOT_SIZE; --i, read_num >>= 8)
+		key[i] = static_cast<char>(read_num & 0xFF);
+	return key;
+} // ~KeyValueDatabase::read_key
+
+bool KeyValueDatabase::parse_read_key(const std::string& key, std::size_t& slot_idx, uint64_t& read_num)
+{
+	if (key.size() != READ_KEY_SIZE || key[0] != READ_KEY_TAG)
+		return false;
+	slot_idx = 0;
+	for (std::size_t i = 1; i <= READ_SLOT_SIZE; ++i)
+		slot_idx = (slot_idx << 8) | static_cast<uint8_t>(key[i]);
+	read_num = 0;
+	for (std::size_t i = READ_SLOT_SIZE + 1; i < READ_KEY_SIZE; ++i)
+		read_num = (read_num << 8) | static_cast<uint8_t>(key[i]);
+	return true;
+} // ~KeyValueDatabase::parse_read_key
+
+/*
+ * Sort the records and write them to new SST files in '<kvdb>/ingest', a file per reads slot
+ */
+void KeyValueDatabase::write_sst(std::vector<std::pair<std::string, std::string>>& records)
+{
+	// SstFileWriter needs strictly increasing keys. Same key twice - the last put wins
+	std::stable_sort(records.begin(), records.end(), 
+		[](auto const& a, auto const& b) { return a.first < b.first; });
+
+	// the slots of a Writer are not read by the other ones i.e. the files of the slots do not overlap
+	const std::size_t prefix_len = 1 + READ_SLOT_SIZE;
+	for (std::size_t begin = 0; begin < records.size();) {
+		auto end = begin + 1;
+		while (end < records.size() && records[end].first.compare(0, prefix_len, records[begin].first, 0, prefix_len) == 0)
+			++end;
+		write_sst_file(records, begin, end);
+		begin = end;
+	}
+} // ~KeyValueDatabase::write_sst
+
+/* @param begin, end  the sorted records to write */
+void KeyValueDatabase::write_sst_file(std::vector<std::pair<std::string, std::string>>& records, std::size_t begin, std::size_t end)
+{
+	std::filesystem::path sst_path;
+	{
+		std::lock_guard lock(sst_lock);
+		sst_path = std::filesystem::path(path) / "ingest";
+		if (sst_count == 0)
+			std::filesystem::create_directories(sst_path);
+		sst_path /= "part_" + std::to_string(sst_count++) + ".sst";
+	}
+
+	rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options);
+	rocksdb::Status s = writer.Open(sst_path.string());
+	for (std::size_t i = begin; s.ok() && i < end; ++i) {
+		if (i + 1 < end && records[i].first == records[i + 1].first)
+			continue;
+		s = writer.Put(records[i].first, records[i].second);
+	}
+	if (s.ok())
+		s = writer.Finish();
+	if (!s.ok()) {
+		ERR("failed to write the SST file ", sst_path, " : ", s.ToString());
+		exit(EXIT_FAILURE);
+	}
+
+	std::lock_guard lock(sst_lock);
+	sst_files.push_back({ sst_path.string(), records[begin].first, records[end - 1].first });
+} // ~KeyValueDatabase::write_sst_file
+
+void KeyValueDatabase::ingest()
+{
+	std::lock_guard lock(sst_lock);
+	if (sst_files.empty())
+		return;
+
+	auto starts = std::chrono::high_resolution_clock::now();
+	rocksdb::IngestExternalFileOptions ingest_options;
+	ingest_options.move_files = true; // hard link, no copy
+
+	// A single call takes files that do not overlap. Normally all of them. A file overlapping a file
+	// written earlier e.g. a slot flushed again with a record put twice goes to a later call, so that
+	// it gets the newer sequence numbers i.e. overrides the older record.
+	std::vector<unsigned> layers(sst_files.size(), 0);
+	unsigned num_layers = 0;
+	for (std::size_t i = 0; i < sst_files.size(); ++i) {
+		for (std::size_t j = 0; j < i; ++j) {
+			if (sst_files[j].first <= sst_files[i].last && sst_files[i].first <= sst_files[j].last)
+				layers[i] = std::max(layers[i], layers[j] + 1);
+		}
+		num_layers = std::max(num_layers, layers[i] + 1);
+	}
+	for (unsigned layer = 0; layer < num_layers; ++layer) {
+		std::vector<std::string> files;
+		for (std::size_t i = 0; i < sst_files.size(); ++i) {
+			if (layers[i] == layer)
+				files.push_back(sst_files[i].path);
+		}
+		rocksdb::Status s = kvdb->IngestExternalFile(files, ingest_options);
+		if (!s.ok()) {
+			ERR("failed to ingest ", files.size(), " SST files e.g. ", files.front(), " : ", s.ToString());
+			exit(EXIT_FAILURE);
+		}
+		for (auto const& file : files) {
+			std::error_code ec;
+			std::filesystem::remove(file, ec); // if linked
+		}
+	}
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - starts;
+	INFO("Ingested ", sst_files.size(), " SST files in ", num_layers, " calls in ", elapsed.count(), " sec");
+	sst_files.clear();
+} // ~KeyValueDatabase::ingest
+
+void KeyValueDatabase::sync()
+{
+	if (!kvdb || is_mem || !write_options.disableWAL)
+		return; // the WAL is written on each put
+	rocksdb::Status s = kvdb->Flush(rocksdb::FlushOptions());
+	if (!s.ok())
+		WARN("failed to flush the key-value database: ", s.ToString());
+} // ~KeyValueDatabase::sync
+
+void KeyValueDatabase::compact()
+{
+	if (!kvdb || !options.disable_auto_compactions)
+		return;
+	auto starts = std::chrono::high_resolution_clock::now();
+	rocksdb::Status s = kvdb->Flush(rocksdb::FlushOptions());
+	if (s.ok())
+		s = kvdb->CompactRange(rocksdb::CompactRangeOptions(), nullptr, nullptr);
+	if (s.ok())
+		s = kvdb->SetOptions({ {"disable_auto_compactions", "false"} });
+	if (!s.ok()) {
+		WARN("failed to compact the key-value database: ", s.ToString());
+		return;
+	}
+	options.disable_auto_compactions = false;
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - starts;
+	INFO("Compacted the key-value database in ", elapsed.count(), " sec");
+} // ~KeyValueDatabase::compact
+
+std::vector<std::string> KeyValueDatabase::multi_get(const std::vector<std::string>& keys)
+{
+	std::vector<std::string> vals(keys.size());
+	if (is_mem) {
+		for (std::size_t i = 0; i < keys.size(); ++i)
+			vals[i] = mem_get(keys[i]);
+		return vals;
+	}
+	std::vector<rocksdb::Slice> slices(keys.begin(), keys.end());
+	auto statuses = kvdb->MultiGet(rocksdb::ReadOptions(), slices, &vals);
+	for (std::size_t i = 0; i < statuses.size(); ++i) {
+		if (!statuses[i].ok())
+			vals[i].clear(); // NotFound
+	}
+	return vals;
+} // ~KeyValueDatabase::multi_get
+
+/*
+ * @return the table slot of the read key, or nullptr if the key is not a read ID of the 'init_mem' slots,
+ *         or the slot does not exist and 'is_create' is false
+ */
+KeyValueDatabase::MemSlot* KeyValueDatabase::mem_slot(const std::string& key, bool is_create)
+{
+	std::size_t slot_idx = 0;
+	uint64_t read_num = 0;
+	if (!parse_read_key(key, slot_idx, read_num))
+		return nullptr;
+
+	{
+		std::shared_lock lock(mem_lock);
+		if (slot_idx >= mem_table.size())
+			return nullptr;
+		auto seg = read_num / mem_segment_size;
+		if (seg < mem_table[slot_idx].size() && mem_table[slot_idx][seg])
+			return &mem_table[slot_idx][seg][read_num % mem_segment_size];
+	}
+	if (!is_create)
+		return nullptr;
+
+	std::unique_lock lock(mem_lock);
+	auto seg = read_num / mem_segment_size;
+	auto& segments = mem_table[slot_idx];
+	if (seg >= segments.size())
+		segments.resize(seg + 1);
+	if (!segments[seg])
+		segments[seg] = std::make_unique<MemSlot[]>(mem_segment_size);
+	return &segments[seg][read_num % mem_segment_size];
+} // ~KeyValueDatabase::mem_slot
+
+bool KeyValueDatabase::mem_reserve(std::size_t old_size, std::size_t new_size)
+{
+	auto size = mem_size.fetch_add(new_size, std::memory_order_relaxed) + new_size;
+	if (mem_max == 0 || new_size <= old_size || size - old_size <= mem_max) {
+		mem_size.fetch_sub(old_size, std::memory_order_relaxed);
+		return true;
+	}
+	mem_size.fetch_sub(new_size + old_size, std::memory_order_relaxed); // the old value is dropped too
+	return false;
+} // ~KeyValueDatabase::mem_reserve
+
+/* move the record to RocksDB for good */
+void KeyValueDatabase::spill(const std::string& key, const std::string& val)
+{
+	open();
+	rocksdb::Status s = kvdb->Put(write_options, key, val);
+	if (!s.ok()) {
+		ERR("failed to spill to the key-value database: ", s.ToString());
+		exit(EXIT_FAILURE);
+	}
+} // ~KeyValueDatabase::spill
+
+void KeyValueDatabase::mem_put(std::string& key, std::string& val)
+{
+	auto slot = mem_slot(key, true);
+	if (!slot) {
+		mem_put_misc(key, val);
+		return;
+	}
+
+	if (!slot->is_spilled)
+	{
+		if (mem_reserve(slot->val.size(), val.size())) {
+			slot->val = std::move(val);
+			return;
+		}
+		// over the limit
+		std::string().swap(slot->val);
+		slot->is_spilled = true;
+		num_spilled.fetch_add(1, std::memory_order_relaxed);
+	}
+	spill(key, val);
+} // ~KeyValueDatabase::mem_put
+
+/* the records outside 'mem_table'. A spilled record is erased from the map i.e. looked up in RocksDB */
+void KeyValueDatabase::mem_put_misc(std::string& key, std::string& val)
+{
+	{
+		std::lock_guard lock(misc_lock);
+		auto it = mem_misc.find(key);
+		auto old_size = it == mem_misc.end() ? 0 : key.size() + it->second.size();
+		if (mem_reserve(old_size, key.size() + val.size())) {
+			mem_misc[key] = std::move(val);
+			return;
+		}
+		if (it != mem_misc.end())
+			mem_misc.erase(it);
+		num_spilled.fetch_add(1, std::memory_order_relaxed);
+	}
+	spill(key, val);
+} // ~KeyValueDatabase::mem_put_misc
+
+std::string KeyValueDatabase::mem_get(const std::string& key)
+{
+	std::string val;
+	std::size_t slot_idx = 0;
+	uint64_t read_num = 0;
+	if (parse_read_key(key, slot_idx, read_num) && slot_idx < mem_table.size()) { // the layout is fixed by 'init_mem'
+		auto slot = mem_slot(key, false);
+		if (!slot)
+			return val; // no results
+		if (!slot->is_spilled)
+			return slot->val;
+	}
+	else {
+		std::lock_guard lock(misc_lock);
+		auto it = mem_misc.find(key);
+		if (it != mem_misc.end())
+			return it->second;
+	}
+	if (kvdb)
+		kvdb->Get(rocksdb::ReadOptions(), key, &val); // spilled
+	return val;
+} // ~KeyValueDatabase::mem_get
+
+std::string KeyValueDatabase::Scanner::get(const std::string& key)
+{
+	if (kvdb.is_mem || key.size() != READ_KEY_SIZE || key[0] != READ_KEY_TAG)
+		return kvdb.get(key);
+	if (!kvdb.kvdb)
+		return std::string(); // in-memory without spills
+
+	// the cursor of the key's slot, otherwise the least recently used one
+	auto is_same_slot = [&key](const Cursor& c) {
+		return c.it && c.last.compare(0, 1 + READ_SLOT_SIZE, key, 0, 1 + READ_SLOT_SIZE) == 0;
+	};
+	auto cur_it = std::find_if(cursors.begin(), cursors.end(), is_same_slot);
+	if (cur_it == cursors.end())
+		cur_it = std::min_element(cursors.begin(), cursors.end(),
+			[](const Cursor& a, const Cursor& b) { return a.used < b.used; });
+	auto& cur = *cur_it;
+	cur.used = ++tick;
+
+	rocksdb::Slice target(key);
+	if (!cur.it) {
+		rocksdb::ReadOptions ropts;
+		ropts.readahead_size = READAHEAD_SIZE;
+		ropts.fill_cache = false; // each record is read once
+		cur.it.reset(kvdb.kvdb->NewIterator(ropts));
+		cur.it->Seek(target);
+	}
+	else if (cur.last.compare(key) > 0 || !is_same_slot(cur)) {
+		cur.it->Seek(target); // going back or another slot
+	}
+	else {
+		// step forward over the reads without results
+		unsigned num_next = 0;
+		for (; cur.it->Valid() && cur.it->key().compare(target) < 0; cur.it->Next()) {
+			if (++num_next > MAX_NEXT) {
+				cur.it->Seek(target);
+				break;
+			}
+		}
+	}
+	cur.last = key;
+
+	if (cur.it->Valid() && cur.it->key().compare(target) == 0)
+		return cur.it->value().ToString();
+	return std::string();
+} // ~KeyValueDatabase::Scanner::get
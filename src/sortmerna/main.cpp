@@ -51,8 +51,37 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include "output.hpp"
 #include "otumap.h"
 #include "refstats.hpp"
+#include "ThreadPool.hpp"
 
 
+/*
+ * '--fused' single pass is possible: a single index part, so that the results of a read are
+ * final once aligned, the reads can be read in order by each thread i.e. not a stream,
+ * no previous run to resume from, and the read counts known i.e. not estimated ('--no_prescan'),
+ * which are exact only after a pass through the reads
+ */
+static bool is_fused(Readfeed& readfeed, Readstats& readstats, Runopts& opts)
+{
+	if (!opts.is_fused)
+		return false;
+
+	unsigned num_parts = 0;
+	Refstats refstats(opts, readstats);
+	for (auto num : refstats.num_index_parts) num_parts += num;
+
+	if (num_parts != 1 || readfeed.is_stream || opts.is_kvdb_resume) {
+		WARN("Option '", OPT_FUSED, "' is ignored: it needs a single part index (found ", num_parts, " parts),",
+			" the reads not from a stream, and an empty key-value database. Running the separate passes");
+		return false;
+	}
+	if (readfeed.is_estimated) {
+		WARN("Option '", OPT_FUSED, "' is ignored with '", OPT_NO_PRESCAN, "': the reads statistics are estimated",
+			" until the alignment pass ends, and the reports need the exact counts. Running the separate passes");
+		return false;
+	}
+	return true;
+} // ~is_fused
+
 /*
 *  main entry of the sortmerna application
 */
@@ -76,38 +105,56 @@ int main(int argc, char** argv)
 		}
 
 		// init common objects
-		KeyValueDatabase kvdb(opts.kvdbdir.string());
-		Readfeed readfeed(opts.feed_type, opts.readfiles, opts.num_proc_thread, opts.readb_dir, opts.is_paired);
+		KeyValueDatabase kvdb(opts.kvdbdir.string(), opts.is_wal, opts.is_kvdb_mem, opts.kvdb_mem_max, opts.kvdb_profile);
+		Readfeed readfeed(opts.feed_type, opts.readfiles, opts.num_proc_thread, opts.readb_dir, opts.is_paired, opts.num_chunks, opts.is_prescan, opts.is_io_uring);
+		readfeed.is_read_cache = opts.is_read_cache && opts.feed_type == FEED_TYPE::INDEXED;
+		if (std::size_t(readfeed.num_chunks) * readfeed.num_sense > KeyValueDatabase::MAX_READ_SLOTS) {
+			ERR("too many reads slots: ", readfeed.num_chunks * readfeed.num_sense, " The maximum is ",
+				KeyValueDatabase::MAX_READ_SLOTS, ". Use fewer threads or chunks");
+			exit(EXIT_FAILURE);
+		}
+		kvdb.init_mem(std::size_t(readfeed.num_chunks) * readfeed.num_sense,
+			readfeed.num_chunks > 0 ? readfeed.num_reads_tot / (std::size_t(readfeed.num_chunks) * readfeed.num_sense) : 0);
 		Readstats readstats(readfeed.num_reads_tot, readfeed.length_all, readfeed.min_read_len, readfeed.max_read_len, kvdb, opts);
+		// processing threads for all the phases and index parts. The spare one prefetches the next index part
+		ThreadPool tpool(opts.num_proc_thread + 1);
 
 		switch (opts.alirep)
 		{
 		case Runopts::ALIGN_REPORT::index_only:
 			break;
 		case Runopts::ALIGN_REPORT::align:
-			align(readfeed, readstats, index, kvdb, opts);
+			align(readfeed, readstats, index, kvdb, tpool, opts);
 			break;
 		case Runopts::ALIGN_REPORT::summary:
-			if (opts.is_otu_map || opts.is_denovo) denovo_stats(readfeed, readstats, kvdb, opts);
-			if (opts.is_otu_map) fill_otu_map(readfeed, readstats, kvdb, opts);
+			if (opts.is_otu_map || opts.is_denovo) denovo_stats(readfeed, readstats, kvdb, tpool, opts);
+			if (opts.is_otu_map) fill_otu_map(readfeed, readstats, kvdb, tpool, opts);
 			writeSummary(readstats, opts);
 			break;
 		case Runopts::ALIGN_REPORT::report:
-			writeReports(readfeed, readstats, kvdb, opts);
+			writeReports(readfeed, readstats, kvdb, tpool, opts);
 			break;
 		case Runopts::ALIGN_REPORT::alnsum:
-			align(readfeed, readstats, index, kvdb, opts);
-			if (opts.is_otu_map || opts.is_denovo) denovo_stats(readfeed, readstats, kvdb, opts);
-			if (opts.is_otu_map) fill_otu_map(readfeed, readstats, kvdb, opts);
+			if (is_fused(readfeed, readstats, opts)) {
+				align_fused(readfeed, readstats, index, kvdb, tpool, opts);
+				break;
+			}
+			align(readfeed, readstats, index, kvdb, tpool, opts);
+			if (opts.is_otu_map || opts.is_denovo) denovo_stats(readfeed, readstats, kvdb, tpool, opts);
+			if (opts.is_otu_map) fill_otu_map(readfeed, readstats, kvdb, tpool, opts);
 			writeSummary(readstats, opts);
 			break;
 		case Runopts::ALIGN_REPORT::all:
-			align(readfeed, readstats, index, kvdb, opts);
-			// TODO: combine processing otu map and reports to avoid double run through reads and refs (in this case only) 20201126
-			if (opts.is_otu_map || opts.is_denovo) denovo_stats(readfeed, readstats, kvdb, opts);
-			if (opts.is_otu_map) fill_otu_map(readfeed, readstats, kvdb, opts);
+			// '--fused' combines processing otu map and reports in the alignment pass
+			if (is_fused(readfeed, readstats, opts)) {
+				align_fused(readfeed, readstats, index, kvdb, tpool, opts);
+				break;
+			}
+			align(readfeed, readstats, index, kvdb, tpool, opts);
+			if (opts.is_otu_map || opts.is_denovo) denovo_stats(readfeed, readstats, kvdb, tpool, opts);
+			if (opts.is_otu_map) fill_otu_map(readfeed, readstats, kvdb, tpool, opts);
 			writeSummary(readstats, opts);
-			writeReports(readfeed, readstats, kvdb, opts);
+			writeReports(readfeed, readstats, kvdb, tpool, opts);
 			break;
 		}
 	}
@@ -135,6 +135,14 @@ void Runopts::opt_reads(const std::string &file)
 		exit(EXIT_FAILURE);
 	}
 
+	// stdin, see 'Readfeed::init_stream'
+	if (file == "-")
+	{
+		have_reads = true;
+		readfiles.push_back(file);
+		return;
+	}
+
 	// check file exists
 	auto fpath = std::filesystem::path(file);
 	auto fpath_a = std::filesystem::path(); // absolute path
@@ -168,6 +176,14 @@ void Runopts::opt_reads(const std::string &file)
 		exit(EXIT_FAILURE);
 	}
 
+	// named pipe - opening it here would block until a writer appears. Validated in 'Readfeed::init_stream'
+	if (std::filesystem::is_fifo(fpath_a))
+	{
+		have_reads = true;
+		readfiles.push_back(fpath_a.generic_string());
+		return;
+	}
+
 	// check the file can be read
 	std::ifstream ifs(fpath_a, std::ios_base::in | std::ios_base::binary);
 	if (!ifs.is_open())
@@ -1156,6 +1172,11 @@ void Runopts::opt_max_pos(const std::string &val)
 	}
 }
 
+void Runopts::opt_index_rc(const std::string &val)
+{
+	is_index_rc = true;
+}
+
 void Runopts::opt_readfeed(const std::string& val)
 {
 	FEED_TYPE ftype = static_cast<FEED_TYPE>(std::stoi(val));
@@ -1248,6 +1269,113 @@ void Runopts::opt_score_split(const std::string& val)
 	is_score_split = true;
 }
 
+void Runopts::opt_dedup(const std::string& val)
+{
+	if (val.size() == 0) {
+		dedup_max = 1000000;
+	}
+	else {
+		dedup_max = std::stoull(val);
+	}
+	INFO("using '", OPT_DEDUP, "' max cached sequences: ", dedup_max);
+} // ~Runopts::opt_dedup
+
+void Runopts::opt_xdrop(const std::string& val)
+{
+	if (val.size() == 0) {
+		ERR("Option '", OPT_XDROP, "' requires a positive integer e.g. 20");
+		exit(EXIT_FAILURE);
+	}
+	xdrop = std::stoi(val);
+	if (xdrop < 0) {
+		ERR("Option '", OPT_XDROP, "' requires a positive integer. Provided value: ", val);
+		exit(EXIT_FAILURE);
+	}
+} // ~Runopts::opt_xdrop
+
+void Runopts::opt_no_sw_prune(const std::string& val)
+{
+	is_sw_prune = false;
+}
+
+void Runopts::opt_no_skip_done(const std::string& val)
+{
+	is_skip_done = false;
+}
+
+void Runopts::opt_read_cache(const std::string& val)
+{
+	is_read_cache = true;
+}
+
+void Runopts::opt_chunks(const std::string& val)
+{
+	if (val.size() == 0) {
+		ERR("Option '", OPT_CHUNKS, "' requires a positive integer e.g. 4");
+		exit(EXIT_FAILURE);
+	}
+	auto num = std::stoi(val);
+	if (num < 1) {
+		ERR("Option '", OPT_CHUNKS, "' requires a positive integer. Provided value: ", val);
+		exit(EXIT_FAILURE);
+	}
+	num_chunks = static_cast<unsigned>(num);
+} // ~Runopts::opt_chunks
+
+void Runopts::opt_no_prescan(const std::string& val)
+{
+	is_prescan = false;
+}
+
+void Runopts::opt_io_uring(const std::string& val)
+{
+	is_io_uring = true;
+}
+
+void Runopts::opt_no_wal(const std::string& val)
+{
+	is_wal = false;
+}
+
+void Runopts::opt_kvdb_mem(const std::string& val)
+{
+	if (val.size() == 0) {
+		ERR("Option '", OPT_KVDB_MEM, "' requires a memory limit in MB e.g. 4096, or 0 for no limit");
+		exit(EXIT_FAILURE);
+	}
+	auto num = std::stoll(val);
+	if (num < 0) {
+		ERR("Option '", OPT_KVDB_MEM, "' requires a non-negative integer. Provided value: ", val);
+		exit(EXIT_FAILURE);
+	}
+	is_kvdb_mem = true;
+	kvdb_mem_max = static_cast<uint64_t>(num) << 20;
+} // ~Runopts::opt_kvdb_mem
+
+void Runopts::opt_kvdb_profile(const std::string& val)
+{
+	if (val == "default")
+		kvdb_profile = KVDB_PROFILE::DEFAULT;
+	else if (val == "bulk")
+		kvdb_profile = KVDB_PROFILE::BULK;
+	else if (val == "small")
+		kvdb_profile = KVDB_PROFILE::SMALL;
+	else {
+		ERR("Option '", OPT_KVDB_PROFILE, "' takes one of: default, bulk, small. Provided value: ", val);
+		exit(EXIT_FAILURE);
+	}
+} // ~Runopts::opt_kvdb_profile
+
+void Runopts::opt_kvdb_ingest(const std::string& val)
+{
+	is_kvdb_ingest = true;
+}
+
+void Runopts::opt_fused(const std::string& val)
+{
+	is_fused = true;
+}
+
 /* 
  * called from validate
  */
@@ -1295,6 +1423,11 @@ void Runopts::validate_kvdbdir()
 
 	INFO("Key-value DB location " , std::filesystem::absolute(kvdbdir));
 
+	if (is_kvdb_mem && (ALIGN_REPORT::summary == alirep || ALIGN_REPORT::report == alirep)) {
+		WARN("'", OPT_KVDB_MEM, "' is ignored as the reports use the results of a previous run stored in the key-value database");
+		is_kvdb_mem = false;
+	}
+
 	if (std::filesystem::exists(kvdbdir))
 	{
 		// dir exists and is empty
@@ -1310,9 +1443,16 @@ void Runopts::validate_kvdbdir()
 		{
 			// TODO: Store some metadata in DB to verify the alignment.
 			// kvdb.verify()
-			if (ALIGN_REPORT::align == alirep || ALIGN_REPORT::all == alirep || ALIGN_REPORT::alnsum == alirep)
+			if ((ALIGN_REPORT::align == alirep || ALIGN_REPORT::all == alirep || ALIGN_REPORT::alnsum == alirep)
+				&& std::filesystem::exists(kvdbdir / "CURRENT") && !is_kvdb_mem)
+			{
+				// a RocksDB - verified against the progress journal when the alignment starts
+				INFO("KVDB directory: ", std::filesystem::absolute(kvdbdir), " is not empty. Will resume the alignment",
+					" if it was started by the same command on the same files");
+				is_kvdb_resume = true;
+			}
+			else if (ALIGN_REPORT::align == alirep || ALIGN_REPORT::all == alirep || ALIGN_REPORT::alnsum == alirep)
 			{
-				// if (kvdb.verify()) // TODO
 				// output the listing
 				std::stringstream ss;
 				for (auto& subpath : std::filesystem::directory_iterator(kvdbdir))
@@ -1342,8 +1482,8 @@ void Runopts::validate_kvdbdir()
   validate split reads directory
 */
 void Runopts::validate_readb_dir() {
-	const auto SR = "split reads";
-	const auto SR_DIR = "split reads directory";
+	const auto SR = "reads DB";
+	const auto SR_DIR = "reads DB directory";
 	if (readb_dir.empty()) {
 		if (workdir.empty()) {
 			INFO("'", OPT_WORKDIR, "' option was not provided. Using USERDIR as the location for the ",SR);
@@ -1567,8 +1707,7 @@ void Runopts::validate()
 {
 	validate_kvdbdir();
 	validate_idxdir();
-	if (feed_type == FEED_TYPE::SPLIT_READS)
-		validate_readb_dir();
+	validate_readb_dir(); // split reads, or the reads index and read cache of the INDEXED feed
 	validate_aligned_pfx(); // there is always some output like log => validate
 	if (is_other) {
 		validate_other_pfx();
@@ -1755,6 +1894,18 @@ void Runopts::validate()
 		if (is_otu_map) min_cov = 0.97;
 		else min_cov = 0;
 	}
+
+	// CIGAR (SW traceback) is only used by the SAM and Blast reports, and by the ID/COV
+	// calculation for OTU map and de novo. If none of these is requested, the alignment 
+	// can run score-only SW. Only done when the reports are generated in this same run,
+	// otherwise a later '-task 2' could ask for the CIGAR that was never stored.
+	if (alirep == ALIGN_REPORT::all 
+		&& !(is_sam || is_blast || is_otu_map || is_denovo) 
+		&& min_id <= 0 && min_cov <= 0)
+	{
+		is_cigar = false;
+		INFO("No output requires CIGAR. Using score-only Smith-Waterman alignment");
+	}
 } // ~Runopts::validate
 
 /* 
@@ -35,6 +35,7 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include <thread>
 #include <filesystem>
 #include <cmath>  // std::floor
+#include <algorithm> // std::sort
 
 #include "common.hpp"
 #include "otumap.h"
@@ -43,12 +44,13 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include "references.hpp"
 #include "refstats.hpp"
 #include "readstats.hpp"
+#include "ThreadPool.hpp"
 
 OtuMap::OtuMap(int numThreads) : mapv(numThreads), total_otu(0) {}
 
-void OtuMap::push(int idx, std::string& ref_seq_str, std::string& read_seq_str)
+void OtuMap::push(int idx, std::string& ref_seq_str, std::string& read_seq_str, std::size_t readfile_idx, std::size_t read_num)
 {
-	mapv[idx][ref_seq_str].emplace_back(read_seq_str);
+	mapv[idx][ref_seq_str].emplace_back(OtuRead{ readfile_idx, read_num, read_seq_str });
 }
 
 void OtuMap::merge()
@@ -65,6 +67,14 @@ void OtuMap::merge()
 		}
 		mapv[i].clear();
 	}
+	// the reads of a group in the order of the feed, whichever thread or pass ('--fused') added them
+	if (mapv.size() > 0) {
+		for (auto& apair : mapv[0]) {
+			std::sort(apair.second.begin(), apair.second.end(), [](OtuRead const& a, OtuRead const& b) {
+				return a.readfile_idx == b.readfile_idx ? a.read_num < b.read_num : a.readfile_idx < b.readfile_idx;
+			});
+		}
+	}
 	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - starts;
 	INFO_NS(" ... done in [", elapsed.count(), "] sec\n");
 }
@@ -86,7 +96,7 @@ void OtuMap::write()
 				ofs << apair.first << "\t"; // ref
 				unsigned i = 0;
 				for (auto const& aread : apair.second) {
-					ofs << aread;
+					ofs << aread.id;
 					if (i < apair.second.size() - 1)
 						ofs << "\t";
 					++i;
@@ -125,6 +135,45 @@ size_t OtuMap::count_otu()
 	return num_otu;
 }
 
+/*
+ * add the read to the OTU groups of the references it aligns on with passing %ID and %COV
+ * Only the alignments on the currently loaded reference part are used. Expects the read in 04 alphabet
+ *
+ * @return count of the groups the read was added to
+ */
+unsigned push_otu(int id, OtuMap& otumap, Read& read, References& refs, Runopts& opts)
+{
+	unsigned count = 0;
+	if (read.c_yid_ycov == 0)
+		return count;
+
+	for (auto const& align: read.alignment.alignv) {
+		// process alignments that match currently loaded reference part
+		if (align.index_num == refs.num && align.part == refs.part) {
+			auto miss_gap_match = read.calc_miss_gap_match(refs, align);
+			auto idr = std::floor(std::get<3>(miss_gap_match) * 1000.0 + 0.5) * 0.001; // round to 3 decimal
+			auto covr = std::floor(std::get<4>(miss_gap_match) * 1000.0 + 0.5) * 0.001;
+			auto is_id = idr >= opts.min_id;
+			auto is_cov = covr >= opts.min_cov;
+			if (is_id && is_cov) {
+				// get reference sequence identifier
+				auto refhead = refs.buffer[align.ref_num].header;
+				auto ref_seq_str = refhead.substr(0, refhead.find(' '));
+				// left trim '>' or '@'
+				ref_seq_str.erase(ref_seq_str.begin(),
+					std::find_if(ref_seq_str.begin(), ref_seq_str.end(),
+						[](auto ch) {return !(ch == FASTA_HEADER_START || ch == FASTQ_HEADER_START);}));
+
+				// get read identifier
+				std::string read_seq_str = read.getSeqId();
+				otumap.push(id, ref_seq_str, read_seq_str, read.readfile_idx, read.read_num); // thread safe
+				++count;
+			}
+		}
+	} // ~for all alignments of a read
+	return count;
+} // ~push_otu
+
 /*
   runs in a thread
 */
@@ -137,53 +186,42 @@ void fill_otu_map2(int id, OtuMap& otumap, Readfeed& readfeed, References& refs,
 	//unsigned c_nid_ycov = 0;
 	//unsigned c_nid_ncov = 0;
 	std::string readstr;
+	std::vector<Read> block; // reads read ahead to be looked up in the DB at once
 
 	if (opts.dbg_level == 2)
 		INFO("OTU map thread ", id, " : ", std::this_thread::get_id(), " started");
 
-	for (;readfeed.next(id, readstr);)
+	// the order of the reads does not matter here - pull the chunks from the shared queue
+	for (unsigned chunk = 0; readfeed.next_chunk(chunk);)
 	{
+		// all senses of the chunk. Interleaved paired: the FWD stream yields both
+		for (int idx = chunk * readfeed.num_sense; idx < static_cast<int>((chunk + 1) * readfeed.num_sense); ++idx)
 		{
-			Read read(readstr);
-			read.init(opts);
-			read.load_db(kvdb);
-
-			if (!read.isValid)
-				continue;
-
-			if (read.is03) read.flip34();
-			if (read.c_yid_ycov > 0) {
-				for (auto const& align: read.alignment.alignv) {
-					// process alignments that match currently loaded reference part
-					if (align.index_num == refs.num && align.part == refs.part) {
-						auto miss_gap_match = read.calc_miss_gap_match(refs, align);
-						auto idr = std::floor(std::get<3>(miss_gap_match) * 1000.0 + 0.5) * 0.001; // round to 3 decimal
-						auto covr = std::floor(std::get<4>(miss_gap_match) * 1000.0 + 0.5) * 0.001;
-						auto is_id = idr >= opts.min_id;
-						auto is_cov = covr >= opts.min_cov;
-						if (is_id && is_cov) {
-							// get reference sequence identifier
-							auto refhead = refs.buffer[align.ref_num].header;
-							auto ref_seq_str = refhead.substr(0, refhead.find(' '));
-							// left trim '>' or '@'
-							ref_seq_str.erase(ref_seq_str.begin(),
-								std::find_if(ref_seq_str.begin(), ref_seq_str.end(),
-									[](auto ch) {return !(ch == FASTA_HEADER_START || ch == FASTQ_HEADER_START);}));
-
-							// get read identifier
-							std::string read_seq_str = read.getSeqId();
-							otumap.push(id, ref_seq_str, read_seq_str); // thread safe
-							++c_yid_ycov;
-						}
-					}
+			for (bool is_more = true; is_more;)
+			{
+				block.clear();
+				while (block.size() < KeyValueDatabase::GET_BATCH && (is_more = readfeed.next(idx, readstr)))
+				{
+					block.emplace_back(Read(readstr));
+					block.back().init(opts);
+					readstr.resize(0);
 				}
-			} // ~for all alignments of a read
+				Read::load_db(kvdb, block);
+
+				for (auto& read: block)
+				{
+					if (!read.isValid)
+						continue;
 
-			readstr.resize(0);
-			++c_reads;
-			if (read.is_hit) ++c_aligned;
-		} // ~ a read scope ends
-	} // ~for all reads
+					if (read.is03) read.flip34();
+					c_yid_ycov += push_otu(id, otumap, read, refs, opts);
+
+					++c_reads;
+					if (read.is_hit) ++c_aligned;
+				} // ~for block
+			} // ~for all reads
+		}
+	} // ~for chunks
 
 	INFO("OTU map thread ", id, " : ", std::this_thread::get_id(),
 		" done. All reads: ", c_reads, ". aligned reads: ", c_aligned, " c_yid_ycov: ", c_yid_ycov);
@@ -192,6 +230,7 @@ void fill_otu_map2(int id, OtuMap& otumap, Readfeed& readfeed, References& refs,
 void fill_otu_map(Readfeed& readfeed, 
                     Readstats& readstats, 
                     KeyValueDatabase& kvdb, 
+                    ThreadPool& tpool, 
                     Runopts& opts, 
                     bool is_write)
 {
@@ -212,9 +251,6 @@ void fill_otu_map(Readfeed& readfeed,
 		readfeed.init_reading(); // prepare readfeed
 		//}
 
-		std::vector<std::thread> tpool;
-		tpool.reserve(numThreads);
-
 		Refstats refstats(opts, readstats);
 		OtuMap otumap(numThreads);
 		References refs;
@@ -240,16 +276,12 @@ void fill_otu_map(Readfeed& readfeed,
 				//	 opts.feed_type == FEED_TYPE::INDEXED_GZ ||
 				//	 opts.feed_type == FEED_TYPE::INDEXED_FLAT) {
 				for (int i = 0; i < numThreads; ++i) {
-					tpool.emplace_back(std::thread(fill_otu_map2, i, std::ref(otumap),
-						std::ref(readfeed), std::ref(refs),	std::ref(kvdb), std::ref(opts)));
+					tpool.addJob([&, i] { fill_otu_map2(i, otumap, readfeed, refs, kvdb, opts); });
 				}
 				//}
 
 				// wait till processing is done on one index part
-				//tpool.waitAll(); 
-				for (auto& thr: tpool) {
-					thr.join();
-				}
+				tpool.waitAll();
 
 				refs.unload();
 				//read_queue.reset();
@@ -259,7 +291,6 @@ void fill_otu_map(Readfeed& readfeed,
 
 				refs.unload();
 				INFO_MEM("References unloaded.");
-				tpool.clear();
 				// rewind for the next index
 				readfeed.rewind_in();
 				readfeed.init_vzlib_in();
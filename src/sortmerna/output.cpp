@@ -50,6 +50,7 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include "refstats.hpp"
 #include "readsqueue.hpp"
 #include "readfeed.hpp"
+#include "ThreadPool.hpp"
 
 // forward
 class Read;
@@ -74,6 +75,38 @@ void Output::init(Readfeed& readfeed, Runopts& opts)
 } // ~Output::init
 
 
+/*
+ * add a read (pair of reads if paired) to the reports
+ */
+void report_reads(const uint32_t& id, std::vector<Read>& reads, References& refs, Refstats& refstats, Output& output, Runopts& opts)
+{
+	// only needs one loop through all reads - reference file is not used
+	if (refs.num == 0 && refs.part == 0) {
+		if (opts.is_fastx)
+			output.fastx.append(id, reads, opts, false);
+
+		if (opts.is_other) 
+			output.fx_other.append(id, reads, opts, false);
+
+		if (opts.is_denovo) {
+			bool is_dn = opts.is_paired 
+				? (reads[0].n_denovo > 0 && reads[0].c_yid_ycov == 0
+					&& reads[0].n_yid_ncov == 0 && reads[0].n_nid_ycov == 0) 
+				|| (reads[1].n_denovo > 0 && reads[1].c_yid_ycov == 0
+					&& reads[1].n_yid_ncov == 0 && reads[1].n_nid_ycov == 0) 
+				: (reads[0].n_denovo > 0 && reads[0].c_yid_ycov == 0
+						&& reads[0].n_yid_ncov == 0 && reads[0].n_nid_ycov == 0);
+			if (is_dn)
+				output.denovo.append(id, reads, opts, false);
+		}
+	}
+
+	for (auto& read: reads) {
+		if (opts.is_blast) output.blast.append(id, read, refs, refstats, opts);
+		if (opts.is_sam) output.sam.append(id, read, refs, opts);
+	} // ~for reads
+} // ~report_reads
+
 /*
  * called in a thread
 */
@@ -91,64 +124,47 @@ void report(const uint32_t& id,
 	uint16_t num_reads = opts.is_paired ? 2 : 1; // i.e. max 2
 	std::string readstr;
 	std::vector<Read> reads; // two reads if paired, a single read otherwise
+	KeyValueDatabase::Scanner scanner(kvdb); // the results in the reads order of this thread
 
 	INFO_MEM("Report Processor: ", id, " thread: ", std::this_thread::get_id(), " started.");
 	//auto start = std::chrono::high_resolution_clock::now();
 
-	for (bool isDone = false; !isDone;)
+	// the chunks of this thread in the reads file order (not pulled from the shared queue),
+	// so that the per-thread report files merge into the original order
+	auto chunk_end = (id + 1) * readfeed.chunks_per_split;
+	for (auto chunk = id * readfeed.chunks_per_split; chunk < chunk_end; ++chunk)
 	{
-		reads.clear();
-		uint32_t idx = id * readfeed.num_sense; // index into split_files array
-		for (uint16_t i = 0; i < num_reads; ++i)
+		for (bool isDone = false; !isDone;)
 		{
-			if (readfeed.next(idx, readstr))
+			reads.clear();
+			uint32_t idx = chunk * readfeed.num_sense; // index into split_files array
+			for (uint16_t i = 0; i < num_reads; ++i)
 			{
-				reads.emplace_back(Read(readstr));
-				reads[i].init(opts);
-				reads[i].load_db(kvdb);
-				readstr.resize(0);
-				++countReads;
-			}
-			else {
-				isDone = true;
-			}
-			if (opts.is_paired) idx ^= 1; // switch fwd-rev
-		}
-
-		if (!isDone) 
-		{
-			if (reads.back().isEmpty || !reads.back().isValid) {
-				++num_invalid;
-				continue;
+				if (readfeed.next(idx, readstr))
+				{
+					reads.emplace_back(Read(readstr));
+					reads[i].init(opts);
+					reads[i].load_db(scanner);
+					readstr.resize(0);
+					++countReads;
+				}
+				else {
+					isDone = true;
+				}
+				if (opts.is_paired) idx ^= 1; // switch fwd-rev
 			}
 
-			// only needs one loop through all reads - reference file is not used
-			if (refs.num == 0 && refs.part == 0) {
-				if (opts.is_fastx)
-					output.fastx.append(id, reads, opts, isDone);
-
-				if (opts.is_other) 
-					output.fx_other.append(id, reads, opts, isDone);
-
-				if (opts.is_denovo) {
-					bool is_dn = opts.is_paired 
-						? (reads[0].n_denovo > 0 && reads[0].c_yid_ycov == 0
-							&& reads[0].n_yid_ncov == 0 && reads[0].n_nid_ycov == 0) 
-						|| (reads[1].n_denovo > 0 && reads[1].c_yid_ycov == 0
-							&& reads[1].n_yid_ncov == 0 && reads[1].n_nid_ycov == 0) 
-						: (reads[0].n_denovo > 0 && reads[0].c_yid_ycov == 0
-								&& reads[0].n_yid_ncov == 0 && reads[0].n_nid_ycov == 0);
-					if (is_dn)
-						output.denovo.append(id, reads, opts, isDone);
+			if (!isDone) 
+			{
+				if (reads.back().isEmpty || !reads.back().isValid) {
+					++num_invalid;
+					continue;
 				}
-			}
 
-			for (auto& read: reads) {
-				if (opts.is_blast) output.blast.append(id, read, refs, refstats, opts);
-				if (opts.is_sam) output.sam.append(id, read, refs, opts);
-			} // ~for reads
-		}
-	} // ~for
+				report_reads(id, reads, refs, refstats, output, opts);
+			}
+		} // ~for
+	} // ~for chunks
 
 	//std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start; // ~20 sec Debug/Win
 	INFO_MEM("Report processor: ", id, " thread: ", std::this_thread::get_id(), " done. Processed reads: ", countReads, 
@@ -165,8 +181,44 @@ void report(const uint32_t& id,
 } // ~report
 
 
+/*
+ * finish the compressed streams, close and merge the per-thread report files
+ */
+void closeReports(Readfeed& readfeed, Output& output, Runopts& opts)
+{
+	if (opts.is_fastx) {
+		output.fastx.finish_deflate();
+		output.fastx.closef(opts.dbg_level);
+		output.fastx.merge(readfeed.num_splits, output.fastx.getBase().num_out, opts.dbg_level);
+	}
+	if (opts.is_other) {
+		output.fx_other.finish_deflate();
+		output.fx_other.closef(opts.dbg_level);
+		output.fx_other.merge(readfeed.num_splits, output.fx_other.getBase().num_out, opts.dbg_level);
+	}
+	if (opts.is_blast) {
+		output.blast.finish_deflate();
+		output.blast.closef(opts.dbg_level);
+		output.blast.merge(readfeed.num_splits, 1, opts.dbg_level);
+		if (opts.dbg_level == 2)
+			INFO("yid_ycov: ", output.blast.n_yid_ycov, 
+				" yid_ncov: ", output.blast.n_yid_ncov, 
+				" nid_ycov: ", output.blast.n_nid_ycov, 
+				" denovo: ", output.blast.n_denovo);
+	}
+	if (opts.is_sam) {
+		output.sam.finish_deflate();
+		output.sam.closef(opts.dbg_level);
+		output.sam.merge(readfeed.num_splits, 1, opts.dbg_level);
+	}
+	if (opts.is_denovo) {
+		output.denovo.closef(opts.dbg_level);
+		output.denovo.merge(readfeed.num_splits, output.denovo.getBase().num_out, opts.dbg_level);
+	}
+} // ~closeReports
+
 // called from main.
-void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, Runopts& opts)
+void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts)
 {
 	INFO("=== Report generation starts ===");
 	auto start = std::chrono::high_resolution_clock::now();
@@ -178,12 +230,10 @@ void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kv
 	readfeed.init_reading(); // prepare readfeed
 	//}
 
-	//ThreadPool tpool(N_READ_THREADS + N_PROC_THREADS);
-	std::vector<std::thread> tpool;
-	tpool.reserve(nthreads);
-
 	bool is_db = readstats.restoreFromDb(kvdb);
 	if (is_db) INFO("Restored Readstats from DB: ", is_db);
+	if (opts.is_sam || opts.is_blast)
+		readstats.check_cigar(opts.is_sam ? "the SAM report" : "the BLAST report", opts);
 
 	Refstats refstats(opts, readstats);
 	References refs;
@@ -208,15 +258,15 @@ void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kv
 
 			// start processing threads
 			//if (opts.feed_type == FEED_TYPE::SPLIT_READS || opts.feed_type == FEED_TYPE::INDEXED_GZ || opts.feed_type == FEED_TYPE::INDEXED_FLAT) {
-			for (uint32_t i = 0; i < nthreads; ++i) {
-				tpool.emplace_back(std::thread(report, i, std::ref(readfeed),
-					std::ref(refs), std::ref(refstats), std::ref(kvdb), std::ref(output), std::ref(opts)));
+			// reads stream read by this pass: the records go to whichever thread asks first, so a single thread
+			// writes the reports in the stream order. The replaying passes give each thread its own range
+			auto num_threads = readfeed.is_stream && !readfeed.is_stream_replay ? 1 : nthreads;
+			for (uint32_t i = 0; i < num_threads; ++i) {
+				tpool.addJob([&, i] { report(i, readfeed, refs, refstats, kvdb, output, opts); });
 			}
 			//}
 			// wait till processing is done
-			for (uint32_t i = 0; i < tpool.size(); ++i) {
-				tpool[i].join();
-			}
+			tpool.waitAll();
 
 			elapsed = std::chrono::high_resolution_clock::now() - start_i; // index processing done
 			INFO("done reference ", ref_idx, " part: ", idx_part + 1, " in ", elapsed.count(), " sec");
@@ -226,7 +276,6 @@ void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kv
 			//read_queue.reset();
 			elapsed = std::chrono::high_resolution_clock::now() - start_i;
 			INFO_MEM("references unloaded in ", elapsed.count(), " sec");
-			tpool.clear();
 			// rewind for the next index
 			readfeed.rewind_in();
 			readfeed.init_vzlib_in();
@@ -236,36 +285,7 @@ void writeReports(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kv
 		if (!opts.is_blast && !opts.is_sam)	break;
 	} // ~for(ref_idx)
 
-	//output.closefiles();
-	if (opts.is_fastx) {
-		output.fastx.finish_deflate();
-		output.fastx.closef(opts.dbg_level);
-		output.fastx.merge(readfeed.num_splits, output.fastx.getBase().num_out, opts.dbg_level);
-	}
-	if (opts.is_other) {
-		output.fx_other.finish_deflate();
-		output.fx_other.closef(opts.dbg_level);
-		output.fx_other.merge(readfeed.num_splits, output.fx_other.getBase().num_out, opts.dbg_level);
-	}
-	if (opts.is_blast) {
-		output.blast.finish_deflate();
-		output.blast.closef(opts.dbg_level);
-		output.blast.merge(readfeed.num_splits, 1, opts.dbg_level);
-		if (opts.dbg_level == 2)
-			INFO("yid_ycov: ", output.blast.n_yid_ycov, 
-				" yid_ncov: ", output.blast.n_yid_ncov, 
-				" nid_ycov: ", output.blast.n_nid_ycov, 
-				" denovo: ", output.blast.n_denovo);
-	}
-	if (opts.is_sam) {
-		output.sam.finish_deflate();
-		output.sam.closef(opts.dbg_level);
-		output.sam.merge(readfeed.num_splits, 1, opts.dbg_level);
-	}
-	if (opts.is_denovo) {
-		output.denovo.closef(opts.dbg_level);
-		output.denovo.merge(readfeed.num_splits, output.denovo.getBase().num_out, opts.dbg_level);
-	}
+	closeReports(readfeed, output, opts);
 
 	elapsed = std::chrono::high_resolution_clock::now() - start;
 	INFO("=== done Reports in ", elapsed.count(), " sec ===\n");
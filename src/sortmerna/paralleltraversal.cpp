@@ -89,6 +89,10 @@ void traverse
 		bool isLastStrand
 	)
 {
+	if (read.lastIndex != index.index_num || read.lastPart != index.part) {
+		read.is_part_hit = false; // the Readstats changes of a previous part
+		read.part_db_moves.clear();
+	}
 	read.lastIndex = index.index_num;
 	read.lastPart = index.part;
 
@@ -67,9 +67,12 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
  * performs the alignment
  */
 
+#include <array>
 #include <chrono>
 #include <thread> // std::this_thread
 #include <cmath> // std::floor
+#include <filesystem>
+#include <memory> // std::unique_ptr
 
 #include "processor.hpp"
 #include "read.hpp"
@@ -79,103 +82,291 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include "readstats.hpp"
 #include "refstats.hpp"
 #include "options.hpp"
+#include "aligncache.hpp"
+#include "journal.hpp"
+#include "output.hpp"
+#include "otumap.h"
+#include "summary.hpp"
+#include "ThreadPool.hpp"
 //#include "readsqueue.hpp"
 
 // forward
 void traverse(Runopts& opts, Index& index, References& refs, Readstats& readstats, Refstats& refstats, Read& read, bool isLastStrand);
 
+/*
+ * count the alignments of the read on the loaded reference part by passing/failing
+ * the %ID and %COV thresholds. Expects the read in 04 alphabet
+ */
+static void classify_alignments(Read& read, References& refs, Readstats& readstats, Runopts& opts)
+{
+	for (auto const& align : read.alignment.alignv) {
+		if (align.index_num == refs.num	&& align.part == refs.part)	{
+			auto miss_gap_match = read.calc_miss_gap_match(refs, align);
+			auto idr = std::floor(std::get<3>(miss_gap_match) * 1000.0 + 0.5) / 1000.0; // round to 3 decimal
+			auto covr = std::floor(std::get<4>(miss_gap_match) * 1000.0 + 0.5) / 1000.0;
+			auto is_id = idr >= opts.min_id;
+			auto is_cov = covr >= opts.min_cov;
+			//auto is_id = std::get<3>(miss_gap_match) >= opts.min_id;
+			//auto is_cov = std::get<4>(miss_gap_match)>= opts.min_cov;
+			if (is_id && is_cov) {
+				++read.c_yid_ycov;
+				readstats.n_yid_ycov.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (is_id) {
+				++read.n_yid_ncov;
+				readstats.n_yid_ncov.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (is_cov) {
+				++read.n_nid_ycov;
+				readstats.n_nid_ycov.fetch_add(1, std::memory_order_relaxed);
+			}
+			else {
+				++read.n_denovo;
+				readstats.num_denovo.fetch_add(1, std::memory_order_relaxed); // neither ID nor COV
+			}
+		}
+	}
+} // ~classify_alignments
+
+/*
+ * '--fused' post-processing of the reads in an alignment thread. Collects the reads
+ * of a group (a pair if paired) and runs on the group what the separate passes
+ * 'denovo_stats', 'fill_otu_map' and 'writeReports' would do on it after reading it back
+ * from the DB. Only valid with a single index part, so that the results of a read
+ * are final once it is aligned.
+ */
+class FusedRun {
+public:
+	FusedRun(int id, FusedPass& fused, References& refs, Refstats& refstats, Readstats& readstats,
+		KeyValueDatabase::Writer& kvdb_writer, Runopts& opts)
+		: id(id), fused(fused), refs(refs), refstats(refstats), readstats(readstats), kvdb_writer(kvdb_writer), opts(opts),
+		num_reads(opts.is_paired ? 2 : 1) {}
+
+	/*
+	 * @param readstr  the read as fed
+	 * @param bin      the read results as stored in the DB. Empty - no results
+	 */
+	void add(std::string& readstr, const std::string& bin)
+	{
+		reads.emplace_back(Read(readstr));
+		reads.back().init(opts);
+		reads.back().fromBinString(bin);
+		if (reads.size() < num_reads)
+			return;
+
+		if (!(reads.back().isEmpty || !reads.back().isValid)) {
+			for (auto& read: reads) {
+				if (read.is03) read.flip34();
+				if (fused.is_denovo_stats) {
+					classify_alignments(read, refs, readstats, opts);
+					kvdb_writer.put(read.db_key(), read.toBinString()); // overrides the alignment results
+				}
+				if (fused.otumap)
+					push_otu(id, *fused.otumap, read, refs, opts);
+			}
+			if (fused.output)
+				report_reads(id, reads, refs, refstats, *fused.output, opts);
+		}
+		reads.clear();
+	}
+
+	void clear() { reads.clear(); }
+
+private:
+	int id;
+	FusedPass& fused;
+	References& refs;
+	Refstats& refstats;
+	Readstats& readstats;
+	KeyValueDatabase::Writer& kvdb_writer;
+	Runopts& opts;
+	std::size_t num_reads;
+	std::vector<Read> reads; // two reads if paired, a single read otherwise
+}; // ~class FusedRun
+
 /*
 * performs the alignment
 *  runs in a thread.  align -> align2
 *  @param id
 *  @param is_last_idx  flags the last index is being processed
+*  @param fused  '--fused' post-processing of the aligned reads. Null - alignment only
 */
 void align2(int id, Readfeed& readfeed, Readstats& readstats, 
-			Index& index, References& refs, Refstats& refstats, KeyValueDatabase& kvdb, Runopts& opts)
+			Index& index, References& refs, Refstats& refstats, KeyValueDatabase& kvdb, AlignCache& cache, Runopts& opts,
+			FusedPass* fused)
 {
 	unsigned num_all = 0; // all reads this processor sees
 	unsigned num_skipped = 0; // reads already processed i.e. results found in Database
+	unsigned num_dup = 0; // exact duplicates that reused the cached alignment
+	unsigned num_resumed = 0; // reads aligned on this part by the run resumed from
 	unsigned num_hit = 0; // count of reads with read.hit = true found by a single thread - just for logging
 	std::string readstr;
+	KeyValueDatabase::Writer kvdb_writer(kvdb, opts.is_kvdb_ingest); // flushed at the chunk ends with SSTs, otherwise by size and on the thread exit
+	std::unique_ptr<FusedRun> fused_run;
+	if (fused)
+		fused_run = std::make_unique<FusedRun>(id, *fused, refs, refstats, readstats, kvdb_writer, opts);
 
 	auto starts = std::chrono::high_resolution_clock::now();
 	INFO("Processor ", id, " thread ", std::this_thread::get_id(), " started");
-	int idx = id * readfeed.num_sense; // index into split files array
-	for (; readfeed.next(idx, readstr);)
+	unsigned num_chunks = 0; // chunks taken by this processor
+	// pull chunks from the shared queue until none left, so that a thread getting slow
+	// e.g. rRNA rich reads does not hold the others waiting on 'join'.
+	// '--fused': the chunks of this thread in the reads file order like 'report' does,
+	// so that the per-thread report files merge into the original order
+	auto chunk_end = (id + 1) * readfeed.chunks_per_split;
+	for (unsigned chunk = fused ? id * readfeed.chunks_per_split : 0;
+		fused ? chunk < chunk_end : readfeed.next_chunk(chunk); ++chunk, ++num_chunks)
 	{
+		int idx = chunk * readfeed.num_sense; // index into split files array
+		if (fused_run) fused_run->clear(); // drop an incomplete pair of the previous chunk
+		// switch FWD-REV also on the skipped reads. Each sense is read to its end, also when the other
+		// one ends first e.g. paired files with different numbers of reads, so that all the reads
+		// are aligned and the slots are done (read cache finished, counts reconciled)
+		const unsigned num_alt = opts.is_paired ? 2 : 1;
+		std::array<bool, 2> is_end = { false, num_alt < 2 };
+		for (unsigned sense = 0; !(is_end[0] && is_end[1]); sense = (sense + 1) % num_alt)
 		{
-			Read read(readstr);
-			read.init(opts);
-			read.is_too_short = read.sequence.size() < refstats.lnwin[index.index_num];
-
-			if (read.is_too_short) {
-				read.isValid = false;
-				readstats.num_short.fetch_add(1, std::memory_order_relaxed);
+			if (is_end[sense])
+				continue;
+			if (!readfeed.next(idx + sense, readstr)) {
+				is_end[sense] = true;
+				if (fused_run) fused_run->clear(); // an incomplete pair
+				continue;
 			}
+			// the reads past the end of the other sense have no mate to be reported with
+			FusedRun* frun = num_alt == 2 && is_end[sense ^ 1] ? nullptr : fused_run.get();
+			{
+				Read read(readstr);
+				read.init(opts);
+				read.is_too_short = read.sequence.size() < refstats.lnwin[index.index_num];
 
-			if (read.isValid) {
-				read.load_db(kvdb);
-			}
+				if (read.is_too_short) {
+					read.isValid = false;
+					readstats.num_short.fetch_add(1, std::memory_order_relaxed);
+				}
 
-			if (read.isEmpty || !read.isValid || read.is_done) {
-				if (read.is_done) {
-					++num_skipped;
+				if (read.isValid) {
+					read.load_db(kvdb);
 				}
-				//INFO("Skpping read ID: ", read.id);
-				continue;
-			}
 
-			// search the forward and/or reverse strands depending on Run options
-			int num_strands = 0;
-			bool search_single_strand = opts.is_forward ^ opts.is_reverse; // search only a single strand
-			if (search_single_strand)
-				num_strands = 1; // only search the forward xor reverse strand
-			else
-				num_strands = 2; // search both strands. The default when neither -F or -R were specified
+				// resumed run: the read was aligned on this part before the run stopped. Aligning it again
+				// would duplicate its alignments. Only the statistics since the last journal entry are lost
+				if (read.isValid && read.is_aligned_on(index.index_num, index.part)) {
+					read.replay_part_stats(readstats.num_aligned, readstats.reads_matched_per_db);
+					if (read.is_done)
+						readfeed.set_done(read.readfile_idx, read.read_num);
+					if (read.is_hit) ++num_hit;
+					if (frun) frun->add(readstr, read.toBinString());
+					++num_resumed;
+					continue;
+				}
 
-			//                                                  |- stop if read was aligned on FWD strand
-			for (int count = 0; count < num_strands && !read.is_done; ++count)
-			{
-				if ((search_single_strand && opts.is_reverse) || count == 1)
+				if (read.isEmpty || !read.isValid || read.is_done) {
+					if (read.is_done) {
+						readfeed.set_done(read.readfile_idx, read.read_num); // e.g. restored from a previous run
+						++num_skipped;
+					}
+					//INFO("Skpping read ID: ", read.id);
+					if (frun) frun->add(readstr, "");
+					continue;
+				}
+
+				// exact duplicate of a read already aligned on this index part - reuse its results.
+				// Only reads without results from the previous index parts are cached, so that
+				// identical sequences always start from the same (empty) alignment state.
+				bool is_cacheable = cache.is_enabled() && !read.isRestored;
+				AlignCache::Entry cached;
+				if (is_cacheable && cache.find(read.sequence, cached))
 				{
-					if (!read.reversed)
-						read.revIntStr();
+					if (cached.is_hit) {
+						++num_hit;
+						readstats.num_aligned.fetch_add(1, std::memory_order_relaxed);
+						++readstats.reads_matched_per_db[index.index_num];
+					}
+					if (cached.is_new_hit)
+						kvdb_writer.put(read.db_key(), cached.bin);
+					if (cached.is_done)
+						readfeed.set_done(read.readfile_idx, read.read_num);
+					if (frun)
+						frun->add(readstr, cached.is_new_hit ? cached.bin : std::string());
+					++num_dup;
 				}
-				
-				traverse(opts, index, refs, readstats, refstats, read, search_single_strand || count == 1); // 'paralleltraversal.cpp'
-				read.id_win_hits.clear(); // bug 46
-			}
+				else
+				{
+					// search the forward and/or reverse strands depending on Run options
+					int num_strands = 0;
+					bool search_single_strand = opts.is_forward ^ opts.is_reverse; // search only a single strand
+					if (opts.is_index_rc)
+						num_strands = 1; // the index has both strands: the forward read finds the hits of both (see 'compute_lis_alignment')
+					else if (search_single_strand)
+						num_strands = 1; // only search the forward xor reverse strand
+					else
+						num_strands = 2; // search both strands. The default when neither -F or -R were specified
+
+					//                                                  |- stop if read was aligned on FWD strand
+					for (int count = 0; count < num_strands && !read.is_done; ++count)
+					{
+						if (!opts.is_index_rc && ((search_single_strand && opts.is_reverse) || count == 1))
+						{
+							if (!read.reversed)
+								read.revIntStr();
+						}
 
-			// write to DB - thread safe
-			if (read.isValid && !read.isEmpty)
-			{
-				if (read.is_hit) ++num_hit;
-				if (read.is_new_hit)
-					kvdb.put(read.id, read.toBinString());
-			}
+						traverse(opts, index, refs, readstats, refstats, read, 
+							opts.is_index_rc || search_single_strand || count == 1); // 'paralleltraversal.cpp'
+						read.id_win_hits.clear(); // bug 46
+					}
+
+					// write to DB - thread safe
+					std::string bin;
+					if (read.isValid && !read.isEmpty)
+					{
+						if (read.is_hit) ++num_hit;
+						if (read.is_new_hit) {
+							bin = read.toBinString();
+							kvdb_writer.put(read.db_key(), bin);
+						}
+					}
+
+					if (read.is_done)
+						readfeed.set_done(read.readfile_idx, read.read_num); // skipped by the next index parts
 
-			readstr.resize(0);
-			++num_all;
-		} // ~if & read destroyed
+					if (frun)
+						frun->add(readstr, bin);
 
-		if (opts.is_paired) idx ^= 1; // switch FWD-REV
-	} // ~while there are reads
+					if (is_cacheable)
+						cache.put(read.sequence, { std::move(bin), read.is_hit, read.is_new_hit, read.is_done });
+				}
+
+				readstr.resize(0);
+				++num_all;
+			} // ~if & read destroyed
+		} // ~while there are reads
+		if (opts.is_kvdb_ingest)
+			kvdb_writer.flush(); // the SST files of the chunk's slots
+	} // ~for chunks
 
 	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - starts;
 	INFO("Processor ", id, " thread ", std::this_thread::get_id(), " done. Processed ",
-		num_all, " reads. Skipped already processed: ", num_skipped, " reads", 
+		num_all, " reads in ", num_chunks, " chunks. Skipped already processed: ", num_skipped, " reads", 
+		" Resumed on this part: ", num_resumed,
+		" Duplicates reusing cached alignment: ", num_dup,
 		" Aligned reads (passing E-value): ", num_hit, " Runtime sec: ", elapsed.count());
 } // ~align2
 
 /*
 * launches processing threads. called from main
+*  @param tpool  the processing threads. Kept for all the index parts. A spare thread prefetches the next index part
+*  @param fused  '--fused' post-processing done by the alignment threads. See 'align_fused'
 */
-void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatabase& kvdb, Runopts& opts)
+void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts, FusedPass* fused)
 {
 	INFO("==== Starting alignment ====");
     INFO("Alignment parameters:  is_best: ", opts.is_best,
             "  num_alignments: ", opts.num_alignments,
-            "  min_lis: ", opts.min_lis);
+            "  min_lis: ", opts.min_lis,
+            "  score_only: ", !opts.is_cigar,
+            "  xdrop: ", opts.xdrop);
     if (opts.num_alignments == 0) {
         INFO("num_alignments is set to: ",  opts.num_alignments,
             ", so all alignments passing E-value threshold will be reported,"
@@ -190,7 +381,6 @@ void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatab
 	numProcThread = opts.num_proc_thread; // '-thread'
 
 	// calculate the number of threads to use
-	int numThreads = 0;
 	//if (opts.feed_type == FEED_TYPE::LOCKLESS)
 	//{
 	//	numThreads = opts.num_read_thread + numProcThread;
@@ -199,15 +389,32 @@ void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatab
 		//ReadsQueue read_queue("queue_1", opts.queue_size_max, readstats.all_reads_count, numProcThread);
 	//}
 	//else {
-	numThreads = numProcThread;
 	INFO("Using number of Processor threads: ", numProcThread);
 	readfeed.init_reading(); // prepare readfeed
 	//}
-	std::vector<std::thread> tpool;
-	tpool.reserve(numThreads);
 
 	Refstats refstats(opts, readstats);
 	References refs;
+	AlignCache cache(opts.dedup_max); // duplicate reads cache. Cleared for each index part
+
+	// reads stream: no copy needed if read by a single pass i.e. a single index part and no post-processing
+	if (readfeed.is_stream) {
+		unsigned num_passes = 0;
+		for (auto num_parts : refstats.num_index_parts) num_passes += num_parts;
+		readfeed.is_spool = num_passes > 1 || opts.alirep != Runopts::ALIGN_REPORT::align;
+	}
+	readfeed.is_skip_done = opts.is_skip_done; // reads done on an index part are not fed to the next ones
+
+	// progress journal: skip the index parts done by a previous run on the same inputs
+	Journal journal(opts, readstats);
+	auto journal_state = journal.restore(kvdb);
+	if (opts.is_kvdb_resume && journal_state != Journal::STATE::MATCH) {
+		ERR("Path: ", std::filesystem::absolute(opts.kvdbdir), journal_state == Journal::STATE::MISMATCH
+			? " holds the results of a run on different files or with different options."
+			: " holds no alignment progress to resume from.",
+			" Please, ensure the directory is Empty prior running 'sortmerna'");
+		exit(EXIT_FAILURE);
+	}
 
 	int loopCount = 0; // counter of total number of processing iterations
 
@@ -221,6 +428,11 @@ void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatab
 		// iterate every part of an index
 		for (uint16_t idx_part = 0; idx_part < refstats.num_index_parts[idx_num]; ++idx_part)
 		{
+			if (journal.is_done(idx_num, idx_part)) {
+				INFO("Skipping index: ", idx_num, " part: ", idx_part + 1, "/", refstats.num_index_parts[idx_num], " done by a previous run");
+				continue;
+			}
+
 			// load index
 			INFO("Loading index: ", idx_num, " part: ", idx_part + 1, "/", refstats.num_index_parts[idx_num], " Memory KB: ", (get_memory() >> 10), " ... ");
 			auto start_i = std::chrono::high_resolution_clock::now();
@@ -247,14 +459,33 @@ void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatab
 			// add Processor jobs
 			for (int i = 0; i < numProcThread; i++)
 			{
-				tpool.emplace_back(std::thread(align2, i, std::ref(readfeed), 
-                                    std::ref(readstats), std::ref(index), std::ref(refs), 
-                                    std::ref(refstats),  std::ref(kvdb), std::ref(opts)));
+				tpool.addJob([&, i] { align2(i, readfeed, readstats, index, refs, refstats, kvdb, cache, opts, fused); });
 			}
-			for (auto& thr: tpool) {
-				thr.join();
+
+			// read the next index part to do into the OS file cache while this one is processed
+			for (std::size_t n = idx_num, p = idx_part + 1u; n < opts.indexfiles.size(); ++n, p = 0) {
+				while (p < refstats.num_index_parts[n] && journal.is_done(n, p)) ++p;
+				if (p < refstats.num_index_parts[n]) {
+					tpool.addJob([&opts, n, p] { Index::prefetch(n, p, opts.indexfiles); });
+					break;
+				}
+			}
+			tpool.waitAll(); // the part barrier
+			kvdb.ingest(); // '--kvdb_ingest' SST files of the part
+
+			// '--no_prescan': the first pass has counted the reads. The E-value statistics
+			// of the following index parts, and the stored Readstats, use the exact totals.
+			if (readfeed.is_estimated && readfeed.reconcile_counts()) {
+				readstats.all_reads_count = readfeed.num_reads_tot;
+				readstats.all_reads_len = readfeed.length_all;
+				readstats.min_read_len = readfeed.min_read_len;
+				readstats.max_read_len = readfeed.max_read_len;
+				refstats = Refstats(opts, readstats);
 			}
 
+			// all the results of the part are in the DB after the threads joined
+			journal.store(kvdb, readstats, idx_num, idx_part);
+
 			++loopCount;
 
 			elapsed = std::chrono::high_resolution_clock::now() - start_i;
@@ -266,7 +497,7 @@ void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatab
 			refs.unload();
 			elapsed = std::chrono::high_resolution_clock::now() - start_i;
 			INFO_MEM("Index and References unloaded in ", elapsed.count(), " sec.");
-			tpool.clear();
+			cache.clear(); // alignments are only valid for the current index part
 			// rewind for the next index
 			readfeed.rewind_in();
             // does nothing for indexed feed. Only for split reads feed. 
@@ -276,14 +507,86 @@ void align(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatab
 		} // ~for(idx_part)
 	} // ~for(idx_num)
 
+	readfeed.is_skip_done = false; // post-processing needs all the reads
+	INFO("Reads skipped by the feed as done on a previous index part: ", readfeed.get_num_skipped_done());
+	INFO("SW alignments performed: ", readstats.num_sw.load(), 
+		" skipped by score bound: ", readstats.num_sw_pruned.load(),
+		" score-only below the kept alignments: ", readstats.num_sw_pruned_best.load(),
+		" skipped by X-drop prefilter: ", readstats.num_sw_xdrop.load());
+
 	elapsed = std::chrono::high_resolution_clock::now() - start_a;
 	INFO("==== Done alignment in ", elapsed.count(), " sec ====\n");
 
+	if (cache.is_enabled()) {
+		readstats.num_dedup_lookup.fetch_add(cache.num_lookup.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		readstats.num_dedup_hit.fetch_add(cache.num_hit.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		INFO("Duplicate reads cache: lookups: ", cache.num_lookup.load(), " hits: ", cache.num_hit.load());
+	}
+
 	// store readstats calculated in alignment
 	readstats.set_is_set_aligned_id_cov();
 	readstats.store_to_db(kvdb);
+	kvdb.compact(); // ahead of the reports. Only if deferred
 } // ~align
 
+/*
+ * '--fused' single pass for a single part index. The alignment threads also classify
+ * the alignments by %ID and %COV, fill the OTU map, and write the reports, while the read
+ * and the references are loaded, instead of the separate passes through the reads and
+ * the DB made by 'denovo_stats', 'fill_otu_map' and 'writeReports'.
+ * The results are still stored in the DB, same as by the separate passes.
+ * called from main
+ */
+void align_fused(Readfeed& readfeed, Readstats& readstats, Index& index, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts)
+{
+	INFO("==== Fused alignment, statistics and reports in a single pass ====");
+	auto start = std::chrono::high_resolution_clock::now();
+
+	bool is_report = opts.alirep == Runopts::ALIGN_REPORT::all;
+	std::unique_ptr<Output> output;
+	if (is_report) {
+		output = std::make_unique<Output>(readfeed, opts);
+		if (opts.is_sam) output->sam.write_header(opts);
+	}
+	std::unique_ptr<OtuMap> otumap;
+	if (opts.is_otu_map)
+		otumap = std::make_unique<OtuMap>(opts.num_proc_thread);
+
+	FusedPass fused;
+	fused.output = output.get();
+	fused.otumap = otumap.get();
+	fused.is_denovo_stats = opts.is_otu_map || opts.is_denovo;
+
+	align(readfeed, readstats, index, kvdb, tpool, opts, &fused);
+
+	if (fused.is_denovo_stats) {
+		INFO("num_yid_ycov: ", readstats.n_yid_ycov,
+			"\n\t\t   num_yid_ncov: ", readstats.n_yid_ncov,
+			"\n\t\t   num_nid_ycov: ", readstats.n_nid_ycov,
+			"\n\t\t   num_denovo: ", readstats.num_denovo);
+	}
+
+	if (otumap) {
+		if (readstats.n_yid_ycov.load(std::memory_order_relaxed) > 0) {
+			otumap->merge();
+			readstats.total_otu = otumap->count_otu();
+			otumap->init(opts); // prepare the file
+			otumap->write();
+		}
+		else {
+			INFO("No OTU groups to output - No reads pass %ID and %COV thresholds");
+		}
+	}
+
+	writeSummary(readstats, opts);
+
+	if (output)
+		closeReports(readfeed, *output, opts);
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	INFO("==== Done fused single pass in ", elapsed.count(), " sec ====\n");
+} // ~align_fused
+
 void denovo_stats_run(const uint32_t& id,
 	Readfeed& readfeed,
 	Readstats& readstats,
@@ -296,76 +599,62 @@ void denovo_stats_run(const uint32_t& id,
 	uint16_t num_reads = opts.is_paired ? 2 : 1;
 	std::string readstr;
 	std::vector<Read> reads; // two reads if paired, a single read otherwise
+	std::vector<Read> block; // reads read ahead to be looked up in the DB at once
+	KeyValueDatabase::Writer kvdb_writer(kvdb);
 
 	if (opts.dbg_level == 2)
 		INFO_MEM("Denovo stats thread ", id, " : ", std::this_thread::get_id(), " started.");
 
-	for (bool isDone = false; !isDone;)
+	for (unsigned chunk = 0; readfeed.next_chunk(chunk);)
 	{
-		reads.clear();
-		uint32_t idx = id * readfeed.num_sense; // index into split_files array
-		for (uint16_t i = 0; i < num_reads; ++i)
+		uint32_t idx = chunk * readfeed.num_sense; // index into split_files array
+		for (bool isDone = false; !isDone;)
 		{
-			if (readfeed.next(idx, readstr))
+			// read ahead a block of whole pairs if paired
+			block.clear();
+			while (!isDone && block.size() < KeyValueDatabase::GET_BATCH)
 			{
-				reads.emplace_back(Read(readstr));
-				reads[i].init(opts);
-				reads[i].load_db(kvdb);
-				readstr.resize(0);
-				++countReads;
-			}
-			else {
-				isDone = true;
-			}
-			if (opts.is_paired) idx ^= 1; // switch fwd-rev
-		}
-
-		if (!isDone) {
-			if (reads.back().isEmpty || !reads.back().isValid) {
-				++num_invalid;
-				continue;
-			}
-
-			for (auto &read: reads) {
-				if (read.is03) read.flip34();
-				for (auto const& align : read.alignment.alignv) {
-					if (align.index_num == refs.num	&& align.part == refs.part)	{
-						auto miss_gap_match = read.calc_miss_gap_match(refs, align);
-						auto idr = std::floor(std::get<3>(miss_gap_match) * 1000.0 + 0.5) / 1000.0; // round to 3 decimal
-						auto covr = std::floor(std::get<4>(miss_gap_match) * 1000.0 + 0.5) / 1000.0;
-						auto is_id = idr >= opts.min_id;
-						auto is_cov = covr >= opts.min_cov;
-						//auto is_id = std::get<3>(miss_gap_match) >= opts.min_id;
-						//auto is_cov = std::get<4>(miss_gap_match)>= opts.min_cov;
-						if (is_id && is_cov) {
-							++read.c_yid_ycov;
-							readstats.n_yid_ycov.fetch_add(1, std::memory_order_relaxed);
-						}
-						else if (is_id) {
-							++read.n_yid_ncov;
-							readstats.n_yid_ncov.fetch_add(1, std::memory_order_relaxed);
-						}
-						else if (is_cov) {
-							++read.n_nid_ycov;
-							readstats.n_nid_ycov.fetch_add(1, std::memory_order_relaxed);
-						}
-						else {
-							++read.n_denovo;
-							readstats.num_denovo.fetch_add(1, std::memory_order_relaxed); // neither ID nor COV
-						}
+				for (uint16_t i = 0; i < num_reads; ++i)
+				{
+					if (readfeed.next(idx, readstr))
+					{
+						block.emplace_back(Read(readstr));
+						block.back().init(opts);
+						readstr.resize(0);
+						++countReads;
 					}
+					else {
+						isDone = true;
+					}
+					if (opts.is_paired) idx ^= 1; // switch fwd-rev
+				}
+			}
+			if (isDone)
+				block.resize(block.size() - block.size() % num_reads); // drop an incomplete pair
+			Read::load_db(kvdb, block);
+
+			for (std::size_t j = 0; j < block.size(); j += num_reads) {
+				reads.assign(std::make_move_iterator(block.begin() + j), std::make_move_iterator(block.begin() + j + num_reads));
+				if (reads.back().isEmpty || !reads.back().isValid) {
+					++num_invalid;
+					continue;
 				}
-				kvdb.put(read.id, read.toBinString()); // store to DB
-			} // ~for reads
-		} // ~ if !is_done
-	} // ~for
+
+				for (auto &read: reads) {
+					if (read.is03) read.flip34();
+					classify_alignments(read, refs, readstats, opts);
+					kvdb_writer.put(read.db_key(), read.toBinString()); // store to DB
+				} // ~for reads
+			} // ~for block
+		} // ~for
+	} // ~for chunks
 
 	//std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start; // ~20 sec Debug/Win
 	INFO_MEM("Denovo stats thread ", id, " : ", std::this_thread::get_id(), " done. Processed reads: ", countReads,
 		" Invalid reads: ", num_invalid); // , " denovo count: ", denovo_n
 } // ~denovo_stats_run
 
-void denovo_stats(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, Runopts& opts)
+void denovo_stats(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kvdb, ThreadPool& tpool, Runopts& opts)
 {
 	INFO("==== processing Denovo statistics ====");
 	auto start = std::chrono::high_resolution_clock::now();
@@ -377,13 +666,11 @@ void denovo_stats(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kv
 	readfeed.init_reading(); // prepare readfeed
 	//}
 
-	std::vector<std::thread> tpool;
-	tpool.reserve(nthreads);
-
 	bool indb = readstats.restoreFromDb(kvdb);
 	if (indb) {
 		INFO("Restored Readstats from DB: ", indb);
 	}
+	readstats.check_cigar("the %id and coverage of the OTU map and de novo reads", opts);
 
 	Refstats refstats(opts, readstats);
 	References refs;
@@ -405,14 +692,11 @@ void denovo_stats(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kv
 			// start threads
 			//if (opts.feed_type == FEED_TYPE::SPLIT_READS || opts.feed_type == FEED_TYPE::INDEXED_GZ || opts.feed_type == FEED_TYPE::INDEXED_FLAT) {
 			for (int i = 0; i < nthreads; ++i) {
-				tpool.emplace_back(std::thread(denovo_stats_run, i, std::ref(readfeed),
-					std::ref(readstats), std::ref(refs), std::ref(kvdb), std::ref(opts)));
+				tpool.addJob([&, i] { denovo_stats_run(i, readfeed, readstats, refs, kvdb, opts); });
 			}
 			//}
 			// wait for all threads to finish
-			for (auto& thr: tpool) {
-				thr.join();
-			}
+			tpool.waitAll();
 
 			elapsed = std::chrono::high_resolution_clock::now() - start_i; // index processing done
 			INFO("done reference ", ref_idx, " part: ", idx_part + 1, " in ", elapsed.count(), " sec");
@@ -422,7 +706,6 @@ void denovo_stats(Readfeed& readfeed, Readstats& readstats, KeyValueDatabase& kv
 			//read_queue.reset();
 			elapsed = std::chrono::high_resolution_clock::now() - start_i;
 			INFO_MEM("references unloaded in ", elapsed.count(), " sec");
-			tpool.clear();
 			// rewind for the next index
 			readfeed.rewind_in();
 			readfeed.init_vzlib_in();
@@ -35,6 +35,9 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
  * Created: Nov 26, 2017 Sun
  */
 #include <filesystem>
+#include <cstring> // memchr
+#include <charconv> // from_chars
+#include <algorithm> // min
 
 // 3rd party
 // #include "rapidjson/writer.h"
@@ -47,56 +50,146 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 alignment_struct2::alignment_struct2() : max_size(0), min_index(0), max_index(0) 
 {}
 
-/**
- * construct from the binary string stored in DB
+/*
+ * Record format stored in DB. Little-endian base-128 varints, signed values zigzag coded.
+ *
+ *   version                   1 byte RECORD_VERSION
+ *   flags                     1 byte is_done | is_hit << 1 | null_align_output << 2 | is_part_hit << 3
+ *   lastIndex, lastPart, number of part_db_moves, the part_db_moves, c_yid_ycov, n_yid_ncov, n_nid_ycov, n_denovo,
+ *   max_SW_count, num_alignments (zigzag), hit_seeds
+ *   alignment                 min_index, max_index, number of alignments, the alignments
+ *
+ * Alignment:
+ *   index_num << 1 | strand, part, ref_num (zigzag delta to the previous alignment),
+ *   ref_begin1, ref_end1 - ref_begin1, read_begin1, read_end1 - read_begin1 (zigzag),
+ *   readlen, score1, number of CIGAR ops, the ops as 'len << 4 | op' (see ssw.h)
+ *
+ * Bump RECORD_VERSION on any change of the layout.
  */
-alignment_struct2::alignment_struct2(std::string bstr)
-{
-	size_t offset = 0;
-	// min_index
-	std::memcpy(static_cast<void*>(&min_index), bstr.data() + offset, sizeof(min_index));
-	offset += sizeof(min_index);
-	// max_index
-	std::memcpy(static_cast<void*>(&max_index), bstr.data() + offset, sizeof(max_index));
-	offset += sizeof(max_index);
-
-	// alignv vector<s_align2>
-	size_t alignv_size = 0; // size of alignv vector
-	std::memcpy(static_cast<void*>(&alignv_size), bstr.data() + offset, sizeof(alignv_size));
-	offset += sizeof(alignv_size);
-
-	for (unsigned i = 0; i < alignv_size; i++)
+namespace {
+	const uint8_t RECORD_VERSION = 2;
+
+	inline void put_varint(std::string& buf, uint64_t val)
+	{
+		while (val >= 0x80) {
+			buf.push_back(static_cast<char>(val | 0x80));
+			val >>= 7;
+		}
+		buf.push_back(static_cast<char>(val));
+	}
+
+	inline void put_zigzag(std::string& buf, int64_t val)
 	{
-		size_t s_align_size = 0; // size of a_align struct
-		std::memcpy(static_cast<void*>(&s_align_size), bstr.data() + offset, sizeof(s_align_size));
-		offset += sizeof(s_align_size);
-		std::string s_align_str(bstr.data() + offset, bstr.data() + offset + s_align_size); // part of the string encoding the current s_align struct
-		offset += s_align_size;
-		alignv.push_back(s_align2(s_align_str));
+		put_varint(buf, (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63));
 	}
+
+	/* sequential decoder over a record. 'ok' is false once the record turns out truncated */
+	struct RecordReader {
+		const char* pos;
+		const char* end;
+		bool ok = true;
+
+		uint64_t varint()
+		{
+			uint64_t val = 0;
+			for (unsigned shift = 0; shift < 64; shift += 7) {
+				if (pos == end) {
+					ok = false;
+					return 0;
+				}
+				auto byte = static_cast<uint8_t>(*pos++);
+				val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if (byte < 0x80)
+					return val;
+			}
+			ok = false;
+			return 0;
+		}
+
+		int64_t zigzag()
+		{
+			auto val = varint();
+			return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+		}
+
+		uint8_t byte()
+		{
+			if (pos == end) {
+				ok = false;
+				return 0;
+			}
+			return static_cast<uint8_t>(*pos++);
+		}
+	}; // ~struct RecordReader
+
+	void encode_alignment(std::string& buf, const alignment_struct2& alignment)
+	{
+		put_varint(buf, alignment.min_index);
+		put_varint(buf, alignment.max_index);
+		put_varint(buf, alignment.alignv.size());
+		int64_t ref_num = 0;
+		for (auto const& align : alignment.alignv) {
+			put_varint(buf, static_cast<uint64_t>(align.index_num) << 1 | (align.strand ? 1 : 0));
+			put_varint(buf, align.part);
+			put_zigzag(buf, static_cast<int64_t>(align.ref_num) - ref_num);
+			ref_num = align.ref_num;
+			put_zigzag(buf, align.ref_begin1);
+			put_zigzag(buf, static_cast<int64_t>(align.ref_end1) - align.ref_begin1);
+			put_zigzag(buf, align.read_begin1);
+			put_zigzag(buf, static_cast<int64_t>(align.read_end1) - align.read_begin1);
+			put_varint(buf, align.readlen);
+			put_varint(buf, align.score1);
+			put_varint(buf, align.cigar.size());
+			for (auto op : align.cigar)
+				put_varint(buf, op);
+		}
+	} // ~encode_alignment
+
+	void decode_alignment(RecordReader& rd, alignment_struct2& alignment)
+	{
+		alignment.min_index = static_cast<uint32_t>(rd.varint());
+		alignment.max_index = static_cast<uint32_t>(rd.varint());
+		auto num_align = rd.varint();
+		alignment.alignv.clear();
+		// each alignment takes at least 11 bytes - do not trust a broken count
+		alignment.alignv.reserve(std::min<uint64_t>(num_align, (rd.end - rd.pos) / 11));
+		int64_t ref_num = 0;
+		for (uint64_t i = 0; i < num_align && rd.ok; ++i) {
+			s_align2 align;
+			auto index_strand = rd.varint();
+			align.index_num = static_cast<uint16_t>(index_strand >> 1);
+			align.strand = (index_strand & 1) != 0;
+			align.part = static_cast<uint16_t>(rd.varint());
+			ref_num += rd.zigzag();
+			align.ref_num = static_cast<uint32_t>(ref_num);
+			align.ref_begin1 = static_cast<int32_t>(rd.zigzag());
+			align.ref_end1 = static_cast<int32_t>(align.ref_begin1 + rd.zigzag());
+			align.read_begin1 = static_cast<int32_t>(rd.zigzag());
+			align.read_end1 = static_cast<int32_t>(align.read_begin1 + rd.zigzag());
+			align.readlen = static_cast<uint32_t>(rd.varint());
+			align.score1 = static_cast<uint16_t>(rd.varint());
+			auto num_ops = rd.varint();
+			align.cigar.reserve(std::min<uint64_t>(num_ops, rd.end - rd.pos));
+			for (uint64_t j = 0; j < num_ops && rd.ok; ++j)
+				align.cigar.push_back(static_cast<uint32_t>(rd.varint()));
+			alignment.alignv.push_back(std::move(align));
+		}
+	} // ~decode_alignment
+} // namespace
+
+/**
+ * construct from the binary string produced by 'toString'
+ */
+alignment_struct2::alignment_struct2(std::string bstr) : max_size(0), min_index(0), max_index(0)
+{
+	RecordReader rd{ bstr.data(), bstr.data() + bstr.size() };
+	decode_alignment(rd, *this);
 }
 
 std::string alignment_struct2::toString()
 {
 	std::string buf;
-
-	std::copy_n(static_cast<char*>(static_cast<void*>(&min_index)), sizeof(min_index), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&max_index)), sizeof(max_index), std::back_inserter(buf));
-
-	// alignv
-	size_t vsize = alignv.size();
-	std::copy_n(static_cast<char*>(static_cast<void*>(&vsize)), sizeof(vsize), std::back_inserter(buf)); // add vector size
-
-	// alignv
-	std::string s_align2_str;
-	size_t s_align2_strlen = 0;
-	for (auto it = alignv.begin(); it < alignv.end(); ++it) {
-		s_align2_str = it->toString(); // get string
-		s_align2_strlen = s_align2_str.size(); // get string size
-		std::copy_n(static_cast<char*>(static_cast<void*>(&s_align2_strlen)), sizeof(s_align2_strlen), std::back_inserter(buf)); // add size to buffer
-		buf += s_align2_str; // add string to buffer
-	}
-
+	encode_alignment(buf, *this);
 	return buf;
 } // ~toString
 
@@ -129,6 +222,7 @@ Read::Read()
 	format(BIO_FORMAT::FASTA),
 	lastIndex(0),
 	lastPart(0),
+	is_part_hit(false),
 	c_yid_ycov(0),
 	n_yid_ncov(0),
 	n_nid_ycov(0),
@@ -184,6 +278,8 @@ Read::Read(const Read& that)
 	ambiguous_nt = that.ambiguous_nt;
 	lastIndex = that.lastIndex;
 	lastPart = that.lastPart;
+	is_part_hit = that.is_part_hit;
+	part_db_moves = that.part_db_moves;
 	c_yid_ycov = that.c_yid_ycov;
 	n_yid_ncov = that.n_yid_ncov;
 	n_nid_ycov = that.n_nid_ycov;
@@ -225,6 +321,8 @@ Read & Read::operator=(const Read& that)
 	ambiguous_nt = that.ambiguous_nt;
 	lastIndex = that.lastIndex;
 	lastPart = that.lastPart;
+	is_part_hit = that.is_part_hit;
+	part_db_moves = that.part_db_moves;
 	c_yid_ycov = that.c_yid_ycov;
 	n_yid_ncov = that.n_yid_ncov;
 	n_nid_ycov = that.n_nid_ycov;
@@ -313,6 +411,8 @@ void Read::clear()
 	isRestored = false;
 	lastIndex = 0;
 	lastPart = 0;
+	is_part_hit = false;
+	part_db_moves.clear();
 	c_yid_ycov = 0;
 	n_yid_ncov = 0;
 	n_nid_ycov = 0;
@@ -431,32 +531,23 @@ std::string Read::toBinString()
 	if (alignment.alignv.size() == 0)
 		return "";
 
-	// hit, hit_denovo, null_align_output, max_SW_count, num_alignments, readhit, best
 	std::string buf;
-	std::copy_n(static_cast<char*>(static_cast<void*>(&lastIndex)), sizeof(lastIndex), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&lastPart)), sizeof(lastPart), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&c_yid_ycov)), sizeof(c_yid_ycov), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&n_yid_ncov)), sizeof(n_yid_ncov), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&n_nid_ycov)), sizeof(n_nid_ycov), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&n_denovo)), sizeof(n_denovo), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&is_done)), sizeof(is_done), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&is_hit)), sizeof(is_hit), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&null_align_output)), sizeof(null_align_output), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&max_SW_count)), sizeof(max_SW_count), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&num_alignments)), sizeof(num_alignments), std::back_inserter(buf));
-	std::copy_n(static_cast<char*>(static_cast<void*>(&hit_seeds)), sizeof(hit_seeds), std::back_inserter(buf));
-
-	// id_win_hits vector - TODO: remove?
-#if 0
-	size_t id_win_hits_size = id_win_hits.size();
-	std::copy_n(static_cast<char*>(static_cast<void*>(&id_win_hits_size)), sizeof(id_win_hits_size), std::back_inserter(buf)); // add vector size
-	for (auto it = id_win_hits.begin(); it != id_win_hits.end(); ++it) buf += it->toString(); // add values
-#endif
-	// alignment
-	std::string alignment_str = alignment.toString();
-	size_t alignment_size = alignment_str.length();
-	std::copy_n(static_cast<char*>(static_cast<void*>(&alignment_size)), sizeof(alignment_size), std::back_inserter(buf)); // add size
-	buf += alignment_str; //  add string
+	buf.reserve(32 + alignment.alignv.size() * 32);
+	buf.push_back(static_cast<char>(RECORD_VERSION));
+	buf.push_back(static_cast<char>((is_done ? 1 : 0) | (is_hit ? 2 : 0) | (null_align_output ? 4 : 0) | (is_part_hit ? 8 : 0)));
+	put_varint(buf, lastIndex);
+	put_varint(buf, lastPart);
+	put_varint(buf, part_db_moves.size());
+	for (auto db : part_db_moves)
+		put_varint(buf, db);
+	put_varint(buf, c_yid_ycov);
+	put_varint(buf, n_yid_ncov);
+	put_varint(buf, n_nid_ycov);
+	put_varint(buf, n_denovo);
+	put_varint(buf, max_SW_count);
+	put_zigzag(buf, num_alignments);
+	put_varint(buf, hit_seeds);
+	encode_alignment(buf, alignment);
 
 	return buf;
 } // ~Read::toBinString
@@ -466,77 +557,100 @@ std::string Read::toBinString()
  */
 bool Read::load_db(KeyValueDatabase& kvdb)
 {
-	std::string bstr = kvdb.get(id);
-	if (bstr.size() == 0) { isRestored = false; return isRestored; }
-	size_t offset = 0;
-
-	std::memcpy(static_cast<void*>(&lastIndex), bstr.data() + offset, sizeof(lastIndex));
-	offset += sizeof(lastIndex);
-
-	std::memcpy(static_cast<void*>(&lastPart), bstr.data() + offset, sizeof(lastPart));
-	offset += sizeof(lastPart);
-
-	std::memcpy(static_cast<void*>(&c_yid_ycov), bstr.data() + offset, sizeof(c_yid_ycov));
-	offset += sizeof(c_yid_ycov);
-
-	std::memcpy(static_cast<void*>(&n_yid_ncov), bstr.data() + offset, sizeof(n_yid_ncov));
-	offset += sizeof(n_yid_ncov);
-
-	std::memcpy(static_cast<void*>(&n_nid_ycov), bstr.data() + offset, sizeof(n_nid_ycov));
-	offset += sizeof(n_nid_ycov);
-
-	std::memcpy(static_cast<void*>(&n_denovo), bstr.data() + offset, sizeof(n_denovo));
-	offset += sizeof(n_denovo);
-
-	std::memcpy(static_cast<void*>(&is_done), bstr.data() + offset, sizeof(is_done));
-	offset += sizeof(is_done);
+	return fromBinString(kvdb.get(db_key()));
+}
 
-	std::memcpy(static_cast<void*>(&is_hit), bstr.data() + offset, sizeof(is_hit));
-	offset += sizeof(is_hit);
+bool Read::load_db(KeyValueDatabase::Scanner& scanner)
+{
+	return fromBinString(scanner.get(db_key()));
+}
 
-	std::memcpy(static_cast<void*>(&null_align_output), bstr.data() + offset, sizeof(null_align_output));
-	offset += sizeof(null_align_output);
+bool Read::is_aligned_on(unsigned idx_num, unsigned idx_part) const
+{
+	return isRestored && (lastIndex > idx_num || (lastIndex == idx_num && lastPart >= idx_part));
+}
 
-	std::memcpy(static_cast<void*>(&max_SW_count), bstr.data() + offset, sizeof(max_SW_count));
-	offset += sizeof(max_SW_count);
+/*
+ * A run resumed mid-part skips the reads it finds aligned on the part (see 'is_aligned_on'),
+ * as aligning them again would duplicate their alignments. The Readstats restored are of the
+ * last part done, so the changes the skipped reads made on the part are added back here
+ * as 'alignment.cpp' made them.
+ */
+void Read::replay_part_stats(std::atomic<uint64_t>& num_aligned, std::vector<uint64_t>& reads_matched_per_db) const
+{
+	if (is_part_hit) {
+		num_aligned.fetch_add(1, std::memory_order_relaxed);
+		++reads_matched_per_db[lastIndex];
+	}
+	for (auto db : part_db_moves) {
+		--reads_matched_per_db[db];
+		++reads_matched_per_db[lastIndex];
+	}
+} // ~Read::replay_part_stats
 
-	std::memcpy(static_cast<void*>(&num_alignments), bstr.data() + offset, sizeof(num_alignments));
-	offset += sizeof(num_alignments);
+std::string Read::db_key() const
+{
+	return KeyValueDatabase::read_key(readfile_idx, read_num);
+}
 
-	std::memcpy(static_cast<void*>(&hit_seeds), bstr.data() + offset, sizeof(hit_seeds));
-	offset += sizeof(hit_seeds);
+void Read::load_db(KeyValueDatabase& kvdb, std::vector<Read>& reads)
+{
+	std::vector<std::string> keys;
+	keys.reserve(reads.size());
+	for (auto const& read : reads)
+		keys.push_back(read.db_key());
+	auto vals = kvdb.multi_get(keys);
+	for (std::size_t i = 0; i < reads.size(); ++i)
+		reads[i].fromBinString(vals[i]);
+} // ~Read::load_db
 
-	//std::memcpy(static_cast<void*>(&best), bstr.data() + offset, sizeof(best));
-	//offset += sizeof(best);
+bool Read::fromBinString(const std::string& bstr)
+{
+	if (bstr.size() == 0) { isRestored = false; return isRestored; }
 
-	// std::vector<id_win> id_win_hits TODO: remove?
-#if 0
-	size_t id_win_hits_size = 0;
-	std::memcpy(static_cast<void*>(&id_win_hits_size), bstr.data() + offset, sizeof(id_win_hits_size));
-	offset += sizeof(id_win_hits_size);
-	std::string id_win_str;
-	for (int i = 0; i < id_win_hits_size; ++i)
-	{
-		//id_win_str.assign(sizeof(id_win::id) + sizeof(id_win::win), 0);
-		//std::memcpy(static_cast<void*>(&id_win_str[0]), bstr.data() + offset, sizeof(id_win::id) + sizeof(id_win::win));
-		std::copy_n(bstr.data() + offset, sizeof(id_win::id) + sizeof(id_win::win), std::back_inserter(id_win_str));
-		id_win_hits.push_back(id_win(id_win_str));
-		offset += (sizeof(id_win::id) + sizeof(id_win::win));
-		id_win_str.clear();
+	auto stat = decodeBinString(bstr);
+	if (stat == RECORD::VERSION) {
+		ERR("Read ", id, " record in the key-value database has version ", unsigned(static_cast<uint8_t>(bstr[0])),
+			" while version ", unsigned(RECORD_VERSION), " is expected. The database was created by a different",
+			" version of sortmerna. Please, use an empty key-value database directory");
+		exit(EXIT_FAILURE);
+	}
+	if (stat == RECORD::CORRUPT) {
+		ERR("Read ", id, " record in the key-value database is corrupt");
+		exit(EXIT_FAILURE);
 	}
-#endif
-	// alignment_struct2 alignment
-	size_t alignment_size = 0;
-	std::memcpy(static_cast<void*>(&alignment_size), bstr.data() + offset, sizeof(alignment_size));
-	offset += sizeof(alignment_size);
-	std::string alignment_str(bstr.data() + offset, bstr.data() + offset + alignment_size);
-	alignment_struct2 alignstruct(alignment_str);
-	alignment = alignstruct;
-	offset += alignment_size;
 
 	isRestored = true;
 	return isRestored;
-} // ~Read::load_db
+} // ~Read::fromBinString
+
+Read::RECORD Read::decodeBinString(const std::string& bstr)
+{
+	RecordReader rd{ bstr.data(), bstr.data() + bstr.size() };
+	if (rd.byte() != RECORD_VERSION)
+		return RECORD::VERSION;
+	auto flags = rd.byte();
+	is_done = (flags & 1) != 0;
+	is_hit = (flags & 2) != 0;
+	null_align_output = (flags & 4) != 0;
+	is_part_hit = (flags & 8) != 0;
+	lastIndex = static_cast<unsigned>(rd.varint());
+	lastPart = static_cast<unsigned>(rd.varint());
+	part_db_moves.clear();
+	for (auto num_moves = rd.varint(); num_moves > 0 && rd.ok; --num_moves)
+		part_db_moves.push_back(static_cast<uint16_t>(rd.varint()));
+	c_yid_ycov = static_cast<unsigned>(rd.varint());
+	n_yid_ncov = static_cast<unsigned>(rd.varint());
+	n_nid_ycov = static_cast<unsigned>(rd.varint());
+	n_denovo = static_cast<unsigned>(rd.varint());
+	max_SW_count = static_cast<uint16_t>(rd.varint());
+	num_alignments = static_cast<int32_t>(rd.zigzag());
+	hit_seeds = static_cast<uint32_t>(rd.varint());
+	decode_alignment(rd, alignment);
+
+	// truncated, or bytes left over i.e. a broken count
+	return rd.ok && rd.pos == rd.end ? RECORD::OK : RECORD::CORRUPT;
+} // ~Read::decodeBinString
 
 /* deserialize matches from JSON and populate the read */
 void Read::unmarshallJson(KeyValueDatabase & kvdb)
@@ -610,41 +724,52 @@ uint32_t Read::hashKmer(uint32_t pos, uint32_t len)
 	return hash;
 }
 
+bool ReadView::parse(std::string_view rec)
+{
+	std::string_view* fields[] = { &id, &header, &sequence, &quality };
+	size_t num_fields = 0;
+	for (size_t pos = 0; pos < rec.size(); ++num_fields) {
+		auto nl = static_cast<const char*>(std::memchr(rec.data() + pos, '\n', rec.size() - pos));
+		size_t end = nl ? nl - rec.data() : rec.size();
+		if (num_fields == 4)
+			return false;
+		*fields[num_fields] = rec.substr(pos, end - pos);
+		pos = end + 1;
+	}
+	return true;
+} // ~ReadView::parse
+
 /* 
  * @param readstr 'read_id \n header \n sequence [\n quality]'
  */
 bool Read::from_string(std::string& readstr)
 {
-	bool is_ok = true;;
-	std::stringstream ss(readstr);
-	std::string line;
-	for (int i = 0; std::getline(ss, line, '\n'); ++i) {
-		if (i == 0) {
-			id = line;
-			auto pos = line.find_first_of('_');
-			readfile_idx = std::atoi(line.substr(0, pos+1).data());
-			read_num = std::atoi(line.substr(pos+1, line.size() - pos -1).data());
-		}
-		else if (i == 1) {
-			format = line.front() == FASTA_HEADER_START ? BIO_FORMAT::FASTA : BIO_FORMAT::FASTQ;
-			header = line;
-		}
-		else if (i == 2) {
-			sequence = line;
-		}
-		else if (i == 3) {
-			if (format == BIO_FORMAT::FASTQ) {
-				quality = line;
-			}
-			else {
-				ERR("unexpected number of lines in fasta read: ", readstr);
-				is_ok = false;
-			}
-		}
-		else {
-			ERR("unexpected number of lines in read: ", readstr);
-			is_ok = false;
-		}
+	ReadView view;
+	if (!view.parse(readstr)) {
+		ERR("unexpected number of lines in read: ", readstr);
+		return false;
+	}
+	return from_view(view);
+} // ~Read::from_string
+
+bool Read::from_view(const ReadView& view)
+{
+	id = view.id;
+	auto pos = view.id.find('_');
+	readfile_idx = 0;
+	read_num = 0;
+	std::from_chars(view.id.data(), view.id.data() + std::min(pos, view.id.size()), readfile_idx);
+	if (pos != std::string_view::npos)
+		std::from_chars(view.id.data() + pos + 1, view.id.data() + view.id.size(), read_num);
+
+	format = !view.header.empty() && view.header.front() == FASTA_HEADER_START ? BIO_FORMAT::FASTA : BIO_FORMAT::FASTQ;
+	header = view.header;
+	sequence = view.sequence;
+
+	if (!view.quality.empty() && format == BIO_FORMAT::FASTA) {
+		ERR("unexpected number of lines in fasta read: ", view.id);
+		return false;
 	}
-	return is_ok;
-} // ~Read::from_string
\ No newline at end of file
+	quality = view.quality;
+	return true;
+} // ~Read::from_view
\ No newline at end of file
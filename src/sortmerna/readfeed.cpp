@@ -38,6 +38,7 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 
 #include "common.hpp"
 #include "readfeed.hpp"
+#include "read.hpp" // ReadView
 
 #include <vector>
 #include <iostream>
@@ -46,25 +47,529 @@ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
 #include <chrono> // std::chrono
 #include <iomanip> // std::precision
 #include <locale> // std::isspace
+#include <cctype> // std::isspace
+#include <cstring> // std::memchr
+#if !defined(_WIN32)
+#include <sys/mman.h> // mmap
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#endif
 #include <thread>
+#include <future> // std::async
 #include <regex>
 
 #include <filereader/Standard.hpp>
 #include <rapidgzip/ParallelGzipReader.hpp>
+#include <indexed_bzip2/ParallelBZ2Reader.hpp>
+#if defined(HAVE_ZSTD)
+#include <zstd.h>
+#endif
+#if defined(HAVE_LIBURING)
+#include <liburing.h>
+#include <sys/stat.h> // fstat
+#include <cerrno> // EINTR
+#endif
 
 // Opaque wrapper — keeps rapidgzip headers out of readfeed.hpp and every TU that includes it.
 // The explicit template specialisation NEXT_DYNAMIC_DEFLATE_CANDIDATE_LUT<15> in DynamicHuffman.hpp
 // lacks 'inline', so it gets external linkage; Apple ld rejects duplicate definitions across TUs.
+//
+// One decoder per compression, see 'make_reader'. All are seekable by the decompressed offset.
 struct GzReaderImpl {
+    virtual ~GzReaderImpl() = default;
+    /* @return number of decompressed bytes, 0 at the end of file */
+    virtual size_t read(char* buf, size_t len) = 0;
+    virtual void seek(uint64_t offset) = 0;
+    /* seek points found by decompressing the whole file, see 'ReadIndex::gz_index_path' */
+    virtual void export_index(std::ofstream& ofs) = 0;
+    virtual void import_index(const std::filesystem::path& path) = 0;
+};
+
+#if defined(HAVE_LIBURING)
+/*
+ * File reader keeping up to 'NUM_BUFS' reads of 'BLOCK_SIZE' in flight ahead of the position, so that the I/O
+ * of the next blocks overlaps the decompression of the current one. Block 'b' is read into the buffer 'b % NUM_BUFS'.
+ * A seek outside the window drops it. Used by rapidgzip through its SharedFileReader i.e. by one caller at a time.
+ */
+class UringFileReader : public rapidgzip::FileReader {
+public:
+	static constexpr size_t BLOCK_SIZE = 1U << 20; // 1 MiB
+	static constexpr unsigned NUM_BUFS = 8;
+
+	/* @throw std::runtime_error if the file cannot be opened or io_uring is not available e.g. seccomp */
+	explicit UringFileReader(const std::string& path);
+	~UringFileReader() override { close(); }
+
+	[[nodiscard]] rapidgzip::UniqueFileReader cloneRaw() const override { return std::make_unique<UringFileReader>(path); }
+	void close() override;
+	[[nodiscard]] bool closed() const override { return fd < 0; }
+	[[nodiscard]] bool eof() const override { return pos >= file_size; }
+	[[nodiscard]] bool fail() const override { return false; }
+	[[nodiscard]] int fileno() const override { return fd; }
+	[[nodiscard]] bool seekable() const override { return true; }
+	[[nodiscard]] size_t read(char* buffer, size_t len) override;
+	size_t seek(long long int offset, int origin = SEEK_SET) override;
+	[[nodiscard]] std::optional<size_t> size() const override { return file_size; }
+	[[nodiscard]] size_t tell() const override { return pos; }
+	void clearerr() override {}
+
+private:
+	struct Buf {
+		std::vector<char> data;
+		uint64_t block = 0;
+		size_t len = 0;
+		bool is_pending = false;
+	};
+	void submit(uint64_t block);
+	void wait(Buf& buf);
+	const Buf& get_block(uint64_t block);
+
+	std::string path;
+	int fd = -1;
+	size_t file_size = 0;
+	size_t pos = 0;
+	io_uring ring;
+	bool is_ring = false;
+	std::vector<Buf> bufs;
+	uint64_t first = 0; // window of submitted blocks [first, last)
+	uint64_t last = 0;
+};
+
+UringFileReader::UringFileReader(const std::string& path) : path(path)
+{
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("failed to open " + path);
+	struct stat st;
+	if (::fstat(fd, &st) != 0) {
+		close();
+		throw std::runtime_error("failed to stat " + path);
+	}
+	file_size = static_cast<size_t>(st.st_size);
+	auto ret = io_uring_queue_init(NUM_BUFS, &ring, 0);
+	if (ret < 0) {
+		close();
+		throw std::runtime_error(std::string("io_uring_queue_init: ") + std::strerror(-ret));
+	}
+	is_ring = true;
+	bufs.resize(NUM_BUFS);
+	for (auto& buf : bufs) buf.data.resize(BLOCK_SIZE);
+}
+
+void UringFileReader::close()
+{
+	if (is_ring) {
+		for (auto& buf : bufs) wait(buf); // the kernel writes into the buffers until completed
+		io_uring_queue_exit(&ring);
+		is_ring = false;
+	}
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+}
+
+void UringFileReader::submit(uint64_t block)
+{
+	auto& buf = bufs[block % NUM_BUFS];
+	wait(buf); // previous block of the buffer, normally already consumed
+	auto offset = block * BLOCK_SIZE;
+	buf.block = block;
+	buf.len = 0;
+	buf.is_pending = true;
+	auto sqe = io_uring_get_sqe(&ring);
+	io_uring_prep_read(sqe, fd, buf.data.data(), static_cast<unsigned>(std::min<uint64_t>(BLOCK_SIZE, file_size - offset)), offset);
+	io_uring_sqe_set_data64(sqe, block);
+	io_uring_submit(&ring);
+}
+
+void UringFileReader::wait(Buf& buf)
+{
+	while (buf.is_pending) {
+		io_uring_cqe* cqe = nullptr;
+		auto ret = io_uring_wait_cqe(&ring, &cqe);
+		if (ret == -EINTR)
+			continue;
+		if (ret < 0) {
+			ERR("io_uring wait failed: ", path, " ", std::strerror(-ret));
+			exit(EXIT_FAILURE);
+		}
+		auto block = io_uring_cqe_get_data64(cqe);
+		auto res = cqe->res;
+		io_uring_cqe_seen(&ring, cqe);
+		if (res < 0) {
+			ERR("io_uring read failed: ", path, " ", std::strerror(-res));
+			exit(EXIT_FAILURE);
+		}
+
+		auto& done = bufs[block % NUM_BUFS];
+		done.len = static_cast<size_t>(res);
+		done.is_pending = false;
+		// short read e.g. a network file system - the rest of the block with blocking reads
+		auto offset = block * BLOCK_SIZE;
+		auto want = static_cast<size_t>(std::min<uint64_t>(BLOCK_SIZE, file_size - offset));
+		while (done.len < want) {
+			auto n = ::pread(fd, done.data.data() + done.len, want - done.len, static_cast<off_t>(offset + done.len));
+			if (n <= 0) break;
+			done.len += static_cast<size_t>(n);
+		}
+	}
+}
+
+const UringFileReader::Buf& UringFileReader::get_block(uint64_t block)
+{
+	if (block < first || block >= first + NUM_BUFS) {
+		for (auto& buf : bufs) wait(buf);
+		first = block;
+		last = block;
+	}
+	first = block; // the buffers of the blocks before are free
+	for (; last < first + NUM_BUFS && last * BLOCK_SIZE < file_size; ++last)
+		submit(last);
+	auto& buf = bufs[block % NUM_BUFS];
+	wait(buf);
+	return buf;
+}
+
+size_t UringFileReader::read(char* buffer, size_t len)
+{
+	size_t num = 0;
+	while (num < len && pos < file_size) {
+		auto block = pos / BLOCK_SIZE;
+		const auto& buf = get_block(block);
+		auto in_block = pos - block * BLOCK_SIZE;
+		if (in_block >= buf.len)
+			break; // file truncated while reading
+		auto n = std::min(len - num, buf.len - in_block);
+		std::memcpy(buffer + num, buf.data.data() + in_block, n);
+		num += n;
+		pos += n;
+	}
+	return num;
+}
+
+size_t UringFileReader::seek(long long int offset, int origin)
+{
+	long long base = origin == SEEK_CUR ? static_cast<long long>(pos)
+		: origin == SEEK_END ? static_cast<long long>(file_size) : 0;
+	pos = static_cast<size_t>(std::clamp(base + offset, 0LL, static_cast<long long>(file_size)));
+	return pos;
+}
+#endif
+
+namespace {
+	// io_uring reader if asked for and available, otherwise the blocking reads
+	rapidgzip::UniqueFileReader make_file_reader(const std::string& path, bool is_uring)
+	{
+		static std::atomic<bool> is_warned{ false };
+#if defined(HAVE_LIBURING)
+		if (is_uring) {
+			try {
+				return std::make_unique<UringFileReader>(path);
+			}
+			catch (const std::exception& e) {
+				if (!is_warned.exchange(true))
+					WARN("io_uring reader not available: ", e.what(), ". Using blocking reads");
+			}
+		}
+#else
+		if (is_uring && !is_warned.exchange(true))
+			WARN("built without liburing. Using blocking reads");
+#endif
+		return std::make_unique<rapidgzip::StandardFileReader>(path);
+	}
+}
+
+// gzip and BGZF (rapidgzip uses the BGZF block sizes instead of searching the deflate blocks)
+struct GzipReader : GzReaderImpl {
     rapidgzip::ParallelGzipReader<> rdr;
-    template <typename T>
-    GzReaderImpl(std::unique_ptr<T> fr, std::size_t threads)
-        : rdr(std::move(fr), threads) {}
+    GzipReader(const std::string& path, std::size_t threads, bool is_uring)
+        : rdr(make_file_reader(path, is_uring), threads) {}
+
+    size_t read(char* buf, size_t len) override { return static_cast<size_t>(rdr.read(buf, len)); }
+    void seek(uint64_t offset) override { rdr.seek(static_cast<long long>(offset)); }
+    void export_index(std::ofstream& ofs) override {
+        rdr.exportIndex([&ofs](const void* buffer, size_t size) {
+            ofs.write(static_cast<const char*>(buffer), static_cast<std::streamsize>(size));
+        });
+    }
+    void import_index(const std::filesystem::path& path) override {
+        rdr.importIndex(std::make_unique<rapidgzip::StandardFileReader>(path.generic_string()));
+    }
 };
 
+// bzip2 - the blocks are found by their magic bits and decoded in parallel
+struct Bz2Reader : GzReaderImpl {
+    indexed_bzip2::ParallelBZ2Reader rdr;
+    Bz2Reader(const std::string& path, std::size_t threads, bool is_uring)
+        : rdr(make_file_reader(path, is_uring), threads) {}
+
+    size_t read(char* buf, size_t len) override { return rdr.read(buf, len); }
+    void seek(uint64_t offset) override { rdr.seek(static_cast<long long>(offset)); }
+    // block offsets: [compressed bit offset, decompressed byte offset]...
+    void export_index(std::ofstream& ofs) override {
+        for (const auto& [bits, bytes] : rdr.blockOffsets()) {
+            uint64_t rec[2] = { static_cast<uint64_t>(bits), static_cast<uint64_t>(bytes) };
+            ofs.write(reinterpret_cast<const char*>(rec), sizeof(rec));
+        }
+    }
+    void import_index(const std::filesystem::path& path) override {
+        std::ifstream ifs(path, std::ios_base::in | std::ios_base::binary);
+        std::map<size_t, size_t> offsets;
+        uint64_t rec[2];
+        while (ifs.read(reinterpret_cast<char*>(rec), sizeof(rec)))
+            offsets.emplace(static_cast<size_t>(rec[0]), static_cast<size_t>(rec[1]));
+        if (!offsets.empty())
+            rdr.setBlockOffsets(std::move(offsets));
+    }
+};
+
+#if defined(HAVE_ZSTD)
+// zstd - the frames are independent. They are found by walking the frame headers of the memory-mapped file.
+// With 'threads' > 1 (pre-scan) the frames ahead are decoded in parallel, each into memory, which is only done
+// if every frame declares its content size, up to MAX_FRAME_OUT. Otherwise the frames are streamed in blocks of
+// OUT_SIZE. A seek starts at the frame holding the offset, known once the file was decompressed (see 'frame_out',
+// stored in the index), and drops the bytes before the offset. A single frame file e.g. 'zstd -T0' output has
+// no parallelism nor seek points, and is read by a single slot (see 'build_chunk_offsets'). 'pzstd' writes
+// one frame per block.
+struct ZstdReader : GzReaderImpl {
+    struct Frame {
+        uint64_t pos; // compressed
+        uint64_t len;
+    };
+    static constexpr size_t OUT_SIZE = 1U << 17; // 128 KiB
+    static constexpr uint64_t MAX_FRAME_OUT = 1U << 24; // 16 MiB decoded frame held in memory
+
+    std::filesystem::path path;
+    const char* data = nullptr;
+    size_t size = 0;
+    std::vector<char> mem; // file content when no mmap is available
+    std::vector<Frame> frames;
+    std::vector<uint64_t> frame_out; // decompressed offset of each frame. Complete after reading to the end
+    std::size_t threads;
+
+    ZSTD_DCtx* dctx = nullptr;
+    ZSTD_inBuffer in = { nullptr, 0, 0 };
+    size_t frame_idx = 0; // next frame to decode
+    bool is_in_frame = false;
+    std::deque<std::future<std::string>> ahead; // frames [frame_idx - ahead.size(), frame_idx) being decoded
+    std::string out; // decompressed data starting at 'out_start'
+    size_t out_pos = 0;
+    uint64_t out_start = 0;
+
+    ZstdReader(const std::string& path, std::size_t threads) : path(path), threads(threads) {
+        auto fsize = std::filesystem::file_size(this->path);
+#if defined(_WIN32)
+        std::ifstream ifs(this->path, std::ios_base::in | std::ios_base::binary);
+        mem.resize(fsize);
+        ifs.read(mem.data(), static_cast<std::streamsize>(fsize));
+        data = mem.data();
+#else
+        int fd = ::open(this->path.c_str(), O_RDONLY);
+        void* map = fd < 0 ? MAP_FAILED : ::mmap(nullptr, fsize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (fd >= 0) ::close(fd);
+        if (map == MAP_FAILED) {
+            ERR("failed to map zstd file: ", path);
+            exit(EXIT_FAILURE);
+        }
+        ::madvise(map, fsize, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(map);
+#endif
+        size = fsize;
+        for (size_t pos = 0; pos < size;) {
+            auto len = ZSTD_findFrameCompressedSize(data + pos, size - pos);
+            if (ZSTD_isError(len)) {
+                ERR("invalid zstd frame in ", path, " at offset ", pos, ": ", ZSTD_getErrorName(len));
+                exit(EXIT_FAILURE);
+            }
+            frames.push_back({ pos, len });
+            pos += len;
+        }
+        for (size_t i = 0; i < frames.size() && this->threads > 1; ++i) {
+            auto out_len = ZSTD_getFrameContentSize(data + frames[i].pos, frames[i].len);
+            if (frames.size() == 1 || out_len == ZSTD_CONTENTSIZE_UNKNOWN
+                || out_len == ZSTD_CONTENTSIZE_ERROR || out_len > MAX_FRAME_OUT)
+                this->threads = 1; // stream
+        }
+        dctx = ZSTD_createDCtx();
+    }
+
+    // @return false for a single frame file - no seek points
+    static bool is_seekable(const std::string& path) {
+        return ZstdReader(path, 1).frames.size() > 1;
+    }
+
+    ~ZstdReader() override {
+        ahead.clear(); // waits for the frames being decoded
+        ZSTD_freeDCtx(dctx);
+#if !defined(_WIN32)
+        if (data != nullptr && mem.empty())
+            ::munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    static std::string decode_frame(const char* src, size_t len, const std::string& path) {
+        std::string res;
+        auto ctx = ZSTD_createDCtx();
+        ZSTD_inBuffer fin = { src, len, 0 };
+        for (size_t ret = 1; ret != 0 && fin.pos < fin.size;) {
+            auto old = res.size();
+            res.resize(old + OUT_SIZE);
+            ZSTD_outBuffer fout = { &res[old], OUT_SIZE, 0 };
+            ret = ZSTD_decompressStream(ctx, &fout, &fin);
+            if (ZSTD_isError(ret)) {
+                ERR("zstd decompression failed: ", path, " ", ZSTD_getErrorName(ret));
+                exit(EXIT_FAILURE);
+            }
+            res.resize(old + fout.pos);
+        }
+        ZSTD_freeDCtx(ctx);
+        return res;
+    }
+
+    // replace 'out' with the next decompressed block. @return false at the end of file
+    bool next_block() {
+        out_start += out.size();
+        out.clear();
+        out_pos = 0;
+        if (threads > 1) {
+            while (ahead.size() < threads && frame_idx < frames.size()) {
+                const auto& frame = frames[frame_idx++];
+                ahead.push_back(std::async(std::launch::async, decode_frame, data + frame.pos, frame.len, path.generic_string()));
+            }
+            if (ahead.empty())
+                return false;
+            auto idx = frame_idx - ahead.size();
+            if (idx == frame_out.size()) frame_out.push_back(out_start);
+            out = ahead.front().get();
+            ahead.pop_front();
+            return true;
+        }
+
+        if (!is_in_frame) {
+            if (frame_idx >= frames.size())
+                return false;
+            if (frame_idx == frame_out.size()) frame_out.push_back(out_start);
+            in = { data + frames[frame_idx].pos, frames[frame_idx].len, 0 };
+            ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+            is_in_frame = true;
+        }
+        out.resize(OUT_SIZE);
+        ZSTD_outBuffer zout = { &out[0], out.size(), 0 };
+        auto ret = ZSTD_decompressStream(dctx, &zout, &in);
+        if (ZSTD_isError(ret)) {
+            ERR("zstd decompression failed: ", path, " ", ZSTD_getErrorName(ret));
+            exit(EXIT_FAILURE);
+        }
+        out.resize(zout.pos);
+        if (ret == 0 || in.pos == in.size) { // frame done
+            is_in_frame = false;
+            ++frame_idx;
+        }
+        return true;
+    }
+
+    size_t read(char* buf, size_t len) override {
+        size_t num = 0;
+        while (num < len) {
+            if (out_pos < out.size()) {
+                auto n = std::min(len - num, out.size() - out_pos);
+                std::memcpy(buf + num, out.data() + out_pos, n);
+                out_pos += n;
+                num += n;
+            }
+            else if (!next_block()) {
+                break;
+            }
+        }
+        return num;
+    }
+
+    void seek(uint64_t offset) override {
+        ahead.clear();
+        out.clear();
+        out_pos = 0;
+        is_in_frame = false;
+        frame_idx = 0;
+        out_start = 0;
+        if (frame_out.size() == frames.size() && !frames.empty()) {
+            frame_idx = static_cast<size_t>(std::upper_bound(frame_out.begin(), frame_out.end(), offset) - frame_out.begin()) - 1;
+            out_start = frame_out[frame_idx];
+        }
+        // decompress and drop up to the offset
+        for (uint64_t skip = offset - out_start; skip > 0 && next_block();) {
+            auto n = std::min(skip, static_cast<uint64_t>(out.size()));
+            out_pos = static_cast<size_t>(n);
+            skip -= n;
+        }
+    }
+
+    void export_index(std::ofstream& ofs) override {
+        if (frame_out.size() == frames.size())
+            ofs.write(reinterpret_cast<const char*>(frame_out.data()), static_cast<std::streamsize>(frame_out.size() * sizeof(uint64_t)));
+    }
+
+    void import_index(const std::filesystem::path& ipath) override {
+        std::vector<uint64_t> offsets(frames.size());
+        std::ifstream ifs(ipath, std::ios_base::in | std::ios_base::binary);
+        if (ifs.read(reinterpret_cast<char*>(offsets.data()), static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t))))
+            frame_out = std::move(offsets);
+    }
+};
+#endif
+
 // Custom deleter — body defined here so sizeof(GzReaderImpl) is never checked in other TUs.
 void GzReaderDeleter::operator()(GzReaderImpl* p) noexcept { delete p; }
 
+namespace {
+	/* @param is_uring  read the file through io_uring, see 'make_file_reader'. Not for zstd, which is memory-mapped */
+	std::unique_ptr<GzReaderImpl, GzReaderDeleter> make_reader(const Readfile& file, std::size_t threads, bool is_uring = false)
+	{
+		auto path = file.path.generic_string();
+		switch (file.codec) {
+		case COMPRESSION::BZIP2:
+			return std::unique_ptr<GzReaderImpl, GzReaderDeleter>(new Bz2Reader(path, threads, is_uring));
+		case COMPRESSION::ZSTD:
+#if defined(HAVE_ZSTD)
+			return std::unique_ptr<GzReaderImpl, GzReaderDeleter>(new ZstdReader(path, threads));
+#else
+			ERR("zstd compressed reads file: ", path, ". Sortmerna was built without zstd");
+			exit(EXIT_FAILURE);
+#endif
+		default:
+			return std::unique_ptr<GzReaderImpl, GzReaderDeleter>(new GzipReader(path, threads, is_uring));
+		}
+	}
+
+	const char* codec_name(COMPRESSION codec)
+	{
+		switch (codec) {
+		case COMPRESSION::GZIP:  return "gzipped";
+		case COMPRESSION::BGZF:  return "BGZF";
+		case COMPRESSION::BZIP2: return "bzip2";
+		case COMPRESSION::ZSTD:  return "zstd";
+		default:                 return "flat ASCII";
+		}
+	}
+
+	// compression by the magic bytes of the file's start
+	COMPRESSION detect_compression(const std::string& head, size_t len)
+	{
+		auto at = [&head](size_t k) { return static_cast<uint8_t>(head[k]); };
+		if (len >= 2 && at(0) == 0x1F && at(1) == 0x8B) {
+			// BGZF: FEXTRA flag and the subfield 'BC'
+			if (len >= 14 && (at(3) & 0x04) && at(12) == 'B' && at(13) == 'C')
+				return COMPRESSION::BGZF;
+			return COMPRESSION::GZIP;
+		}
+		if (len >= 3 && head.compare(0, 3, "BZh") == 0)
+			return COMPRESSION::BZIP2;
+		if (len >= 4 && at(0) == 0x28 && at(1) == 0xB5 && at(2) == 0x2F && at(3) == 0xFD)
+			return COMPRESSION::ZSTD;
+		return COMPRESSION::NONE;
+	}
+}
+
 // forward
 std::streampos filesize(const std::string& file); //util.cpp
 
@@ -93,12 +598,95 @@ int FlatSlot::getline(std::string& line)
 			if (!fill_buf())
 				return line.empty() ? RL_END : RL_OK;
 		}
-		while (buf_pos < buf_len) {
-			char c = buf[buf_pos++];
-			if (c == '\n') return RL_OK;
-			line += c;
-		}
+		// append up to the newline in one go
+		auto base = buf.data();
+		auto nl = static_cast<const char*>(std::memchr(base + buf_pos, '\n', buf_len - buf_pos));
+		size_t end = nl ? static_cast<size_t>(nl - base) : buf_len;
+		line.append(base + buf_pos, end - buf_pos);
+		buf_pos = end;
+		if (nl) { ++buf_pos; return RL_OK; }
+	}
+}
+
+int FlatSlot::getline(std::string_view& line)
+{
+	if (map_data == nullptr) {
+		auto stat = getline(line_buf);
+		line = line_buf;
+		return stat;
+	}
+	if (map_pos >= map_len) {
+		line = {};
+		return RL_END;
+	}
+#if !defined(_WIN32)
+	// keep the next pages coming while the current ones are parsed
+	if (map_pos + WILLNEED_SIZE / 2 > map_advised && map_advised < map_len) {
+		auto len = std::min(WILLNEED_SIZE, map_len - map_advised);
+		::madvise(const_cast<char*>(map_data) + map_advised, len, MADV_WILLNEED);
+		map_advised += len;
+	}
+#endif
+	auto start = map_data + map_pos;
+	auto nl = static_cast<const char*>(std::memchr(start, '\n', map_len - map_pos));
+	size_t end = nl ? static_cast<size_t>(nl - map_data) : map_len;
+	line = std::string_view(start, end - map_pos);
+	map_pos = nl ? end + 1 : map_len;
+	return RL_OK;
+}
+
+bool FlatSlot::map()
+{
+	unmap();
+#if defined(_WIN32)
+	return false;
+#else
+	if (bytes_end <= bytes_start)
+		return false;
+	static const uint64_t page_size = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+	map_base = bytes_start - bytes_start % page_size; // mmap offset has to be page aligned
+	auto len = static_cast<size_t>(bytes_end - map_base);
+	int fd = ::open(file_path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	void* addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(map_base));
+	::close(fd);
+	if (addr == MAP_FAILED)
+		return false;
+	::madvise(addr, len, MADV_SEQUENTIAL);
+	map_data = static_cast<const char*>(addr);
+	map_len = len;
+	map_pos = static_cast<size_t>(bytes_start - map_base);
+	map_advised = 0;
+	return true;
+#endif
+}
+
+void FlatSlot::unmap()
+{
+#if !defined(_WIN32)
+	if (map_data != nullptr)
+		::munmap(const_cast<char*>(map_data), map_len);
+#endif
+	map_data = nullptr;
+	map_len = 0;
+	map_pos = 0;
+}
+
+void FlatSlot::rewind()
+{
+	if (map_data != nullptr) {
+		map_pos = static_cast<size_t>(bytes_start - map_base);
+		map_advised = 0;
+		return;
 	}
+	if (ifs.is_open()) {
+		if (ifs.rdstate() != std::ios_base::goodbit) ifs.clear();
+		ifs.seekg(static_cast<std::streamoff>(bytes_start));
+	}
+	bytes_remaining = bytes_end - bytes_start;
+	buf_pos = 0;
+	buf_len = 0;
 }
 
 // ---------------------------------------------------------------------------
@@ -109,7 +697,7 @@ bool GzSlot::fill_buf()
 {
 	if (bytes_remaining == 0) return false;
 	size_t toRead = static_cast<size_t>(std::min(static_cast<uint64_t>(BUF_SIZE), bytes_remaining));
-	auto n = reader->rdr.read(reinterpret_cast<char*>(buf.data()), toRead);
+	auto n = reader->read(reinterpret_cast<char*>(buf.data()), toRead);
 	if (n <= 0) { bytes_remaining = 0; return false; }
 	bytes_remaining -= static_cast<uint64_t>(n);
 	buf_pos = 0;
@@ -125,14 +713,385 @@ int GzSlot::getline(std::string& line)
 			if (!fill_buf())
 				return line.empty() ? RL_END : RL_OK; // EOF or end-of-chunk
 		}
-		while (buf_pos < buf_len) {
-			char c = static_cast<char>(buf[buf_pos++]);
-			if (c == '\n') return RL_OK;
-			line += c;
+		// append up to the newline in one go
+		auto base = reinterpret_cast<const char*>(buf.data());
+		auto nl = static_cast<const char*>(std::memchr(base + buf_pos, '\n', buf_len - buf_pos));
+		size_t end = nl ? static_cast<size_t>(nl - base) : buf_len;
+		line.append(base + buf_pos, end - buf_pos);
+		buf_pos = end;
+		if (nl) { ++buf_pos; return RL_OK; }
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ReadCache implementation
+// ---------------------------------------------------------------------------
+
+namespace {
+	template <typename T>
+	void put_val(std::string& buf, T val) {
+		buf.append(reinterpret_cast<const char*>(&val), sizeof(val));
+	}
+
+	template <typename T>
+	T get_val(const char* data, size_t& pos) {
+		T val;
+		std::memcpy(&val, data + pos, sizeof(val));
+		pos += sizeof(val);
+		return val;
+	}
+
+	// 2-bit codes. Anything else is stored as an exception
+	inline int nt_code(char c) {
+		switch (c) {
+		case 'A': return 0;
+		case 'C': return 1;
+		case 'G': return 2;
+		case 'T': return 3;
+		default: return -1;
 		}
 	}
 }
 
+FileId::FileId(const std::filesystem::path& file)
+{
+	std::error_code ec;
+	size = std::filesystem::file_size(file, ec);
+	if (ec) size = 0;
+	auto ftime = std::filesystem::last_write_time(file, ec);
+	mtime = ec ? 0 : static_cast<int64_t>(ftime.time_since_epoch().count());
+
+	// FNV-1a of the first and the last 64 KiB
+	constexpr size_t FP_SIZE = 1U << 16;
+	fingerprint = 14695981039346656037ULL;
+	std::ifstream ifs(file, std::ios_base::in | std::ios_base::binary);
+	std::vector<char> buf(FP_SIZE);
+	auto hash_at = [&](uint64_t pos) {
+		ifs.clear();
+		ifs.seekg(static_cast<std::streamoff>(pos));
+		ifs.read(buf.data(), static_cast<std::streamsize>(FP_SIZE));
+		for (std::streamsize i = 0; i < ifs.gcount(); ++i) {
+			fingerprint ^= static_cast<uint8_t>(buf[i]);
+			fingerprint *= 1099511628211ULL;
+		}
+	};
+	hash_at(0);
+	if (size > FP_SIZE) hash_at(size - FP_SIZE);
+} // ~FileId::FileId
+
+bool ReadCache::open_read(const FileId& src, uint64_t bytes_start, uint64_t bytes_end)
+{
+	close();
+	std::error_code ec;
+	auto fsize = std::filesystem::file_size(path, ec);
+	if (ec || fsize < HEADER_SIZE)
+		return false;
+
+#if defined(_WIN32)
+	std::ifstream ifs(path, std::ios_base::in | std::ios_base::binary);
+	if (!ifs.is_open()) return false;
+	mem.resize(fsize);
+	ifs.read(mem.data(), static_cast<std::streamsize>(fsize));
+	if (static_cast<uint64_t>(ifs.gcount()) != fsize) { mem.clear(); return false; }
+	data = mem.data();
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	void* map = ::mmap(nullptr, fsize, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) return false;
+	::madvise(map, fsize, MADV_SEQUENTIAL);
+	data = static_cast<const char*>(map);
+#endif
+	size = fsize;
+	mode = MODE::READ; // so that 'close' releases the mapping if not valid
+
+	pos = 0;
+	auto magic = get_val<uint32_t>(data, pos);
+	auto version = get_val<uint32_t>(data, pos);
+	FileId c_src;
+	c_src.size = get_val<uint64_t>(data, pos);
+	c_src.mtime = get_val<int64_t>(data, pos);
+	c_src.fingerprint = get_val<uint64_t>(data, pos);
+	auto c_start = get_val<uint64_t>(data, pos);
+	auto c_end = get_val<uint64_t>(data, pos);
+	num_reads = get_val<uint64_t>(data, pos);
+	auto is_done = get_val<uint8_t>(data, pos);
+
+	if (magic != MAGIC || version != VERSION || c_src != src
+		|| c_start != bytes_start || c_end != bytes_end || is_done != 1)
+	{
+		close();
+		return false;
+	}
+	return true;
+} // ~ReadCache::open_read
+
+void ReadCache::open_write(const FileId& src, uint64_t bytes_start, uint64_t bytes_end)
+{
+	close();
+	ofs.open(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!ofs.is_open()) {
+		WARN("failed to open read cache for writing: ", path.generic_string(), " Continuing without cache");
+		return;
+	}
+	num_reads = 0;
+	buf.clear();
+	put_val(buf, MAGIC);
+	put_val(buf, VERSION);
+	put_val(buf, src.size);
+	put_val(buf, src.mtime);
+	put_val(buf, src.fingerprint);
+	put_val(buf, bytes_start);
+	put_val(buf, bytes_end);
+	put_val(buf, num_reads);
+	put_val(buf, uint8_t(0)); // not complete
+	ofs.write(buf.data(), buf.size());
+	mode = MODE::WRITE;
+} // ~ReadCache::open_write
+
+void ReadCache::put(std::string_view header, std::string_view sequence, std::string_view quality)
+{
+	buf.clear();
+	put_val(buf, static_cast<uint32_t>(header.size()));
+	buf.append(header);
+	put_val(buf, static_cast<uint32_t>(sequence.size()));
+
+	// exceptions
+	auto num_exc_pos = buf.size();
+	uint32_t num_exc = 0;
+	put_val(buf, num_exc);
+	for (uint32_t i = 0; i < sequence.size(); ++i) {
+		if (nt_code(sequence[i]) < 0) {
+			put_val(buf, i);
+			buf.push_back(sequence[i]);
+			++num_exc;
+		}
+	}
+	std::memcpy(&buf[num_exc_pos], &num_exc, sizeof(num_exc));
+
+	// 2-bit sequence, 4 nucleotides per byte
+	auto packed_pos = buf.size();
+	buf.append((sequence.size() + 3) / 4, '\0');
+	for (size_t i = 0; i < sequence.size(); ++i) {
+		auto code = nt_code(sequence[i]);
+		if (code > 0)
+			buf[packed_pos + (i >> 2)] |= static_cast<char>(code << ((i & 3) << 1));
+	}
+
+	put_val(buf, static_cast<uint32_t>(quality.size()));
+	buf.append(quality);
+
+	ofs.write(buf.data(), buf.size());
+	++num_reads;
+} // ~ReadCache::put
+
+void ReadCache::finish()
+{
+	if (mode != MODE::WRITE) return;
+	// update number of records and the complete flag in the header
+	ofs.seekp(HEADER_SIZE - sizeof(num_reads) - 1);
+	ofs.write(reinterpret_cast<const char*>(&num_reads), sizeof(num_reads));
+	uint8_t is_done = 1;
+	ofs.write(reinterpret_cast<const char*>(&is_done), sizeof(is_done));
+	ofs.close();
+	if (ofs.fail()) WARN("failed writing read cache: ", path.generic_string());
+	mode = MODE::NONE;
+	INFO("Stored ", num_reads, " reads in read cache: ", path.generic_string());
+} // ~ReadCache::finish
+
+bool ReadCache::get(size_t& at, std::string& readstr) const
+{
+	if (mode != MODE::READ || at >= size)
+		return false;
+
+	auto corrupt = [this, &at]() {
+		ERR("corrupt read cache: ", path.generic_string(), " at offset: ", at, ". Delete the file and re-run");
+		exit(EXIT_FAILURE);
+	};
+	auto check = [this, &at, &corrupt](size_t len) { if (at + len > size) corrupt(); };
+
+	check(sizeof(uint32_t));
+	auto hlen = get_val<uint32_t>(data, at);
+	check(hlen + 2 * sizeof(uint32_t));
+	readstr.append(data + at, hlen).append(1, '\n');
+	at += hlen;
+
+	auto slen = get_val<uint32_t>(data, at);
+	auto num_exc = get_val<uint32_t>(data, at);
+	auto exc_pos = at;
+	auto packed_len = (static_cast<size_t>(slen) + 3) / 4;
+	check(static_cast<size_t>(num_exc) * (sizeof(uint32_t) + 1) + packed_len + sizeof(uint32_t));
+	at += static_cast<size_t>(num_exc) * (sizeof(uint32_t) + 1);
+
+	// unpack 2-bit sequence, then restore the exceptions
+	static const char ACGT[] = { 'A', 'C', 'G', 'T' };
+	auto seq_pos = readstr.size();
+	readstr.resize(seq_pos + slen);
+	for (size_t i = 0; i < slen; ++i)
+		readstr[seq_pos + i] = ACGT[(static_cast<uint8_t>(data[at + (i >> 2)]) >> ((i & 3) << 1)) & 3];
+	at += packed_len;
+	for (uint32_t i = 0; i < num_exc; ++i) {
+		auto epos = get_val<uint32_t>(data, exc_pos);
+		if (epos >= slen) corrupt();
+		readstr[seq_pos + epos] = data[exc_pos++];
+	}
+
+	auto qlen = get_val<uint32_t>(data, at);
+	check(qlen);
+	if (qlen > 0)
+		readstr.append(1, '\n').append(data + at, qlen);
+	at += qlen;
+	return true;
+} // ~ReadCache::get
+
+bool ReadCache::skip(size_t& at) const
+{
+	if (mode != MODE::READ || at >= size)
+		return false;
+
+	// lengths only, the record is not decoded. Validated by 'get' on the passes not skipping
+	auto skip_len = [this, &at]() {
+		if (at + sizeof(uint32_t) > size) return false;
+		auto len = get_val<uint32_t>(data, at);
+		at += len;
+		return true;
+	};
+	if (!skip_len()) return false; // header
+	if (at + 2 * sizeof(uint32_t) > size) return false;
+	auto slen = get_val<uint32_t>(data, at);
+	auto num_exc = get_val<uint32_t>(data, at);
+	at += static_cast<size_t>(num_exc) * (sizeof(uint32_t) + 1) + (static_cast<size_t>(slen) + 3) / 4;
+	return skip_len() && at <= size; // quality
+} // ~ReadCache::skip
+
+void ReadCache::close()
+{
+	if (ofs.is_open()) ofs.close(); // incomplete i.e. not usable
+#if !defined(_WIN32)
+	if (data != nullptr && mem.empty())
+		::munmap(const_cast<char*>(data), size);
+#endif
+	mem.clear();
+	mem.shrink_to_fit();
+	data = nullptr;
+	size = 0;
+	pos = 0;
+	mode = MODE::NONE;
+} // ~ReadCache::close
+
+// ---------------------------------------------------------------------------
+// ReadIndex implementation
+// ---------------------------------------------------------------------------
+
+void ReadIndex::init(const std::filesystem::path& basedir, const std::filesystem::path& readfile, uint32_t lines_per_record)
+{
+	this->readfile = readfile;
+	this->lines_per_record = lines_per_record;
+	path = basedir / ("readindex_" + std::to_string(std::hash<std::string>{}(std::filesystem::absolute(readfile).generic_string())) + ".bin");
+	file_id = FileId(readfile);
+} // ~ReadIndex::init
+
+bool ReadIndex::load()
+{
+	is_loaded = false;
+	std::ifstream ifs(path, std::ios_base::in | std::ios_base::binary);
+	if (!ifs.is_open())
+		return false;
+
+	std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	constexpr size_t HEAD_SIZE = 4 + 4 + 8 + 8 + 8 + 4 + 8 + 8 + 4 + 4 + 8 + 8 + 8;
+	if (data.size() < HEAD_SIZE)
+		return false;
+
+	size_t pos = 0;
+	auto magic = get_val<uint32_t>(data.data(), pos);
+	auto version = get_val<uint32_t>(data.data(), pos);
+	auto c_file_size = get_val<uint64_t>(data.data(), pos);
+	auto c_mtime = get_val<int64_t>(data.data(), pos);
+	auto c_fingerprint = get_val<uint64_t>(data.data(), pos);
+	auto c_lines_per_record = get_val<uint32_t>(data.data(), pos);
+	if (magic != MAGIC || version != VERSION || c_file_size != file_id.size || c_mtime != file_id.mtime
+		|| c_fingerprint != file_id.fingerprint || c_lines_per_record != lines_per_record)
+		return false;
+
+	num_reads = get_val<uint64_t>(data.data(), pos);
+	length_all = get_val<uint64_t>(data.data(), pos);
+	min_len = get_val<uint32_t>(data.data(), pos);
+	max_len = get_val<uint32_t>(data.data(), pos);
+	num_records = get_val<uint64_t>(data.data(), pos);
+	recs_per_checkpoint = get_val<uint64_t>(data.data(), pos);
+	auto num_checkpoints = get_val<uint64_t>(data.data(), pos);
+	if (recs_per_checkpoint == 0 || data.size() != HEAD_SIZE + num_checkpoints * sizeof(uint64_t)
+		|| num_checkpoints != (num_records + recs_per_checkpoint - 1) / recs_per_checkpoint + 1)
+		return false;
+
+	checkpoints.resize(num_checkpoints);
+	std::memcpy(checkpoints.data(), data.data() + pos, num_checkpoints * sizeof(uint64_t));
+	is_loaded = true;
+	return true;
+} // ~ReadIndex::load
+
+void ReadIndex::store()
+{
+	std::string buf;
+	put_val(buf, MAGIC);
+	put_val(buf, VERSION);
+	put_val(buf, file_id.size);
+	put_val(buf, file_id.mtime);
+	put_val(buf, file_id.fingerprint);
+	put_val(buf, lines_per_record);
+	put_val(buf, num_reads);
+	put_val(buf, length_all);
+	put_val(buf, min_len);
+	put_val(buf, max_len);
+	put_val(buf, num_records);
+	put_val(buf, recs_per_checkpoint);
+	put_val(buf, static_cast<uint64_t>(checkpoints.size()));
+	buf.append(reinterpret_cast<const char*>(checkpoints.data()), checkpoints.size() * sizeof(uint64_t));
+
+	// write aside and rename, so that an interrupted write never leaves a valid looking index
+	auto tmp = std::filesystem::path(path).concat(".tmp");
+	std::ofstream ofs(tmp, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	ofs.write(buf.data(), buf.size());
+	ofs.close();
+	std::error_code ec;
+	if (!ofs.fail())
+		std::filesystem::rename(tmp, path, ec);
+	if (ofs.fail() || ec) {
+		WARN("failed writing reads index: ", path.generic_string());
+		std::filesystem::remove(tmp, ec);
+		return;
+	}
+	INFO("Stored reads index: ", path.generic_string());
+} // ~ReadIndex::store
+
+void ReadIndex::set_checkpoints(const std::vector<uint64_t>& newline_ends, uint64_t rec_unit)
+{
+	num_records = newline_ends.size() / lines_per_record;
+	// no more than MAX_CHECKPOINTS, but no coarser than needed - small files are chunked exactly
+	auto num_units = (num_records + rec_unit - 1) / rec_unit;
+	recs_per_checkpoint = rec_unit * std::max<uint64_t>(1, (num_units + MAX_CHECKPOINTS - 1) / MAX_CHECKPOINTS);
+
+	checkpoints.clear();
+	checkpoints.reserve(num_records / recs_per_checkpoint + 2);
+	for (uint64_t rec = 0; rec < num_records; rec += recs_per_checkpoint)
+		checkpoints.push_back(rec == 0 ? 0 : newline_ends[rec * lines_per_record - 1]);
+	checkpoints.push_back(newline_ends.empty() ? 0 : newline_ends.back());
+} // ~ReadIndex::set_checkpoints
+
+uint64_t ReadIndex::chunk_start(uint64_t i, uint64_t num_chunks) const
+{
+	if (i >= num_chunks)
+		return num_records;
+	return ((num_records * i) / num_chunks / recs_per_checkpoint) * recs_per_checkpoint;
+}
+
+uint64_t ReadIndex::offset(uint64_t rec) const
+{
+	return rec >= num_records ? checkpoints.back() : checkpoints[rec / recs_per_checkpoint];
+}
+
 /*
  @param type       feed type
  @param readfiles  vector with reads file paths
@@ -155,13 +1114,24 @@ Readfeed::Readfeed(FEED_TYPE type,
 	is_paired(is_paired),
 	num_orig_files(readfiles.size()),
 	num_splits(0),
+	num_chunks(0),
+	chunks_per_split(1),
 	num_split_files(0),
 	num_sense(0),
 	num_reads_tot(0),
 	length_all(0),
 	min_read_len(0),
 	max_read_len(0),
-	basedir(basedir)
+	is_read_cache(false),
+	is_skip_done(false),
+	is_prescan(true),
+	is_io_uring(false),
+	is_estimated(false),
+	is_stream(false),
+	is_spool(true),
+	is_stream_replay(false),
+	basedir(basedir),
+	chunk_next(0)
 {
 	init(readfiles);
 } // ~Readfeed::Readfeed 1
@@ -170,7 +1140,10 @@ Readfeed::Readfeed(FEED_TYPE type,
                     std::vector<std::string>& readfiles, 
                     const unsigned num_parts, 
                     std::filesystem::path& basedir, 
-                    bool is_paired)
+                    bool is_paired,
+                    const unsigned chunks_per_part,
+                    const bool is_prescan,
+                    const bool is_io_uring)
 	:
 	type(type),
 	is_done(false),
@@ -180,18 +1153,38 @@ Readfeed::Readfeed(FEED_TYPE type,
 	is_paired(is_paired),
 	num_orig_files(readfiles.size()),
 	num_splits(num_parts),
+	num_chunks(0),
+	chunks_per_split(type == FEED_TYPE::INDEXED && chunks_per_part > 0 ? chunks_per_part : 1),
 	num_split_files(0),
 	num_sense(0),
 	num_reads_tot(0),
 	length_all(0),
 	min_read_len(0),
 	max_read_len(0),
-	basedir(basedir)
+	is_read_cache(false),
+	is_skip_done(false),
+	is_prescan(is_prescan),
+	is_io_uring(is_io_uring),
+	is_estimated(false),
+	is_stream(false),
+	is_spool(true),
+	is_stream_replay(false),
+	basedir(basedir),
+	chunk_next(0)
 {
 	init(readfiles);
 } //~Readfeed::Readfeed 2
 
-//Readfeed::~Readfeed() {}
+Readfeed::~Readfeed()
+{
+	{
+		std::lock_guard<std::mutex> lock(stream_lock);
+		is_stream_abort = true;
+	}
+	stream_cv_put.notify_all();
+	if (stream_thread.joinable())
+		stream_thread.join();
+} // ~Readfeed::~Readfeed
 
 void Readfeed::init(std::vector<std::string>& readfiles, const int& dbg)
 {
@@ -199,19 +1192,40 @@ void Readfeed::init(std::vector<std::string>& readfiles, const int& dbg)
 	INFO("Readfeed init started");
 
 	num_sense = is_paired ? 2 : 1;
-	num_split_files = num_sense * num_splits;
+	num_chunks = num_splits * chunks_per_split;
+	num_split_files = num_sense * num_chunks;
 
 	// init read files
 	orig_files.resize(num_orig_files);
 	for (decltype(num_orig_files) i = 0; i < num_orig_files; ++i) {
 		orig_files[i].path = readfiles[i];
-		orig_files[i].size = filesize(readfiles[i]);
+		is_stream = is_stream || is_stream_path(readfiles[i]);
+		if (!is_stream_path(readfiles[i]))
+			orig_files[i].size = filesize(readfiles[i]);
+	}
+
+	if (is_stream) {
+		init_stream();
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		INFO("Readfeed init done in sec [", elapsed.count(), "]\n");
+		return;
 	}
 
 	define_format();
     // calculate this.num_reads_tot
     if (type == FEED_TYPE::INDEXED) {
-        count_reads_parallel();
+        // chunks of paired or compressed reads have to be cut at known record numbers, which needs the scan
+        const bool is_estimable = !is_prescan && num_orig_files == 1 && num_sense == 1 && !orig_files[0].isZip;
+        if (!load_read_index()) {
+            if (is_estimable)
+                estimate_reads();
+            else {
+                if (!is_prescan)
+                    WARN("'--no_prescan' is ignored for ", (num_sense > 1 ? "paired" : "compressed"),
+                        " reads. Counting the reads before the alignment");
+                count_reads_parallel();
+            }
+        }
     }
     else {
         count_reads();
@@ -251,9 +1265,16 @@ void Readfeed::init(std::vector<std::string>& readfiles, const int& dbg)
         else {
 		    build_flat_chunk_offsets();
         }
+		store_read_index();
 		is_ready = true;
 	}
 	else if (type == FEED_TYPE::SPLIT_READS) {
+		for (const auto& file : orig_files) {
+			if (file.codec == COMPRESSION::BZIP2 || file.codec == COMPRESSION::ZSTD) {
+				ERR(codec_name(file.codec), " reads file: ", file.path, " is only supported by the indexed feed");
+				exit(EXIT_FAILURE);
+			}
+		}
 		init_split_files();
 		is_ready = is_split_ready();
 		if (is_ready) { INFO("split is ready - no need to run"); }
@@ -684,12 +1705,10 @@ bool Readfeed::next_gz(int inext, std::string& readstr, bool is_orig)
 {
 	// For interleaved paired (single file), FWD and REV slots share one reader.
 	// REV slot (inext % num_sense != 0) delegates to its FWD partner's reader and state.
-	const int slot_idx = (num_orig_files < num_sense && inext % static_cast<int>(num_sense) != 0)
-	                     ? inext - (inext % static_cast<int>(num_sense))
-	                     : inext;
+	const int slot_idx = get_slot_idx(inext);
 
 	std::string line;
-	std::stringstream readss;
+	readstr.clear(); // the record is assembled in place, no intermediate stream
 	auto stat = vstate_in[slot_idx].last_stat;
 	auto& files = gz_slot_files;
 
@@ -697,8 +1716,8 @@ bool Readfeed::next_gz(int inext, std::string& readstr, bool is_orig)
 	{
 		if (vstate_in[slot_idx].last_header.size() > 0) {
 			if (!is_orig)
-				readss << inext << '_' << vstate_in[slot_idx].read_count << '\n';
-			readss << vstate_in[slot_idx].last_header << '\n';
+				readstr.append(std::to_string(get_id_idx(inext, slot_idx))).append(1, '_').append(std::to_string(vstate_in[slot_idx].read_count)).append(1, '\n');
+			readstr.append(vstate_in[slot_idx].last_header).append(1, '\n');
 			vstate_in[slot_idx].last_header = "";
 		}
 
@@ -707,13 +1726,12 @@ bool Readfeed::next_gz(int inext, std::string& readstr, bool is_orig)
 			stat = gz_slots[slot_idx].getline(line);
 		}
 
-		if (!line.empty()) {
-			line.erase(std::find_if(line.rbegin(), line.rend(),
-				[l = std::locale{}](auto ch) { return !std::isspace(ch, l); }).base(), line.end());
-		}
+		// trim trailing whitespace e.g. '\r'
+		while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+			line.pop_back();
 
 		if (stat == RL_END) {
-			if (!line.empty()) readss << line;
+			if (!line.empty()) readstr.append(line);
 			vstate_in[slot_idx].is_done = true;
 			auto FR = (inext & 1) == 0 ? FWD : REV;
 			INFO("EOF ", FR, " reached. Total reads: ", ++vstate_in[slot_idx].read_count);
@@ -742,11 +1760,11 @@ bool Readfeed::next_gz(int inext, std::string& readstr, bool is_orig)
 		{
 			if (vstate_in[slot_idx].line_count == 1) {
 				if (!is_orig)
-					readss << inext << '_' << vstate_in[slot_idx].read_count << '\n';
-				readss << line << '\n';
+					readstr.append(std::to_string(get_id_idx(inext, slot_idx))).append(1, '_').append(std::to_string(vstate_in[slot_idx].read_count)).append(1, '\n');
+				readstr.append(line).append(1, '\n');
 				count = 0;
 			} else {
-				if (files[slot_idx].isFasta) readss << '\n';
+				if (files[slot_idx].isFasta) readstr.append(1, '\n');
 				vstate_in[slot_idx].last_header = line;
 				vstate_in[slot_idx].last_count  = 1;
 				vstate_in[slot_idx].last_stat   = stat;
@@ -754,19 +1772,19 @@ bool Readfeed::next_gz(int inext, std::string& readstr, bool is_orig)
 			}
 		} else {
 			if (files[slot_idx].isFastq) {
-				if (count == 2) { if (is_orig) readss << line << '\n'; continue; }
-				if (count == 3) { readss << line; if (is_orig) readss << '\n'; continue; }
-				readss << line << '\n';
+				if (count == 2) { if (is_orig) readstr.append(line).append(1, '\n'); continue; }
+				if (count == 3) { readstr.append(line); if (is_orig) readstr.append(1, '\n'); continue; }
+				readstr.append(line).append(1, '\n');
 			} else {
-				readss << line;
+				readstr.append(line);
 			}
 		}
 	} // ~for getline
 
 	++vstate_in[slot_idx].read_count;
-	auto is_read_ok = readss.str().size() > 0;
-	if (is_read_ok) readstr = readss.str();
-	return is_read_ok;
+	if (is_read_cache && !is_orig)
+		put_read_cache(slot_idx, readstr);
+	return readstr.size() > 0;
 } // ~Readfeed::next_gz
 
 /*
@@ -777,12 +1795,10 @@ bool Readfeed::next_flat(int inext, std::string& readstr, bool is_orig)
 {
 	// For interleaved paired (single file), FWD and REV slots share one ifstream.
 	// REV slot (inext % num_sense != 0) delegates to its FWD partner's ifstream and state.
-	const int slot_idx = (num_orig_files < num_sense && inext % static_cast<int>(num_sense) != 0)
-	                     ? inext - (inext % static_cast<int>(num_sense))
-	                     : inext;
+	const int slot_idx = get_slot_idx(inext);
 
-	std::string line;
-	std::stringstream readss;
+	std::string_view line; // into the slot's mapping or buffer, see 'FlatSlot::getline'
+	readstr.clear(); // the record is assembled in place, no intermediate stream
 	auto stat = vstate_in[slot_idx].last_stat;
 	auto& files = flat_slot_files;
 
@@ -790,23 +1806,22 @@ bool Readfeed::next_flat(int inext, std::string& readstr, bool is_orig)
 	{
 		if (vstate_in[slot_idx].last_header.size() > 0) {
 			if (!is_orig)
-				readss << slot_idx << '_' << vstate_in[slot_idx].read_count << '\n';
-			readss << vstate_in[slot_idx].last_header << '\n';
+				readstr.append(std::to_string(slot_idx)).append(1, '_').append(std::to_string(vstate_in[slot_idx].read_count)).append(1, '\n');
+			readstr.append(vstate_in[slot_idx].last_header).append(1, '\n');
 			vstate_in[slot_idx].last_header = "";
 		}
 
-		line = "";
+		line = {};
 		if (!vstate_in[slot_idx].is_done) {
 			stat = flat_slots[slot_idx].getline(line);
 		}
 
-		if (!line.empty()) {
-			line.erase(std::find_if(line.rbegin(), line.rend(),
-				[l = std::locale{}](auto ch) { return !std::isspace(ch, l); }).base(), line.end());
-		}
+		// trim trailing whitespace e.g. '\r'
+		while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+			line.remove_suffix(1);
 
 		if (stat == RL_END) {
-			if (!line.empty()) readss << line;
+			if (!line.empty()) readstr.append(line);
 			vstate_in[slot_idx].is_done = true;
             if (num_orig_files == 1) {
 			    INFO("EOF reached. Slot: ", slot_idx, " Total reads: ", ++vstate_in[slot_idx].read_count);
@@ -845,45 +1860,233 @@ bool Readfeed::next_flat(int inext, std::string& readstr, bool is_orig)
 		{
 			if (vstate_in[slot_idx].line_count == 1) {
 				if (!is_orig)
-					readss << slot_idx << '_' << vstate_in[slot_idx].read_count << '\n';
-				readss << line << '\n';
+					readstr.append(std::to_string(slot_idx)).append(1, '_').append(std::to_string(vstate_in[slot_idx].read_count)).append(1, '\n');
+				readstr.append(line).append(1, '\n');
 				count = 0;
 			} else {
-				if (files[slot_idx].isFasta) readss << '\n';
-				vstate_in[slot_idx].last_header = line;
+				if (files[slot_idx].isFasta) readstr.append(1, '\n');
+				vstate_in[slot_idx].last_header.assign(line.data(), line.size());
 				vstate_in[slot_idx].last_count  = 1;
 				vstate_in[slot_idx].last_stat   = stat;
 				break;
 			}
 		} else {
 			if (files[slot_idx].isFastq) {
-				if (count == 2) { if (is_orig) readss << line << '\n'; continue; }
-				if (count == 3) { readss << line; if (is_orig) readss << '\n'; continue; }
-				readss << line << '\n';
+				if (count == 2) { if (is_orig) readstr.append(line).append(1, '\n'); continue; }
+				if (count == 3) { readstr.append(line); if (is_orig) readstr.append(1, '\n'); continue; }
+				readstr.append(line).append(1, '\n');
 			} else {
-				readss << line;
+				readstr.append(line);
 			}
 		}
 	} // ~for getline
 
 	++vstate_in[slot_idx].read_count;
-	auto is_read_ok = readss.str().size() > 0;
-	if (is_read_ok) readstr = readss.str();
-	return is_read_ok;
+	if (is_read_cache && !is_orig)
+		put_read_cache(slot_idx, readstr);
+	return readstr.size() > 0;
 } // ~Readfeed::next_flat
 
+/*
+ * next_cached  (INDEXED with read cache)
+ * Replays the reads stored in the slot's read cache on the first pass. 
+ * The read IDs are generated exactly as in next_gz/next_flat.
+ */
+bool Readfeed::next_cached(int inext, int slot_idx, std::string& readstr)
+{
+	auto& state = vstate_in[slot_idx];
+	readstr.clear();
+	if (state.is_done) {
+		++state.read_count;
+		return false;
+	}
+
+	readstr.append(std::to_string(get_id_idx(inext, slot_idx))).append(1, '_').append(std::to_string(state.read_count)).append(1, '\n');
+	if (!read_caches[slot_idx].get(readstr)) {
+		readstr.clear();
+		state.is_done = true;
+		INFO("End of read cache reached. Slot: ", slot_idx, " Total reads: ", state.read_count);
+		return false;
+	}
+	++state.read_count;
+	return true;
+} // ~Readfeed::next_cached
+
+bool Readfeed::init_read_cache(std::size_t slot_idx, const std::string& file_path, uint64_t bytes_start, uint64_t bytes_end)
+{
+	auto& cache = read_caches[slot_idx];
+	if (cache.mode == ReadCache::MODE::READ) {
+		cache.pos = ReadCache::HEADER_SIZE; // rewind
+		return true;
+	}
+
+	cache.path = basedir / ("readcache_" + std::to_string(std::hash<std::string>{}(file_path)) 
+		+ "_" + std::to_string(slot_idx) + ".bin");
+	// identified at the start, see 'load_read_index'
+	const auto& src = read_index[slot_idx % num_orig_files].file_id;
+	if (cache.open_read(src, bytes_start, bytes_end)) {
+		INFO("Using read cache: ", cache.path.generic_string(), " reads: ", cache.num_reads);
+		return true;
+	}
+	cache.open_write(src, bytes_start, bytes_end);
+	return false;
+} // ~Readfeed::init_read_cache
+
+void Readfeed::put_read_cache(int slot_idx, const std::string& readstr)
+{
+	auto& cache = read_caches[slot_idx];
+	if (cache.mode != ReadCache::MODE::WRITE)
+		return;
+	if (readstr.size() > 0) {
+		ReadView view;
+		if (view.parse(readstr))
+			cache.put(view.header, view.sequence, view.quality);
+	}
+	if (vstate_in[slot_idx].is_done)
+		cache.finish();
+} // ~Readfeed::put_read_cache
+
+int Readfeed::get_slot_idx(int inext)
+{
+	return (num_orig_files < num_sense && inext % static_cast<int>(num_sense) != 0)
+		? inext - (inext % static_cast<int>(num_sense))
+		: inext;
+}
+
+int Readfeed::get_id_idx(int inext, int slot_idx)
+{
+	if (!orig_files[0].isZip)
+		return slot_idx; // see next_flat
+	if (num_orig_files < num_sense)
+		return slot_idx + static_cast<int>(vstate_in[slot_idx].read_count % num_sense);
+	return inext;
+}
+
+void Readfeed::set_done(std::size_t readfile_idx, std::size_t read_num)
+{
+	if (type != FEED_TYPE::INDEXED)
+		return;
+	auto slot_idx = is_stream ? 0 : get_slot_idx(static_cast<int>(readfile_idx));
+	if (static_cast<std::size_t>(slot_idx) >= done_bits.size())
+		return;
+	std::unique_lock<std::mutex> lock(stream_lock, std::defer_lock);
+	if (is_stream)
+		lock.lock(); // the bits are shared by the chunks, see 'next_stream'
+	auto& bits = done_bits[slot_idx];
+	if (bits.size() <= (read_num >> 6))
+		bits.resize((read_num >> 6) + 1, 0);
+	bits[read_num >> 6] |= uint64_t(1) << (read_num & 63);
+} // ~Readfeed::set_done
+
+bool Readfeed::next_chunk(unsigned& chunk)
+{
+	chunk = chunk_next.fetch_add(1, std::memory_order_relaxed);
+	return chunk < num_chunks;
+}
+
+uint64_t Readfeed::get_num_skipped_done()
+{
+	uint64_t num = 0;
+	for (auto n : num_skipped_done) num += n;
+	return num;
+}
+
+void Readfeed::count_slot(int slot_idx, bool is_next, const std::string& readstr)
+{
+	auto& count = slot_counts[slot_idx];
+	if (count.is_done)
+		return;
+	if (!is_next) {
+		count.is_done = true;
+		return;
+	}
+	ReadView view;
+	if (!view.parse(readstr))
+		return;
+	auto len = static_cast<uint32_t>(view.sequence.size());
+	++count.num_reads;
+	count.length += len;
+	if (len > count.max_len) count.max_len = len;
+	if (count.min_len == 0 || len < count.min_len) count.min_len = len;
+} // ~Readfeed::count_slot
+
+bool Readfeed::reconcile_counts()
+{
+	if (!is_estimated || slot_counts.empty())
+		return false;
+
+	SlotCount total;
+	for (const auto& count : slot_counts) {
+		if (!count.is_done)
+			return false;
+		total.num_reads += count.num_reads;
+		total.length += count.length;
+		if (count.max_len > total.max_len) total.max_len = count.max_len;
+		if (total.min_len == 0 || (count.min_len > 0 && count.min_len < total.min_len))
+			total.min_len = count.min_len;
+	}
+
+	INFO("Reads statistics estimated: reads: ", num_reads_tot, " length: ", length_all,
+		" counted: reads: ", total.num_reads, " length: ", total.length);
+	num_reads_tot = total.num_reads;
+	length_all = total.length;
+	min_read_len = total.min_len;
+	max_read_len = total.max_len;
+	orig_files[0].numreads = static_cast<unsigned>(total.num_reads);
+	is_estimated = false;
+	return true;
+} // ~Readfeed::reconcile_counts
+
 /*
  * public function
+ *
+ * With 'is_skip_done' the reads flagged by 'set_done' are passed over here. The record still has to be
+ * scanned to find the next one (or just stepped over in the read cache), but it is neither returned,
+ * parsed into a Read nor looked up in the Key-value DB.
  */
 bool Readfeed::next(int inext, std::string& readstr)
 {
 	if (type == FEED_TYPE::SPLIT_READS)
 		return next(inext, readstr, false, split_files);
-	if (type == FEED_TYPE::INDEXED && orig_files[0].isZip)
-		return next_gz(inext, readstr, false);
-	if (type == FEED_TYPE::INDEXED && !orig_files[0].isZip)
-		return next_flat(inext, readstr, false);
-	return false;
+	if (type != FEED_TYPE::INDEXED)
+		return false;
+	if (is_stream)
+		return next_stream(inext, readstr);
+
+	// interleaved paired: REV slot shares the FWD slot's reader and cache
+	const int slot_idx = get_slot_idx(inext);
+	const bool is_cached = is_read_cache && read_caches[slot_idx].mode == ReadCache::MODE::READ;
+	for (;;) {
+		auto read_num = vstate_in[slot_idx].read_count; // number of the record to be read next
+		const auto& bits = done_bits[slot_idx]; // sized in 'init_reading'
+		bool is_skip = is_skip_done && (read_num >> 6) < bits.size() && ((bits[read_num >> 6] >> (read_num & 63)) & 1);
+		if (is_skip && is_cached && read_caches[slot_idx].skip()) {
+			++vstate_in[slot_idx].read_count;
+			++num_skipped_done[slot_idx];
+			continue;
+		}
+
+		bool is_next = false;
+		if (is_cached)
+			is_next = next_cached(inext, slot_idx, readstr);
+		else if (orig_files[0].isZip)
+			is_next = next_gz(inext, readstr, false);
+		else
+			is_next = next_flat(inext, readstr, false);
+
+		if (is_estimated)
+			count_slot(slot_idx, is_next, readstr);
+
+		if (!is_skip || !is_next)
+			return is_next;
+		++num_skipped_done[slot_idx];
+	}
+} // ~Readfeed::next
+
+bool Readfeed::is_stream_path(const std::string& path)
+{
+	std::error_code ec;
+	return path == "-" || std::filesystem::is_fifo(path, ec);
 }
 
 /**
@@ -909,13 +2112,19 @@ void Readfeed::rewind() {
   rewind IN feed
 */
 void Readfeed::rewind_in() {
+	chunk_next.store(0, std::memory_order_relaxed);
+	if (is_stream) {
+		stream_join();
+		return;
+	}
 	if (type == FEED_TYPE::INDEXED && orig_files[0].isZip) {
 		const bool is_interleaved = (num_orig_files < num_sense);
 		for (std::size_t i = 0; i < gz_slots.size(); ++i) {
 			if (is_interleaved && i % num_sense != 0) continue; // REV slots share FWD reader
 			auto& slot = gz_slots[i];
-			if (slot.reader) {
-				slot.reader->rdr.seek(static_cast<long long>(slot.bytes_start));
+			if (is_read_cache) init_read_cache(i, slot.file_path, slot.bytes_start, slot.bytes_end);
+			if (slot.reader && slot.bytes_end > slot.bytes_start) {
+				slot.reader->seek(slot.bytes_start);
 			}
 			slot.bytes_remaining = slot.bytes_end - slot.bytes_start;
 			slot.buf_pos = 0;
@@ -930,13 +2139,8 @@ void Readfeed::rewind_in() {
 		for (std::size_t i = 0; i < flat_slots.size(); ++i) {
 			if (is_interleaved && i % num_sense != 0) continue; // REV slots share FWD ifstream
 			auto& slot = flat_slots[i];
-			if (slot.ifs.is_open()) {
-				if (slot.ifs.rdstate() != std::ios_base::goodbit) slot.ifs.clear();
-				slot.ifs.seekg(static_cast<std::streamoff>(slot.bytes_start));
-			}
-			slot.bytes_remaining = slot.bytes_end - slot.bytes_start;
-			slot.buf_pos = 0;
-			slot.buf_len = 0;
+			if (is_read_cache) init_read_cache(i, slot.file_path, slot.bytes_start, slot.bytes_end);
+			slot.rewind();
 			if (i < vstate_in.size()) vstate_in[i].reset();
 		}
 		return;
@@ -1098,87 +2302,113 @@ bool Readfeed::split()
 //
 // For each original gz file, do a single-pass decompression scan to collect
 // the decompressed byte offset after every newline.  Then divide those line
-// offsets into num_splits record-aligned chunks and store the byte boundaries
+// offsets into num_chunks record-aligned chunks and store the byte boundaries
 // in gz_slots[].
 // ---------------------------------------------------------------------------
 void Readfeed::build_chunk_offsets()
 {
 	auto start = std::chrono::high_resolution_clock::now();
 	INFO("build_chunk_offsets: computing byte-range chunks for ", 
-            num_orig_files, " file(s) x ", num_splits, " split(s)");
+            num_orig_files, " file(s) x ", num_chunks, " chunk(s)");
 
 	const int linesPerRecord = orig_files[0].isFastq ? 4 : 2;
 	// For a single interleaved paired file, chunk boundaries must align to complete pairs
 	// (FWD + REV), so FWD and REV slot readers stay in sync when they share a reader.
-	const bool is_interleaved = (num_orig_files < num_sense);
-	const int alignUnit = is_interleaved ? linesPerRecord * static_cast<int>(num_sense) : linesPerRecord;
+	// The index checkpoints are always on pairs, so that the same index serves single and paired runs.
+	const uint64_t alignRecords = 2;
 
 	gz_slots.resize(num_split_files);
 	gz_slot_files.resize(num_split_files);
 
+	// A seek into a single frame zstd file decompresses everything before the offset, for each slot on
+	// each pass. All the reads of such a file, and of its mate, go to the slots of the first chunk
+	bool is_sequential = false;
+#if defined(HAVE_ZSTD)
+	for (auto const& file : orig_files) {
+		if (file.codec == COMPRESSION::ZSTD && !ZstdReader::is_seekable(file.path.generic_string())) {
+			WARN("zstd file ", file.path.generic_string(), " is a single frame and is read by a single thread.",
+				" Compress in frames e.g. using 'pzstd' to read it in parallel");
+			is_sequential = true;
+		}
+	}
+#endif
+
 	for (size_t j = 0; j < num_orig_files; ++j) {
 		auto& origFile = orig_files[j];
 
 		// Pre-populate slot metadata for this file's sense (FWD slot only for interleaved)
-		for (size_t i = 0; i < num_splits; ++i) {
+		for (size_t i = 0; i < num_chunks; ++i) {
 			size_t slotIdx = i * num_sense + j;
 			gz_slot_files[slotIdx].path     = origFile.path;
 			gz_slot_files[slotIdx].isZip    = true;
+			gz_slot_files[slotIdx].codec    = origFile.codec;
 			gz_slot_files[slotIdx].isFastq  = origFile.isFastq;
 			gz_slot_files[slotIdx].isFasta  = origFile.isFasta;
 			gz_slots[slotIdx].file_path     = origFile.path.generic_string();
 		}
 
-		// Pass 1: decompress entire file, collect newline offsets
-		INFO("scanning ", origFile.path.generic_string());
-		std::vector<uint64_t> newlineEnds;
-		newlineEnds.reserve(static_cast<size_t>(origFile.numreads) * linesPerRecord + 1);
+		// Pass 1 is not needed if the reads index of a previous run matches the file
+		auto& ridx = read_index[j];
+		if (ridx.is_loaded) {
+			INFO("build_chunk_offsets: file ", j, " using reads index: ", ridx.path.generic_string());
+		}
+		else {
+			// Pass 1: decompress entire file, collect newline offsets
+			INFO("scanning ", origFile.path.generic_string());
+			std::vector<uint64_t> newlineEnds;
+			newlineEnds.reserve(static_cast<size_t>(origFile.numreads) * linesPerRecord + 1);
 
-		{
-			using PGR = rapidgzip::ParallelGzipReader<>;
-			auto reader = std::make_unique<PGR>(
-				std::make_unique<rapidgzip::StandardFileReader>(origFile.path.generic_string()),
-				static_cast<size_t>(num_splits)
-			);
-			constexpr size_t CHUNK = 1U << 20; // 1 MiB
-			std::vector<uint8_t> buf(CHUNK);
-			uint64_t pos = 0;
-			for (;;) {
-				auto n = reader->read(reinterpret_cast<char*>(buf.data()), CHUNK);
-				if (n <= 0) break;
-				for (size_t k = 0; k < static_cast<size_t>(n); ++k) {
-					if (buf[k] == '\n') newlineEnds.push_back(pos + k + 1);
+			{
+				auto reader = make_reader(origFile, static_cast<size_t>(num_splits), is_io_uring);
+				constexpr size_t CHUNK = 1U << 20; // 1 MiB
+				std::vector<uint8_t> buf(CHUNK);
+				uint64_t pos = 0;
+				for (;;) {
+					auto n = reader->read(reinterpret_cast<char*>(buf.data()), CHUNK);
+					if (n <= 0) break;
+					for (size_t k = 0; k < static_cast<size_t>(n); ++k) {
+						if (buf[k] == '\n') newlineEnds.push_back(pos + k + 1);
+					}
+					pos += static_cast<uint64_t>(n);
 				}
-				pos += static_cast<uint64_t>(n);
-			}
-		}
 
-		const uint64_t totalLines = static_cast<uint64_t>(newlineEnds.size());
-		INFO("build_chunk_offsets: file ", j, " totalLines=", totalLines);
+				// the seek points found by the full decompression are reused by the slot readers
+				auto gzi_path = ridx.gz_index_path();
+				std::error_code ec;
+				std::filesystem::remove(gzi_path, ec);
+				try {
+					std::ofstream gzi(gzi_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+					reader->export_index(gzi);
+					gzi.close();
+					if (gzi.fail()) throw std::runtime_error("write failed");
+				}
+				catch (const std::exception& e) {
+					WARN("failed storing seek points index: ", gzi_path.generic_string(), " ", e.what());
+					std::filesystem::remove(gzi_path, ec);
+				}
+			}
 
-		// Compute line boundaries for each split, aligned to alignUnit (pair for interleaved)
-		std::vector<uint64_t> alignedStarts(num_splits + 1);
-		alignedStarts[0] = 0;
-		for (size_t i = 1; i < num_splits; ++i) {
-			uint64_t nominalLine = (totalLines * i) / num_splits;
-			alignedStarts[i] = (nominalLine / alignUnit) * alignUnit;
+			const uint64_t totalLines = static_cast<uint64_t>(newlineEnds.size());
+			INFO("build_chunk_offsets: file ", j, " totalLines=", totalLines);
+			ridx.set_checkpoints(newlineEnds, alignRecords);
 		}
-		alignedStarts[num_splits] = totalLines;
 
-		for (size_t i = 0; i < num_splits; ++i) {
+		// Chunk boundaries in records, aligned to the index checkpoints (pairs for interleaved)
+		for (size_t i = 0; i < num_chunks; ++i) {
 			size_t slotIdx = i * num_sense + j;
-			uint64_t startLine = alignedStarts[i];
-			uint64_t endLine   = alignedStarts[i + 1];
-
-			uint64_t startByte = (startLine == 0 || newlineEnds.empty()) ? 0 : newlineEnds[startLine - 1];
-			uint64_t endByte   = (endLine   == 0 || newlineEnds.empty()) ? 0 : newlineEnds[endLine   - 1];
+			uint64_t startRec = ridx.chunk_start(i, num_chunks);
+			uint64_t endRec   = ridx.chunk_start(i + 1, num_chunks);
+			if (is_sequential) {
+				startRec = i == 0 ? 0 : ridx.chunk_start(num_chunks, num_chunks);
+				endRec = ridx.chunk_start(num_chunks, num_chunks);
+			}
 
-			gz_slots[slotIdx].bytes_start = startByte;
-			gz_slots[slotIdx].bytes_end   = endByte;
-			gz_slot_files[slotIdx].numreads = static_cast<unsigned>((endLine - startLine) / linesPerRecord);
+			gz_slots[slotIdx].bytes_start = ridx.offset(startRec);
+			gz_slots[slotIdx].bytes_end   = ridx.offset(endRec);
+			gz_slot_files[slotIdx].numreads = static_cast<unsigned>(endRec - startRec);
 
 			INFO("build_chunk_offsets: slot ", slotIdx,
-				" bytes=[", startByte, ",", endByte, ")",
+				" bytes=[", gz_slots[slotIdx].bytes_start, ",", gz_slots[slotIdx].bytes_end, ")",
 				" reads=", gz_slot_files[slotIdx].numreads);
 		}
 	}
@@ -1191,20 +2421,20 @@ void Readfeed::build_chunk_offsets()
 // build_flat_chunk_offsets  (INDEXED_FLAT)
 //
 // For each original flat file, do a single-pass byte scan to collect the byte
-// offset after every newline.  Then divide those line offsets into num_splits
+// offset after every newline.  Then divide those line offsets into num_chunks
 // record-aligned chunks and store the byte boundaries in flat_slots[].
 // ---------------------------------------------------------------------------
 void Readfeed::build_flat_chunk_offsets()
 {
 	auto start = std::chrono::high_resolution_clock::now();
 	INFO("build_flat_chunk_offsets: computing byte-range chunks for ", num_orig_files, 
-            " file(s) x ", num_splits, " split(s)", " num_split_files | number of slots = ", num_split_files);
+            " file(s) x ", num_chunks, " chunk(s)", " num_split_files | number of slots = ", num_split_files);
 
 	const int linesPerRecord = orig_files[0].isFastq ? 4 : 2;
 	// For a single interleaved paired file, chunk boundaries must align to complete pairs
 	// (FWD + REV), so FWD and REV slot readers stay in sync when they share a reader.
-	const bool is_interleaved = (num_orig_files < num_sense);
-	const int alignUnit = is_interleaved ? linesPerRecord * static_cast<int>(num_sense) : linesPerRecord;
+	// The index checkpoints are always on pairs, so that the same index serves single and paired runs.
+	const uint64_t alignRecords = 2;
 
 	flat_slots.resize(num_split_files);
 	flat_slot_files.resize(num_split_files);
@@ -1213,7 +2443,7 @@ void Readfeed::build_flat_chunk_offsets()
 		auto& origFile = orig_files[j];
 
 		// Pre-populate slot metadata for this file's sense (FWD slot only for interleaved)
-		for (size_t i = 0; i < num_splits; ++i) {
+		for (size_t i = 0; i < num_chunks; ++i) {
 			size_t slotIdx = i * num_sense + j;
 			flat_slot_files[slotIdx].path    = origFile.path;
 			flat_slot_files[slotIdx].isZip   = false;
@@ -1222,57 +2452,66 @@ void Readfeed::build_flat_chunk_offsets()
 			flat_slots[slotIdx].file_path    = origFile.path.generic_string();
 		}
 
-		// Pass 1: scan file, collect newline offsets
-		INFO("build_flat_chunk_offsets: scanning ", origFile.path.generic_string());
-		std::vector<uint64_t> newlineEnds;
-		newlineEnds.reserve(static_cast<size_t>(origFile.numreads) * linesPerRecord + 1);
-
-		{
-			std::ifstream ifs(origFile.path, std::ios_base::in | std::ios_base::binary);
-			if (!ifs.is_open()) {
-				ERR("failed to open: ", origFile.path.generic_string());
-				exit(1);
-			}
-			constexpr size_t CHUNK = 1U << 20; // 1 MiB
-			std::vector<char> buf(CHUNK);
-			uint64_t pos = 0;
-			for (;;) {
-				ifs.read(buf.data(), static_cast<std::streamsize>(CHUNK));
-				auto n = ifs.gcount();
-				if (n <= 0) break;
-				for (size_t k = 0; k < static_cast<size_t>(n); ++k) {
-					if (buf[k] == '\n') newlineEnds.push_back(pos + k + 1);
-				}
-				pos += static_cast<uint64_t>(n);
+		// no pass 1 with the estimated read statistics - chunks of about the same size
+		if (is_estimated) {
+			const auto boundaries = split_by_bytes(origFile, num_chunks);
+			for (size_t i = 0; i < num_chunks; ++i) {
+				flat_slots[i].bytes_start = boundaries[i];
+				flat_slots[i].bytes_end   = boundaries[i + 1];
+				flat_slot_files[i].numreads = 0; // not known
 			}
+			INFO("build_flat_chunk_offsets: ", num_chunks, " chunks by size");
+			continue;
+		}
+
+		// Pass 1 is not needed if the reads index of a previous run matches the file
+		auto& ridx = read_index[j];
+		if (ridx.is_loaded) {
+			INFO("build_flat_chunk_offsets: file ", j, " using reads index: ", ridx.path.generic_string());
 		}
+		else {
+			// Pass 1: scan file, collect newline offsets
+			INFO("build_flat_chunk_offsets: scanning ", origFile.path.generic_string());
+			std::vector<uint64_t> newlineEnds;
+			newlineEnds.reserve(static_cast<size_t>(origFile.numreads) * linesPerRecord + 1);
 
-		const uint64_t totalLines = static_cast<uint64_t>(newlineEnds.size());
-		INFO("build_flat_chunk_offsets: file ", j, " totalLines=", totalLines);
+			{
+				std::ifstream ifs(origFile.path, std::ios_base::in | std::ios_base::binary);
+				if (!ifs.is_open()) {
+					ERR("failed to open: ", origFile.path.generic_string());
+					exit(1);
+				}
+				constexpr size_t CHUNK = 1U << 20; // 1 MiB
+				std::vector<char> buf(CHUNK);
+				uint64_t pos = 0;
+				for (;;) {
+					ifs.read(buf.data(), static_cast<std::streamsize>(CHUNK));
+					auto n = ifs.gcount();
+					if (n <= 0) break;
+					for (size_t k = 0; k < static_cast<size_t>(n); ++k) {
+						if (buf[k] == '\n') newlineEnds.push_back(pos + k + 1);
+					}
+					pos += static_cast<uint64_t>(n);
+				}
+			}
 
-		// Compute line boundaries for each split, aligned to alignUnit (pair for interleaved)
-		std::vector<uint64_t> alignedStarts(num_splits + 1);
-		alignedStarts[0] = 0;
-		for (size_t i = 1; i < num_splits; ++i) {
-			uint64_t nominalLine = (totalLines * i) / num_splits;
-			alignedStarts[i] = (nominalLine / alignUnit) * alignUnit;
+			const uint64_t totalLines = static_cast<uint64_t>(newlineEnds.size());
+			INFO("build_flat_chunk_offsets: file ", j, " totalLines=", totalLines);
+			ridx.set_checkpoints(newlineEnds, alignRecords);
 		}
-		alignedStarts[num_splits] = totalLines;
 
-		for (size_t i = 0; i < num_splits; ++i) {
+		// Chunk boundaries in records, aligned to the index checkpoints (pairs for interleaved)
+		for (size_t i = 0; i < num_chunks; ++i) {
 			size_t slotIdx = i * num_sense + j;
-			uint64_t startLine = alignedStarts[i];
-			uint64_t endLine   = alignedStarts[i + 1];
-
-			uint64_t startByte = (startLine == 0 || newlineEnds.empty()) ? 0 : newlineEnds[startLine - 1];
-			uint64_t endByte   = (endLine   == 0 || newlineEnds.empty()) ? 0 : newlineEnds[endLine   - 1];
+			uint64_t startRec = ridx.chunk_start(i, num_chunks);
+			uint64_t endRec   = ridx.chunk_start(i + 1, num_chunks);
 
-			flat_slots[slotIdx].bytes_start = startByte;
-			flat_slots[slotIdx].bytes_end   = endByte;
-			flat_slot_files[slotIdx].numreads = static_cast<unsigned>((endLine - startLine) / linesPerRecord);
+			flat_slots[slotIdx].bytes_start = ridx.offset(startRec);
+			flat_slots[slotIdx].bytes_end   = ridx.offset(endRec);
+			flat_slot_files[slotIdx].numreads = static_cast<unsigned>(endRec - startRec);
 
 			INFO("build_flat_chunk_offsets: slot ", slotIdx,
-				" bytes=[", startByte, ",", endByte, ")",
+				" bytes=[", flat_slots[slotIdx].bytes_start, ",", flat_slots[slotIdx].bytes_end, ")",
 				" reads=", flat_slot_files[slotIdx].numreads);
 		}
 	}
@@ -1422,11 +2661,31 @@ bool Readfeed::define_format(const int& dbg)
 				break;
 			}
 		}
-		orig_files[i].isZip = !is_ascii;
-		if (!is_ascii) {
+		orig_files[i].codec = detect_compression(str, static_cast<size_t>(blen));
+		if (orig_files[i].codec == COMPRESSION::NONE && !is_ascii)
+			orig_files[i].codec = COMPRESSION::GZIP; // left to zlib
+		orig_files[i].isZip = orig_files[i].codec != COMPRESSION::NONE;
+
+		if (orig_files[i].codec == COMPRESSION::BZIP2 || orig_files[i].codec == COMPRESSION::ZSTD) {
+			// not for zlib - test the first char of the decompressed file
+			char first = 0;
+			if (make_reader(orig_files[i], 1)->read(&first, 1) == 1) {
+				orig_files[i].isFastq = first == FASTQ_HEADER_START;
+				orig_files[i].isFasta = first == FASTA_HEADER_START;
+			}
+			if (!orig_files[i].isFastq && !orig_files[i].isFasta) {
+				ERR("Cannot define format for file: ", orig_files[i].path);
+				exit(1);
+			}
+			INFO("file: ", orig_files[i].path, " is ", (orig_files[i].isFasta ? "FASTA " : "FASTQ "), codec_name(orig_files[i].codec));
+			ifsv[i].seekg(0);
+			continue;
+		}
+
+		if (orig_files[i].isZip) {
 			// init izlib for inflation
 			if (vzlib_in.size() < (size_t)i+1) {
-				vzlib_in.emplace_back(Izlib());
+				vzlib_in.resize((size_t)i+1); // a bzip2/zstd file before has none
 			}
 			vzlib_in[i].init(false);
 		}
@@ -1434,7 +2693,7 @@ bool Readfeed::define_format(const int& dbg)
 		ifsv[i].seekg(0); // rewind stream to the start
 		// get a read to test ability to read
 		if (next(i, str, true, orig_files)) {
-			std::string fmt = orig_files[i].isZip ? "gzipped" : "flat ASCII";
+			std::string fmt = codec_name(orig_files[i].codec);
 			if (orig_files[i].isFasta) {
 				//biof = BIO_FORMAT::FASTA;
 				INFO("file: ", orig_files[i].path, " is FASTA ", fmt);
@@ -1470,6 +2729,457 @@ bool Readfeed::define_format(const int& dbg)
 	return is_format_defined;
 } // ~Readfeed::define_format
 
+/*
+ * record-aligned byte ranges of a flat reads file of about the same size, without reading the whole file.
+ * boundaries[i] = byte offset where part i starts (inclusive), boundaries[i+1] = where it ends (exclusive)
+ */
+std::vector<uint64_t> Readfeed::split_by_bytes(const Readfile& file, size_t num_parts)
+{
+	const int linesPerRecord = file.isFastq ? 4 : 2;
+	const uint64_t fileSize = static_cast<uint64_t>(file.size);
+	std::vector<uint64_t> boundaries(num_parts + 1);
+	boundaries[0] = 0;
+	boundaries[num_parts] = fileSize;
+
+	if (num_parts > 1) {
+		// Sequential boundary-finding pass: seek near each split point and advance
+		// to the start of the next complete record.
+		std::ifstream bifs(file.path, std::ios_base::in | std::ios_base::binary);
+		if (!bifs.is_open()) {
+			ERR("split_by_bytes: cannot open ", file.path.generic_string());
+			exit(1);
+		}
+
+		for (size_t i = 1; i < num_parts; ++i) {
+			bifs.seekg(static_cast<std::streamoff>(fileSize * i / num_parts));
+			std::string ln;
+			std::getline(bifs, ln); // skip to end of current (partial) line
+
+			if (file.isFastq) {
+				// Read 4-line groups until we find one where line[0] starts with '@'
+				// and line[2] starts with '+' (valid FASTQ record start).
+				bool found = false;
+				for (int attempt = 0; attempt < linesPerRecord && !found; ++attempt) {
+					const uint64_t candidatePos = static_cast<uint64_t>(bifs.tellg());
+					std::string l0, l1, l2, l3;
+					if (!std::getline(bifs, l0)) { boundaries[i] = fileSize; break; }
+					if (!std::getline(bifs, l1)) { boundaries[i] = fileSize; break; }
+					if (!std::getline(bifs, l2)) { boundaries[i] = fileSize; break; }
+					if (!std::getline(bifs, l3)) { boundaries[i] = fileSize; break; }
+					if (!l0.empty() && l0[0] == '@' && !l2.empty() && l2[0] == '+') {
+						boundaries[i] = candidatePos;
+						found = true;
+					} else {
+						// Advance by one line and retry
+						bifs.seekg(static_cast<std::streamoff>(candidatePos + l0.size() + 1));
+					}
+				}
+				if (!found) boundaries[i] = fileSize; // fold empty range into previous split
+			} else {
+				// FASTA: scan for the next '>' at the start of a line
+				bool found = false;
+				std::string fln;
+				while (!found) {
+					const uint64_t pos = static_cast<uint64_t>(bifs.tellg());
+					if (!std::getline(bifs, fln)) { boundaries[i] = fileSize; break; }
+					if (!fln.empty() && fln[0] == '>') { boundaries[i] = pos; found = true; }
+				}
+			}
+		}
+	}
+	return boundaries;
+} // ~Readfeed::split_by_bytes
+
+void Readfeed::estimate_reads()
+{
+	auto& file = orig_files[0];
+	const int linesPerRecord = file.isFastq ? 4 : 2;
+	const uint64_t fileSize = static_cast<uint64_t>(file.size);
+
+	std::ifstream ifs(file.path, std::ios_base::in | std::ios_base::binary);
+	if (!ifs.is_open()) {
+		ERR("estimate_reads: cannot open ", file.path.generic_string());
+		exit(1);
+	}
+	std::vector<char> buf(static_cast<size_t>(std::min(fileSize, SAMPLE_SIZE)));
+	ifs.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+	const auto n = static_cast<size_t>(ifs.gcount());
+
+	uint64_t numreads = 0;
+	uint64_t length = 0;
+	uint64_t bytes = 0; // end of the last complete record in the sample
+	uint64_t seqlen = 0;
+	int lineInRecord = 0;
+	for (size_t k = 0; k < n; ++k) {
+		if (buf[k] == '\n') {
+			if (lineInRecord == 1) { // end of sequence line
+				++numreads;
+				length += seqlen;
+				if (seqlen > max_read_len) max_read_len = static_cast<uint32_t>(seqlen);
+				if (min_read_len == 0 || static_cast<uint32_t>(seqlen) < min_read_len)
+					min_read_len = static_cast<uint32_t>(seqlen);
+				seqlen = 0;
+			}
+			lineInRecord = (lineInRecord + 1) % linesPerRecord;
+			if (lineInRecord == 0) bytes = k + 1;
+		} else if (lineInRecord == 1) {
+			++seqlen;
+		}
+	}
+
+	if (n >= fileSize || bytes == 0) {
+		// the whole file was sampled (or no complete record in the sample) - nothing to extrapolate
+		num_reads_tot = numreads;
+		length_all = length;
+		read_index[0].num_reads = numreads;
+		read_index[0].length_all = length;
+		read_index[0].min_len = min_read_len;
+		read_index[0].max_len = max_read_len;
+	}
+	else {
+		num_reads_tot = static_cast<uint64_t>(static_cast<double>(numreads) * fileSize / bytes);
+		length_all = static_cast<uint64_t>(static_cast<double>(length) * fileSize / bytes);
+		is_estimated = true;
+	}
+	file.numreads = static_cast<unsigned>(num_reads_tot);
+	INFO("estimate_reads: sampled ", n, " bytes, ", numreads, " reads. ", (is_estimated ? "Estimated" : "Counted"),
+		" total reads: ", num_reads_tot, " total length: ", length_all);
+} // ~Readfeed::estimate_reads
+
+void Readfeed::init_stream()
+{
+	auto& file = orig_files[0];
+	if (num_orig_files > 1 || type != FEED_TYPE::INDEXED) {
+		ERR("Streaming reads (stdin or a named pipe) is only supported for a single reads file with the indexed feed. ",
+			"Paired reads have to be interleaved in the stream");
+		exit(EXIT_FAILURE);
+	}
+
+	auto path = file.path;
+#if !defined(_WIN32)
+	if (path == "-") path = "/dev/stdin"; // plain ifstream - std::cin is synchronized with stdio
+#endif
+	if (path == "-") {
+		stream_in = &std::cin;
+	}
+	else {
+		stream_ifs.open(path, std::ios_base::in | std::ios_base::binary);
+		if (!stream_ifs.is_open()) {
+			ERR("failed to open reads stream: ", path.generic_string());
+			exit(EXIT_FAILURE);
+		}
+		stream_in = &stream_ifs;
+	}
+
+	// sample the stream. The sample is parsed first by 'stream_getline'
+	stream_sample.resize(SAMPLE_SIZE);
+	stream_in->read(&stream_sample[0], static_cast<std::streamsize>(stream_sample.size()));
+	stream_sample.resize(static_cast<size_t>(stream_in->gcount()));
+	stream_sample_pos = 0;
+	const bool is_eof = stream_in->eof();
+
+	if (stream_sample.empty()) {
+		ERR("no reads in the stream: ", file.path.generic_string());
+		exit(EXIT_FAILURE);
+	}
+	if (static_cast<uint8_t>(stream_sample[0]) == 0x1F) {
+		ERR("compressed reads stream is not supported. Decompress it on the fly e.g. 'zcat reads.fq.gz | sortmerna --reads - ...'");
+		exit(EXIT_FAILURE);
+	}
+	file.isZip = false;
+	file.isFastq = stream_sample[0] == FASTQ_HEADER_START;
+	file.isFasta = stream_sample[0] == FASTA_HEADER_START;
+	if (!file.isFastq && !file.isFasta) {
+		ERR("reads stream is neither FASTA nor FASTQ. First char: ", stream_sample[0]);
+		exit(EXIT_FAILURE);
+	}
+	is_format_defined = true;
+
+	// statistics of the sample. Counted exactly by the first pass, see 'reconcile_counts'
+	uint64_t numreads = 0;
+	uint64_t seqlen = 0;
+	auto add_read = [this, &numreads](uint64_t len) {
+		++numreads;
+		length_all += len;
+		if (len > max_read_len) max_read_len = static_cast<uint32_t>(len);
+		if (min_read_len == 0 || static_cast<uint32_t>(len) < min_read_len)
+			min_read_len = static_cast<uint32_t>(len);
+	};
+	bool is_rec = false;
+	uint64_t line_num = 0;
+	for (size_t pos = 0, end = 0; (end = stream_sample.find('\n', pos)) != std::string::npos; pos = end + 1) {
+		auto len = end - pos;
+		if (len > 0 && stream_sample[end - 1] == '\r') --len;
+		if (file.isFastq) {
+			if (line_num++ % 4 == 1) add_read(len);
+		}
+		else if (len > 0 && stream_sample[pos] == FASTA_HEADER_START) {
+			if (is_rec) add_read(seqlen);
+			is_rec = true;
+			seqlen = 0;
+		}
+		else {
+			seqlen += len;
+		}
+	}
+	if (is_rec && is_eof) add_read(seqlen);
+	num_reads_tot = numreads;
+	file.numreads = static_cast<unsigned>(numreads);
+	is_estimated = true;
+
+	if (is_eof) {
+		INFO("Reads stream: ", numreads, " reads in ", stream_sample.size(), " bytes");
+	}
+	else {
+		WARN("Reads stream: the size is unknown. The first index part uses the statistics of the first ",
+			numreads, " reads for the E-value, the following index parts and the reports the exact ones");
+	}
+
+	// a single chunk per processor, all taking the reads from the same queue
+	chunks_per_split = 1;
+	num_chunks = num_splits;
+	num_split_files = num_sense * num_chunks;
+	stream_pending.resize(num_chunks);
+	done_bits.resize(1);
+	num_skipped_done.resize(1);
+	slot_counts.resize(1);
+	stream_spool.path = basedir / "readcache_stream.bin";
+	is_ready = true;
+} // ~Readfeed::init_stream
+
+bool Readfeed::stream_getline(std::string& line)
+{
+	line.clear();
+	if (stream_sample_pos < stream_sample.size()) {
+		auto end = stream_sample.find('\n', stream_sample_pos);
+		if (end != std::string::npos) {
+			line.assign(stream_sample, stream_sample_pos, end - stream_sample_pos);
+			stream_sample_pos = end + 1;
+		}
+		else {
+			// the line continues past the sample
+			line.assign(stream_sample, stream_sample_pos, std::string::npos);
+			stream_sample_pos = stream_sample.size();
+			std::string rest;
+			if (std::getline(*stream_in, rest)) line.append(rest);
+		}
+		if (stream_sample_pos == stream_sample.size()) {
+			stream_sample.clear();
+			stream_sample.shrink_to_fit();
+			stream_sample_pos = 0;
+		}
+	}
+	else if (!std::getline(*stream_in, line)) {
+		return false;
+	}
+
+	// trim trailing whitespace e.g. '\r'
+	while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+		line.pop_back();
+	return true;
+} // ~Readfeed::stream_getline
+
+bool Readfeed::read_stream(std::string& readstr)
+{
+	std::string line;
+	std::string header;
+	header.swap(stream_header);
+	while (header.empty() && stream_getline(line))
+		header.swap(line);
+	if (header.empty())
+		return false;
+
+	const auto& file = orig_files[0];
+	if (header[0] != (file.isFastq ? FASTQ_HEADER_START : FASTA_HEADER_START)) {
+		ERR("unexpected record start in the reads stream: ", header);
+		exit(EXIT_FAILURE);
+	}
+	readstr.append(header).append(1, '\n');
+
+	if (file.isFastq) {
+		std::string sequence;
+		std::string quality;
+		if (!stream_getline(sequence) || !stream_getline(line) || !stream_getline(quality)) {
+			ERR("truncated record at the end of the reads stream: ", header);
+			exit(EXIT_FAILURE);
+		}
+		readstr.append(sequence).append(1, '\n').append(quality);
+	}
+	else {
+		// multi-line sequence up to the next header
+		while (stream_getline(line)) {
+			if (line.empty()) continue;
+			if (line[0] == FASTA_HEADER_START) {
+				stream_header.swap(line);
+				break;
+			}
+			readstr.append(line);
+		}
+	}
+	return true;
+} // ~Readfeed::read_stream
+
+void Readfeed::stream_run()
+{
+	if (is_spool)
+		stream_spool.open_write(FileId(), 0, 0);
+
+	uint64_t rec = 0; // record number in the stream i.e. read number of the read ID
+	StreamRec item;
+	ReadView view;
+	for (bool is_next = true; is_next;)
+	{
+		item.fwd.clear();
+		item.rev.clear();
+		for (uint32_t sense = 0; sense < num_sense; ++sense)
+		{
+			// interleaved paired: FWD/REV by the record number, as in 'get_id_idx'
+			auto& readstr = sense == 0 ? item.fwd : item.rev;
+			readstr.append(std::to_string(rec % num_sense)).append(1, '_').append(std::to_string(rec)).append(1, '\n');
+			is_next = read_stream(readstr);
+			if (!is_next) {
+				readstr.clear();
+				break;
+			}
+			count_slot(0, true, readstr);
+			if (stream_spool.mode == ReadCache::MODE::WRITE && view.parse(readstr))
+				stream_spool.put(view.header, view.sequence, view.quality);
+			++rec;
+		}
+		if (item.fwd.empty())
+			break;
+
+		{
+			std::unique_lock<std::mutex> lock(stream_lock);
+			stream_cv_put.wait(lock, [this] { return stream_queue.size() < STREAM_QUEUE_MAX || is_stream_abort; });
+			if (is_stream_abort)
+				return;
+			stream_queue.push_back(std::move(item));
+		}
+		stream_cv_get.notify_one();
+	}
+
+	count_slot(0, false, item.fwd);
+	stream_spool.finish();
+	is_stream_read = true;
+	INFO("End of reads stream reached. Total reads: ", rec);
+	{
+		std::lock_guard<std::mutex> lock(stream_lock);
+		is_stream_end = true;
+	}
+	stream_cv_get.notify_all();
+} // ~Readfeed::stream_run
+
+void Readfeed::stream_join()
+{
+	if (stream_thread.joinable())
+		stream_thread.join();
+	stream_queue.clear();
+	for (auto& pending : stream_pending) pending.clear();
+	is_stream_started = false;
+	is_stream_end = false;
+	is_stream_replay = is_stream_read;
+} // ~Readfeed::stream_join
+
+void Readfeed::init_stream_replay()
+{
+	if (stream_spool.mode != ReadCache::MODE::READ && !stream_spool.open_read(FileId(), 0, 0)) {
+		ERR("the reads stream was consumed by the previous pass and not spooled: ", stream_spool.path.generic_string());
+		exit(EXIT_FAILURE);
+	}
+
+	// once: the record offsets at the chunk boundaries. A chunk starts with a FWD record
+	if (stream_ranges.empty()) {
+		const uint64_t num_recs = stream_spool.num_reads;
+		const uint64_t num_pairs = (num_recs + num_sense - 1) / num_sense;
+		const uint64_t recs_per_chunk = (num_pairs + num_chunks - 1) / num_chunks * num_sense;
+		stream_ranges.resize(num_chunks);
+		size_t pos = ReadCache::HEADER_SIZE;
+		uint64_t rec = 0;
+		for (auto& range : stream_ranges) {
+			range.start = pos;
+			range.rec_start = rec;
+			for (uint64_t i = 0; i < recs_per_chunk && stream_spool.skip(pos); ++i)
+				++rec;
+			range.end = pos;
+		}
+	}
+	for (auto& range : stream_ranges) {
+		range.pos = range.start;
+		range.rec = range.rec_start;
+	}
+} // ~Readfeed::init_stream_replay
+
+bool Readfeed::next_stream(int inext, std::string& readstr)
+{
+	// the mate of the last pair popped for this chunk comes first, whichever sense is asked for
+	const auto chunk = inext / static_cast<int>(num_sense);
+	auto& pending = stream_pending[chunk];
+	if (!pending.empty()) {
+		readstr.swap(pending);
+		pending.clear();
+		return true;
+	}
+
+	StreamRec item;
+	if (is_stream_replay)
+	{
+		{
+			std::lock_guard<std::mutex> lock(stream_lock);
+			if (!is_stream_started) {
+				is_stream_started = true;
+				init_stream_replay();
+			}
+		}
+		// the range of this chunk is read only by the thread claiming the chunk
+		auto& range = stream_ranges[chunk];
+		for (uint32_t sense = 0; sense < num_sense; ++sense)
+		{
+			if (is_skip_done) {
+				std::lock_guard<std::mutex> lock(stream_lock);
+				const auto& bits = done_bits[0];
+				while (range.pos < range.end && (range.rec >> 6) < bits.size()
+					&& ((bits[range.rec >> 6] >> (range.rec & 63)) & 1) && stream_spool.skip(range.pos))
+				{
+					++range.rec;
+					++num_skipped_done[0];
+				}
+			}
+			auto& str = sense == 0 ? item.fwd : item.rev;
+			str.append(std::to_string(range.rec % num_sense)).append(1, '_').append(std::to_string(range.rec)).append(1, '\n');
+			if (range.pos >= range.end || !stream_spool.get(range.pos, str)) {
+				str.clear();
+				break;
+			}
+			++range.rec;
+		}
+		if (item.fwd.empty()) {
+			readstr.clear();
+			return false;
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(stream_lock);
+		if (!is_stream_started) {
+			is_stream_started = true;
+			stream_thread = std::thread(&Readfeed::stream_run, this);
+		}
+		stream_cv_get.wait(lock, [this] { return !stream_queue.empty() || is_stream_end; });
+		if (stream_queue.empty()) {
+			readstr.clear();
+			return false;
+		}
+		item = std::move(stream_queue.front());
+		stream_queue.pop_front();
+		lock.unlock();
+		stream_cv_put.notify_one();
+	}
+	readstr.swap(item.fwd);
+	pending.swap(item.rev);
+	return true;
+} // ~Readfeed::next_stream
+
 // ---------------------------------------------------------------------------
 // count_reads_parallel  (FEED_TYPE::INDEXED)
 //
@@ -1495,14 +3205,16 @@ void Readfeed::count_reads_parallel()
 
 	for (size_t j = 0; j < num_orig_files; ++j) {
 		auto& origFile = orig_files[j];
+		// per file statistics for the reads index. Merged into the totals at the end of the file
+		const auto length_prev = length_all;
+		const auto min_prev = min_read_len;
+		const auto max_prev = max_read_len;
+		min_read_len = 0;
+		max_read_len = 0;
 
 		if (origFile.isZip) {
-			// --- gz: ParallelGzipReader decompresses with num_splits threads internally ---
-			using PGR = rapidgzip::ParallelGzipReader<>;
-			auto reader = std::make_unique<PGR>(
-				std::make_unique<rapidgzip::StandardFileReader>(origFile.path.generic_string()),
-				static_cast<size_t>(num_splits)
-			);
+			// --- compressed: the decoder decompresses with num_splits threads internally ---
+			auto reader = make_reader(origFile, static_cast<size_t>(num_splits), is_io_uring);
 
 			constexpr size_t CHUNK = 1U << 20; // 1 MiB
 			std::vector<uint8_t> buf(CHUNK);
@@ -1531,61 +3243,10 @@ void Readfeed::count_reads_parallel()
 			}
 		} else {
 			// --- flat: parallel threads, each scanning a record-aligned byte range ---
-			const uint64_t fileSize = static_cast<uint64_t>(origFile.size);
-
 			// Build record-aligned split boundaries.
 			// boundaries[i]   = byte offset where thread i starts (inclusive)
 			// boundaries[i+1] = byte offset where thread i ends   (exclusive)
-			std::vector<uint64_t> boundaries(num_splits + 1);
-			boundaries[0] = 0;
-			boundaries[num_splits] = fileSize;
-
-			if (num_splits > 1) {
-				// Sequential boundary-finding pass: seek near each split point and advance
-				// to the start of the next complete record.
-				std::ifstream bifs(origFile.path, std::ios_base::in | std::ios_base::binary);
-				if (!bifs.is_open()) {
-					ERR("count_reads_parallel: cannot open ", origFile.path.generic_string());
-					exit(1);
-				}
-
-				for (size_t i = 1; i < num_splits; ++i) {
-					bifs.seekg(static_cast<std::streamoff>(fileSize * i / num_splits));
-					std::string ln;
-					std::getline(bifs, ln); // skip to end of current (partial) line
-
-					if (origFile.isFastq) {
-						// Read 4-line groups until we find one where line[0] starts with '@'
-						// and line[2] starts with '+' (valid FASTQ record start).
-						bool found = false;
-						for (int attempt = 0; attempt < linesPerRecord && !found; ++attempt) {
-							const uint64_t candidatePos = static_cast<uint64_t>(bifs.tellg());
-							std::string l0, l1, l2, l3;
-							if (!std::getline(bifs, l0)) { boundaries[i] = fileSize; break; }
-							if (!std::getline(bifs, l1)) { boundaries[i] = fileSize; break; }
-							if (!std::getline(bifs, l2)) { boundaries[i] = fileSize; break; }
-							if (!std::getline(bifs, l3)) { boundaries[i] = fileSize; break; }
-							if (!l0.empty() && l0[0] == '@' && !l2.empty() && l2[0] == '+') {
-								boundaries[i] = candidatePos;
-								found = true;
-							} else {
-								// Advance by one line and retry
-								bifs.seekg(static_cast<std::streamoff>(candidatePos + l0.size() + 1));
-							}
-						}
-						if (!found) boundaries[i] = fileSize; // fold empty range into previous split
-					} else {
-						// FASTA: scan for the next '>' at the start of a line
-						bool found = false;
-						std::string fln;
-						while (!found) {
-							const uint64_t pos = static_cast<uint64_t>(bifs.tellg());
-							if (!std::getline(bifs, fln)) { boundaries[i] = fileSize; break; }
-							if (!fln.empty() && fln[0] == '>') { boundaries[i] = pos; found = true; }
-						}
-					}
-				}
-			}
+			const auto boundaries = split_by_bytes(origFile, num_splits);
 
 			// Thread-local accumulator
 			struct ThreadResult {
@@ -1654,6 +3315,15 @@ void Readfeed::count_reads_parallel()
 			}
 		}
 
+		if (j < read_index.size()) {
+			read_index[j].num_reads = origFile.numreads;
+			read_index[j].length_all = length_all - length_prev;
+			read_index[j].min_len = min_read_len;
+			read_index[j].max_len = max_read_len;
+		}
+		if (min_prev > 0 && (min_read_len == 0 || min_prev < min_read_len)) min_read_len = min_prev;
+		if (max_prev > max_read_len) max_read_len = max_prev;
+
 		num_reads_tot += origFile.numreads;
 	}
 
@@ -1662,6 +3332,42 @@ void Readfeed::count_reads_parallel()
 	     " sec. Total reads: ", num_reads_tot);
 } // ~Readfeed::count_reads_parallel
 
+bool Readfeed::load_read_index()
+{
+	const uint32_t linesPerRecord = orig_files[0].isFastq ? 4 : 2;
+	read_index.resize(num_orig_files);
+	bool is_loaded = true;
+	for (size_t j = 0; j < num_orig_files; ++j) {
+		read_index[j].init(basedir, orig_files[j].path, linesPerRecord);
+		is_loaded = read_index[j].load() && is_loaded;
+	}
+	if (!is_loaded) {
+		for (auto& ridx : read_index) ridx.is_loaded = false; // paired files are scanned together
+		return false;
+	}
+
+	for (size_t j = 0; j < num_orig_files; ++j) {
+		auto& ridx = read_index[j];
+		orig_files[j].numreads = static_cast<unsigned>(ridx.num_reads);
+		num_reads_tot += ridx.num_reads;
+		length_all += ridx.length_all;
+		if (ridx.max_len > max_read_len) max_read_len = ridx.max_len;
+		if (min_read_len == 0 || (ridx.min_len > 0 && ridx.min_len < min_read_len))
+			min_read_len = ridx.min_len;
+	}
+	INFO("Using reads index. Skipped the pre-scan. Total reads: ", num_reads_tot);
+	return true;
+} // ~Readfeed::load_read_index
+
+void Readfeed::store_read_index()
+{
+	if (is_estimated) return; // no index was built
+	for (auto& ridx : read_index) {
+		if (ridx.is_loaded) continue;
+		ridx.store();
+	}
+} // ~Readfeed::store_read_index
+
 /*
 */
 void Readfeed::count_reads()
@@ -1827,22 +3533,42 @@ void Readfeed::init_vzlib_in()
  */
 void Readfeed::init_reading()
 {
+	chunk_next.store(0, std::memory_order_relaxed);
+	if (is_stream) {
+		stream_join(); // the producer is started by the first 'next' of the pass
+		return;
+	}
 	if (type == FEED_TYPE::INDEXED && orig_files[0].isZip) {
 		vstate_in.resize(gz_slots.size());
 		for (auto& s : vstate_in) s.reset();
+		if (is_read_cache && read_caches.size() != gz_slots.size()) read_caches.resize(gz_slots.size());
+		done_bits.resize(gz_slots.size()); // kept across the passes
+		num_skipped_done.resize(gz_slots.size());
+		slot_counts.resize(gz_slots.size());
 
 		// For interleaved paired, REV slots (odd) share the FWD slot's reader — skip them.
 		const bool is_interleaved = (num_orig_files < num_sense);
 		for (std::size_t i = 0; i < gz_slots.size(); ++i) {
 			if (is_interleaved && i % num_sense != 0) continue;
 			auto& slot = gz_slots[i];
-			slot.reader = std::unique_ptr<GzReaderImpl, GzReaderDeleter>(
-				new GzReaderImpl(
-					std::make_unique<rapidgzip::StandardFileReader>(slot.file_path),
-					/*parallelization=*/std::size_t(1)
-				)
-			);
-			slot.reader->rdr.seek(static_cast<long long>(slot.bytes_start));
+			// replayed from the read cache - no need to decompress
+			if (is_read_cache && init_read_cache(i, slot.file_path, slot.bytes_start, slot.bytes_end)) continue;
+			if (slot.bytes_end == slot.bytes_start) { // empty chunk e.g. of a single frame zstd file
+				slot.bytes_remaining = 0;
+				continue;
+			}
+			slot.reader = make_reader(gz_slot_files[i], /*parallelization=*/std::size_t(1), is_io_uring);
+			// seek points of the reads index, otherwise the seek decompresses everything before the chunk
+			auto gzi_path = read_index[i % num_orig_files].gz_index_path();
+			if (slot.bytes_start > 0 && std::filesystem::exists(gzi_path)) {
+				try {
+					slot.reader->import_index(gzi_path);
+				}
+				catch (const std::exception& e) {
+					WARN("failed loading seek points index: ", gzi_path.generic_string(), " ", e.what());
+				}
+			}
+			slot.reader->seek(slot.bytes_start);
 			slot.bytes_remaining = slot.bytes_end - slot.bytes_start;
 			slot.buf_pos = 0;
 			slot.buf_len = 0;
@@ -1853,12 +3579,19 @@ void Readfeed::init_reading()
 	if (type == FEED_TYPE::INDEXED && orig_files[0].isZip == false) {
 		vstate_in.resize(flat_slots.size());
 		for (auto& s : vstate_in) s.reset();
+		if (is_read_cache && read_caches.size() != flat_slots.size()) read_caches.resize(flat_slots.size());
+		done_bits.resize(flat_slots.size()); // kept across the passes
+		num_skipped_done.resize(flat_slots.size());
+		slot_counts.resize(flat_slots.size());
 
 		// For interleaved paired, REV slots (odd) share the FWD slot's ifstream — skip them.
 		const bool is_interleaved = (num_orig_files < num_sense);
 		for (std::size_t i = 0; i < flat_slots.size(); ++i) {
 			if (is_interleaved && i % num_sense != 0) continue;
 			auto& slot = flat_slots[i];
+			// replayed from the read cache - no need to read the file
+			if (is_read_cache && init_read_cache(i, slot.file_path, slot.bytes_start, slot.bytes_end)) continue;
+			if (slot.map()) continue;
 			if (slot.ifs.is_open()) slot.ifs.close();
 			slot.ifs.open(slot.file_path, std::ios_base::in | std::ios_base::binary);
 			if (!slot.ifs.is_open()) {
@@ -75,9 +75,17 @@ Readstats::Readstats(uint64_t all_reads_count, uint64_t all_reads_len, uint32_t
 	n_yid_ycov(0),
 	num_denovo(0),
 	num_short(0),
+	num_dedup_lookup(0),
+	num_dedup_hit(0),
+	num_sw(0),
+	num_sw_pruned(0),
+	num_sw_pruned_best(0),
+	num_sw_xdrop(0),
 	reads_matched_per_db(opts.indexfiles.size(), 0),
 	is_stats_calc(false),
-	is_set_aligned_id_cov(false)
+	is_set_aligned_id_cov(false),
+	is_cigar(opts.is_cigar),
+	kvdb_format(KeyValueDatabase::FORMAT_VERSION)
 {
 	// calculate this->dbkey
 	std::string key_str_tmp("");
@@ -91,6 +99,13 @@ Readstats::Readstats(uint64_t all_reads_count, uint64_t all_reads_len, uint32_t
 	dbkey = string_hash(key_str_tmp);
 
 	bool is_restored = restoreFromDb(kvdb);
+	if (kvdb_format != KeyValueDatabase::FORMAT_VERSION)
+	{
+		ERR("The key-value database ", std::filesystem::absolute(opts.kvdbdir), " was created by another version of sortmerna",
+			" (format ", unsigned(kvdb_format), ", expected ", unsigned(KeyValueDatabase::FORMAT_VERSION), ").",
+			" The read results in it are keyed differently and cannot be found. Align again in an empty key-value database directory");
+		exit(EXIT_FAILURE);
+	}
 
 	calcSuffix(opts);
 
@@ -169,6 +184,16 @@ std::string Readstats::toBstring()
 	std::copy_n(static_cast<char*>(static_cast<void*>(&is_stats_calc)), sizeof(is_stats_calc), std::back_inserter(buf));
 	// 13
 	std::copy_n(static_cast<char*>(static_cast<void*>(&is_set_aligned_id_cov)), sizeof(is_set_aligned_id_cov), std::back_inserter(buf));
+	// 14
+	val = num_dedup_lookup.load(std::memory_order_relaxed);
+	std::copy_n(static_cast<char*>(static_cast<void*>(&val)), sizeof(val), std::back_inserter(buf));
+	// 15
+	val = num_dedup_hit.load(std::memory_order_relaxed);
+	std::copy_n(static_cast<char*>(static_cast<void*>(&val)), sizeof(val), std::back_inserter(buf));
+	// 16
+	std::copy_n(static_cast<char*>(static_cast<void*>(&is_cigar)), sizeof(is_cigar), std::back_inserter(buf));
+	// 17
+	buf.push_back(static_cast<char>(KeyValueDatabase::FORMAT_VERSION));
 	//
 	return buf;
 } // ~Readstats::toBstring
@@ -189,9 +214,13 @@ std::string Readstats::toString()
 		<< " total_aligned_id_cov= " << n_yid_ycov
 		<< " total_denovo= " << num_denovo
 		<< " num_short= " << num_short
+		<< " num_dedup_lookup= " << num_dedup_lookup
+		<< " num_dedup_hit= " << num_dedup_hit
 		<< " reads_matched_per_db= " << "TODO"
 		<< " is_stats_calc= " << is_stats_calc
 		<< " is_total_reads_mapped_cov= " << is_set_aligned_id_cov 
+		<< " is_cigar= " << is_cigar
+		<< " kvdb_format= " << unsigned(kvdb_format)
 		<< std::endl;
 	return ss.str();
 } // ~Readstats::toString
@@ -283,11 +312,50 @@ bool Readstats::restoreFromDb(KeyValueDatabase & kvdb)
 		// 13
 		std::memcpy(static_cast<void*>(&is_set_aligned_id_cov), bstr.data() + offset, sizeof(is_set_aligned_id_cov));
 		offset += sizeof(is_set_aligned_id_cov);
+
+		// 14, 15 - not present in the KVDB created by older versions
+		if (offset + 2 * sizeof(uint64_t) <= bstr.size())
+		{
+			val = 0;
+			std::memcpy(static_cast<void*>(&val), bstr.data() + offset, sizeof(val));
+			num_dedup_lookup = val;
+			offset += sizeof(val);
+			val = 0;
+			std::memcpy(static_cast<void*>(&val), bstr.data() + offset, sizeof(val));
+			num_dedup_hit = val;
+			offset += sizeof(val);
+		}
+
+		// 16 - not present in the KVDB created by older versions, which always stored CIGAR
+		is_cigar = true;
+		if (offset + sizeof(is_cigar) <= bstr.size())
+		{
+			std::memcpy(static_cast<void*>(&is_cigar), bstr.data() + offset, sizeof(is_cigar));
+			offset += sizeof(is_cigar);
+		}
+
+		// 17 - not present in the KVDB created by older versions, which keyed the reads by the read ID string
+		kvdb_format = 1;
+		if (offset + sizeof(kvdb_format) <= bstr.size())
+		{
+			std::memcpy(static_cast<void*>(&kvdb_format), bstr.data() + offset, sizeof(kvdb_format));
+			offset += sizeof(kvdb_format);
+		}
 	} // ~if data found in DB
 
 	return ret;
 } // ~Readstats::restoreFromDb
 
+void Readstats::check_cigar(const std::string& what, Runopts& opts)
+{
+	if (is_cigar)
+		return;
+	ERR("The alignments in the key-value database ", std::filesystem::absolute(opts.kvdbdir), " have no CIGAR,",
+		" which ", what, " needs. No report requiring CIGAR was requested when aligning, so Smith-Waterman was run score-only.",
+		" Run the alignment again together with the reports, or in a new key-value database");
+	exit(EXIT_FAILURE);
+} // ~Readstats::check_cigar
+
 void Readstats::store_to_db(KeyValueDatabase & kvdb)
 {
 	kvdb.put(dbkey, toBstring());
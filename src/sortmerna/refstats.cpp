@@ -180,6 +180,36 @@ void Refstats::load(Runopts& opts, Readstats& readstats)
 
 		index_parts_stats_vec.push_back(hold);
 
+		// skip the SAM @SQ headers to the index format version and flags. Version 1 has none
+		uint32_t num_sq = 0;
+		stats.read(reinterpret_cast<char*>(&num_sq), sizeof(uint32_t));
+		for (uint32_t j = 0; j < num_sq && stats.good(); ++j) {
+			uint32_t len_id = 0;
+			stats.read(reinterpret_cast<char*>(&len_id), sizeof(uint32_t));
+			stats.seekg(len_id + sizeof(uint32_t), std::ios::cur); // the sequence id and length
+		}
+		uint32_t version = 1;
+		uint32_t flags = 0;
+		if (!stats.read(reinterpret_cast<char*>(&version), sizeof(uint32_t)) 
+			|| !stats.read(reinterpret_cast<char*>(&flags), sizeof(uint32_t)))
+		{
+			version = 1;
+			flags = 0;
+		}
+
+		if (version > INDEX_VERSION) {
+			ERR("The index [", opts.indexfiles[index_num].second, "] has format version ", version, 
+				" and was built by a newer sortmerna. This one reads up to version ", INDEX_VERSION, 
+				". Re-build the index using '-", OPT_INDEX, " 1'");
+			exit(EXIT_FAILURE);
+		}
+		if (((flags & INDEX_FLAG_RC) != 0) != opts.is_index_rc) {
+			ERR("The index [", opts.indexfiles[index_num].second, "] was built ", 
+				(opts.is_index_rc ? "without" : "with"), " '-", OPT_INDEX_RC, "'. Align with the same '-", OPT_INDEX_RC,
+				"' setting, or re-build the index using '-", OPT_INDEX, " 1'");
+			exit(EXIT_FAILURE);
+		}
+
 		// Gumbel parameters
 		long **substitutionScoreMatrix = scoring_matrix;
 		long gapOpen1 = opts.gap_open;
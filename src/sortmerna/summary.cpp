@@ -52,7 +52,9 @@ Summary::Summary() :
 	total_otu(0),
 	min_read_len(0),
 	max_read_len(0),
-	all_reads_len(0)
+	all_reads_len(0),
+	num_dedup_lookup(0),
+	num_dedup_hit(0)
 {}
 
 void Summary::write(Refstats& refstats, Readstats& readstats, Runopts& opts)
@@ -78,6 +80,8 @@ void Summary::write(Refstats& refstats, Readstats& readstats, Runopts& opts)
 	min_read_len = readstats.min_read_len;
 	max_read_len = readstats.max_read_len;
 	all_reads_len = readstats.all_reads_len;
+	num_dedup_lookup = readstats.num_dedup_lookup.load(std::memory_order_relaxed);
+	num_dedup_hit = readstats.num_dedup_hit.load(std::memory_order_relaxed);
 
 	// stats by database
 	for (uint32_t i = 0; i < opts.indexfiles.size(); ++i) {
@@ -157,6 +161,13 @@ std::string Summary::to_string(Refstats& refstats, Runopts& opts)
 		   << "    Total OTUs = " << total_otu << std::endl;
 	}
 
+	if (num_dedup_lookup > 0)
+	{
+		auto dedup_hit_ratio = (float)num_dedup_hit / num_dedup_lookup;
+		ss << "    Duplicate reads reusing cached alignment = " << num_dedup_hit
+			<< " (" << (dedup_hit_ratio * 100) << ")" << std::endl;
+	}
+
 	ss	<< "    Minimum read length = " << min_read_len << std::endl
 		<< "    Maximum read length = " << max_read_len << std::endl
 		<< "    Mean read length    = " << all_reads_len / total_reads << std::endl << std::endl;
@@ -70,7 +70,7 @@ void Writer::write()
 		if (!opts.is_dbg_put_kvdb && readstr.size() > 0)
 		{
 			if (read.is_hit) ++num_aligned;
-			kvdb.put(read.id, readstr);
+			kvdb.put(read.db_key(), readstr);
 		}
 	}
 	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - t;
@@ -0,0 +1,485 @@
+/*
+ @copyright 2016-2021  Clarity Genomics BVBA
+ @copyright 2012-2016  Bonsai Bioinformatics Research Group
+ @copyright 2014-2016  Knight Lab, Department of Pediatrics, UCSD, La Jolla
+
+ @parblock
+ SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+ This is a free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ SortMeRNA is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+ @endparblock
+
+ @contributors Jenya Kopylova   jenya.kopylov@gmail.com
+			   Laurent No      laurent.noe@lifl.fr
+			   Pierre Pericard  pierre.pericard@lifl.fr
+			   Daniel McDonald  wasade@gmail.com
+			   Mikal Salson    mikael.salson@lifl.fr
+			   Hlne Touzet    helene.touzet@lifl.fr
+			   Rob Knight       robknight@ucsd.edu
+*/
+
+/* 
+ * FILE: align.cpp
+ * Created: Oct 19, 2026 Mon
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm> // std::find
+#if !defined(_WIN32)
+#include <unistd.h> // pipe, dup2
+#endif
+
+#include "options.hpp"
+#include "readstats.hpp"
+#include "kvdb.hpp"
+#include "index.hpp"
+#include "indexdb.hpp"
+#include "readfeed.hpp"
+#include "processor.hpp"
+#include "summary.hpp"
+#include "output.hpp"
+#include "otumap.h"
+#include "refstats.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+	int num_fail = 0;
+
+	void check(bool is_ok, const std::string& what)
+	{
+		if (!is_ok) {
+			std::cerr << "FAILED: " << what << std::endl;
+			++num_fail;
+		}
+	}
+
+	/* the counters of a run compared by the tests */
+	struct RunStats {
+		uint64_t num_sw_pruned = 0;
+		uint64_t num_sw_pruned_best = 0;
+		uint64_t num_aligned = 0;
+		uint64_t num_dedup_hit = 0;
+		uint64_t num_skipped_done = 0; // reads skipped by the feed as done on a previous index part
+		unsigned num_parts = 0; // index parts of all the references
+	};
+
+	/*
+	 * index, align, post-process and report as 'main' does with the default '-task 4'.
+	 * '--fused' runs 'align_fused' i.e. expects a single part index
+	 */
+	RunStats run(std::vector<std::string> args)
+	{
+		std::vector<char*> argv;
+		for (auto& arg : args) argv.push_back(&arg[0]);
+		Runopts opts(static_cast<int>(argv.size()), argv.data(), false);
+		Index index(opts);
+		KeyValueDatabase kvdb(opts.kvdbdir.string());
+		Readfeed readfeed(opts.feed_type, opts.readfiles, opts.num_proc_thread, opts.readb_dir, opts.is_paired, opts.num_chunks, opts.is_prescan);
+		readfeed.is_read_cache = opts.is_read_cache && opts.feed_type == FEED_TYPE::INDEXED;
+		kvdb.init_mem(std::size_t(readfeed.num_chunks) * readfeed.num_sense, 0);
+		Readstats readstats(readfeed.num_reads_tot, readfeed.length_all, readfeed.min_read_len, readfeed.max_read_len, kvdb, opts);
+		ThreadPool tpool(opts.num_proc_thread + 1);
+		RunStats stats;
+		for (auto num : Refstats(opts, readstats).num_index_parts) stats.num_parts += num;
+		if (opts.is_fused) {
+			align_fused(readfeed, readstats, index, kvdb, tpool, opts);
+			stats.num_aligned = readstats.num_aligned.load();
+			return stats;
+		}
+		align(readfeed, readstats, index, kvdb, tpool, opts);
+		stats.num_sw_pruned = readstats.num_sw_pruned.load();
+		stats.num_sw_pruned_best = readstats.num_sw_pruned_best.load();
+		stats.num_aligned = readstats.num_aligned.load();
+		stats.num_dedup_hit = readstats.num_dedup_hit.load();
+		stats.num_skipped_done = readfeed.get_num_skipped_done();
+		if (opts.is_otu_map || opts.is_denovo) denovo_stats(readfeed, readstats, kvdb, tpool, opts);
+		if (opts.is_otu_map) fill_otu_map(readfeed, readstats, kvdb, tpool, opts);
+		writeSummary(readstats, opts);
+		writeReports(readfeed, readstats, kvdb, tpool, opts);
+		return stats;
+	}
+
+	std::string read_file(const std::filesystem::path& path)
+	{
+		std::ifstream ifs(path, std::ios_base::in | std::ios_base::binary);
+		std::stringstream ss;
+		ss << ifs.rdbuf();
+		return ss.str();
+	}
+
+	/*
+	 * the summary without the lines that depend on the run: command, pid, reads file ('-' if a stream),
+	 * the '--dedup' cache hits and the date at the end
+	 */
+	std::string read_summary(const std::filesystem::path& path)
+	{
+		std::ifstream ifs(path);
+		std::vector<std::string> lines;
+		bool is_params = false;
+		for (std::string line; std::getline(ifs, line);) {
+			is_params = is_params || line.find("Parameters summary") != std::string::npos;
+			if (is_params && !line.empty() && line.find("Reads file:") == std::string::npos
+				&& line.find("Duplicate reads reusing") == std::string::npos)
+				lines.push_back(line);
+		}
+		if (!lines.empty()) lines.pop_back(); // date
+		std::string res;
+		for (auto const& line : lines) res.append(line).append(1, '\n');
+		return res;
+	}
+
+	/*
+	 * compare all the reports in 'out' of the two work directories. The summary without the run specific lines
+	 * @return number of the files compared
+	 */
+	int check_same_out(const std::filesystem::path& workdir_a, const std::filesystem::path& workdir_b, const std::string& what)
+	{
+		int num_files = 0;
+		for (auto const& entry : std::filesystem::directory_iterator(workdir_a / "out")) {
+			auto name = entry.path().filename();
+			auto path_b = workdir_b / "out" / name;
+			check(std::filesystem::exists(path_b), what + ": no " + path_b.string());
+			if (name == "aligned.log")
+				check(read_summary(entry.path()) == read_summary(path_b), what + ": " + name.string() + " differs");
+			else
+				check(read_file(entry.path()) == read_file(path_b), what + ": " + name.string() + " differs");
+			++num_files;
+		}
+		check(num_files > 0 && !read_file(workdir_a / "out" / "aligned.blast").empty(), what + ": no alignments");
+		return num_files;
+	}
+} // namespace
+
+/*
+ * The SW score bound pruning does not change the results: the reports are the same as with '--no_sw_prune'.
+ * The bound below the kept alignments ('--best'), which runs SW score-only, is covered, also over the next
+ * reference when the alignments of the reads are kept from the previous one, if two references are given
+ * @param argv  the run options e.g. -ref .. -reads .. -threads .., and the last one the scratch directory
+ */
+int align_sw_prune(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "align_sw_prune: expecting the run options and a scratch directory" << std::endl;
+		return 1;
+	}
+	num_fail = 0;
+	std::filesystem::path workdir = argv[argc - 1];
+	std::vector<std::string> args(argv, argv + argc - 1);
+	args.insert(args.end(), { "-fastx", "-other", "-blast", "1", "-workdir" });
+	std::filesystem::remove_all(workdir);
+
+	auto pruned_args = args;
+	pruned_args.push_back((workdir / "pruned").string());
+	auto pruned = run(pruned_args);
+	check(pruned.num_sw_pruned_best > 0, "no SW ran score-only below the kept alignments. The test data does not cover it");
+
+	auto full_args = args;
+	full_args.push_back((workdir / "full").string());
+	full_args.push_back("--no_sw_prune");
+	auto full = run(full_args);
+	check(full.num_sw_pruned == 0 && full.num_sw_pruned_best == 0, "SW pruned with '--no_sw_prune'");
+
+	check_same_out(workdir / "pruned", workdir / "full", "with and without the SW pruning");
+
+	std::cout << "align_sw_prune: pruned SW: " << pruned.num_sw_pruned << " score-only: "
+		<< pruned.num_sw_pruned_best << " failed: " << num_fail << std::endl;
+	return num_fail;
+} // ~align_sw_prune
+
+/*
+ * '--index_rc' index of both strands searched with the forward read only.
+ * With '-F' the reports are the same as on the forward-only index: the positions on the reverse complement
+ * are not taken. On both strands the seeds of the reverse strand are placed from the other end of the read,
+ * so only the number of the aligned reads is expected close to the forward-only index, on both strands
+ * @param argv  the run options e.g. -ref .. -reads .. -threads .., and the last one the scratch directory
+ */
+int align_index_rc(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "align_index_rc: expecting the run options and a scratch directory" << std::endl;
+		return 1;
+	}
+	num_fail = 0;
+	std::filesystem::path workdir = argv[argc - 1];
+	std::vector<std::string> args(argv, argv + argc - 1);
+	// both indexes in the same directory: the '--index_rc' one is kept apart
+	args.insert(args.end(), { "-blast", "1 qstrand", "-idx-dir", (workdir / "idx").string(), "-workdir" });
+	std::filesystem::remove_all(workdir);
+
+	auto run_in = [&args, &workdir](const std::string& name, std::vector<std::string> opts) {
+		auto run_args = args;
+		run_args.push_back((workdir / name).string());
+		run_args.insert(run_args.end(), opts.begin(), opts.end());
+		return run(run_args);
+	};
+
+	run_in("fwd_F", { "-F" });
+	run_in("rc_F", { "-index_rc", "-F" });
+	check_same_out(workdir / "fwd_F", workdir / "rc_F", "'-F' with and without '-index_rc'");
+
+	auto fwd = run_in("fwd", {});
+	auto rc = run_in("rc", { "-index_rc" });
+	check(rc.num_aligned * 100 >= fwd.num_aligned * 98 && rc.num_aligned * 100 <= fwd.num_aligned * 102,
+		"'-index_rc' aligned " + std::to_string(rc.num_aligned) + " reads, the forward-only index " + std::to_string(fwd.num_aligned));
+
+	// the strand is the last column of the BLAST report ('qstrand')
+	std::size_t num_plus = 0;
+	std::size_t num_minus = 0;
+	std::ifstream blast(workdir / "rc" / "out" / "aligned.blast");
+	for (std::string line; std::getline(blast, line);) {
+		if (line.empty()) continue;
+		if (line.back() == '+') ++num_plus;
+		else if (line.back() == '-') ++num_minus;
+	}
+	check(num_plus > 0 && num_minus > 0, "'-index_rc' did not align on both strands");
+
+	std::cout << "align_index_rc: aligned " << rc.num_aligned << " (forward-only index: " << fwd.num_aligned << ") strands +/-: "
+		<< num_plus << "/" << num_minus << " failed: " << num_fail << std::endl;
+	return num_fail;
+} // ~align_index_rc
+
+/*
+ * '--fused' post-processing in the alignment pass gives the same reports, OTU map and de novo reads
+ * as the separate passes over the key-value database
+ * @param argv  the run options e.g. -ref .. -reads .. -threads .. with a single part index, and the last one the scratch directory
+ */
+int align_fused_passes(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "align_fused_passes: expecting the run options and a scratch directory" << std::endl;
+		return 1;
+	}
+	num_fail = 0;
+	std::filesystem::path workdir = argv[argc - 1];
+	std::vector<std::string> args(argv, argv + argc - 1);
+	args.insert(args.end(), { "-fastx", "-other", "-blast", "1", "-otu_map", "-de_novo_otu", "-id", "0.8", "-coverage", "0.8", "-workdir" });
+	std::filesystem::remove_all(workdir);
+
+	auto separate_args = args;
+	separate_args.push_back((workdir / "separate").string());
+	auto separate = run(separate_args);
+
+	auto fused_args = args;
+	fused_args.push_back((workdir / "fused").string());
+	fused_args.push_back("-fused");
+	auto fused = run(fused_args);
+
+	auto num_files = check_same_out(workdir / "separate", workdir / "fused", "with and without '-fused'");
+	check(!read_file(workdir / "separate" / "out" / "otu_map.txt").empty(), "no OTU map");
+	check(separate.num_aligned == fused.num_aligned, "the aligned reads differ with '-fused'");
+
+	std::cout << "align_fused_passes: files compared: " << num_files << " aligned: " << fused.num_aligned 
+		<< " failed: " << num_fail << std::endl;
+	return num_fail;
+} // ~align_fused_passes
+
+/*
+ * '--reads -': the reads piped into stdin give the same reports as the reads file, single and interleaved
+ * paired ('-paired_in'). The index has to have two parts at least, so that the alignment of the next part
+ * and the post-processing passes replay the spooled stream
+ * @param argv  the run options e.g. -ref .. -reads FILE -m .. -threads .., and the last one the scratch directory
+ */
+int align_stream(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "align_stream: expecting the run options and a scratch directory" << std::endl;
+		return 1;
+	}
+#if defined(_WIN32)
+	std::cout << "align_stream: stdin stream is not tested on Windows" << std::endl;
+	return 0;
+#else
+	num_fail = 0;
+	std::filesystem::path workdir = argv[argc - 1];
+	std::vector<std::string> args(argv, argv + argc - 1);
+	args.insert(args.end(), { "-fastx", "-other", "-blast", "1", "-idx-dir", (workdir / "idx").string(), "-workdir" });
+	std::filesystem::remove_all(workdir);
+
+	auto it_reads = std::find(args.begin(), args.end(), "-reads");
+	if (it_reads == args.end() || it_reads + 1 == args.end()) {
+		std::cerr << "align_stream: expecting '-reads FILE' in the run options" << std::endl;
+		return 1;
+	}
+	std::filesystem::path readsfile = *(it_reads + 1);
+
+	for (auto const& mode : std::vector<std::vector<std::string>>{ {}, { "-paired_in" } })
+	{
+		std::string name = mode.empty() ? "single" : "paired";
+		auto make_args = [&](const std::string& dir, const std::string& reads) {
+			auto run_args = args;
+			*std::find(run_args.begin(), run_args.end(), readsfile.string()) = reads;
+			run_args.push_back((workdir / dir).string());
+			run_args.insert(run_args.end(), mode.begin(), mode.end());
+			return run_args;
+		};
+		auto file = run(make_args(name + "_file", readsfile.string()));
+		check(file.num_parts > 1, "align_stream: a single part index does not replay the stream");
+
+		// 'cat FILE | sortmerna --reads -'
+		int fds[2];
+		if (pipe(fds) != 0) {
+			std::cerr << "align_stream: pipe failed" << std::endl;
+			return 1;
+		}
+		int stdin_fd = dup(0);
+		dup2(fds[0], 0);
+		close(fds[0]);
+		std::thread writer([&readsfile, fd = fds[1]] {
+			auto data = read_file(readsfile);
+			for (std::size_t pos = 0; pos < data.size();) {
+				auto num = write(fd, data.data() + pos, data.size() - pos);
+				if (num <= 0) break;
+				pos += num;
+			}
+			close(fd);
+		});
+		auto stream = run(make_args(name + "_stream", "-"));
+		writer.join();
+		dup2(stdin_fd, 0);
+		close(stdin_fd);
+
+		check_same_out(workdir / (name + "_file"), workdir / (name + "_stream"), name + " reads file and stream");
+		check(file.num_aligned == stream.num_aligned, name + ": the aligned reads differ with the stream");
+		std::cout << "align_stream: " << name << " index parts: " << file.num_parts << " aligned: " << stream.num_aligned << std::endl;
+	}
+
+	std::cout << "align_stream: failed: " << num_fail << std::endl;
+	return num_fail;
+#endif
+} // ~align_stream
+
+/*
+ * '--dedup' gives the same reports and summary as the alignment of every read, on reads with duplicates:
+ * the reads file of the options followed by its first 'num_dup' reads again under new IDs.
+ * The index has to have two parts at least, so that the cached results, the key-value database records
+ * and the done reads of the first part are carried into the next one.
+ * Both with the best alignments and with the first one ('-no-best -num_alignments 1'), which makes the reads done
+ * @param argv  the run options e.g. -ref .. -reads FASTQ -m .. -threads .., and the last one the scratch directory
+ */
+int align_dedup(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "align_dedup: expecting the run options and a scratch directory" << std::endl;
+		return 1;
+	}
+	num_fail = 0;
+	std::filesystem::path workdir = argv[argc - 1];
+	std::vector<std::string> args(argv, argv + argc - 1);
+	args.insert(args.end(), { "-fastx", "-other", "-blast", "1", "-idx-dir", (workdir / "idx").string(), "-workdir" });
+	std::filesystem::remove_all(workdir);
+	std::filesystem::create_directories(workdir);
+
+	auto it_reads = std::find(args.begin(), args.end(), "-reads");
+	if (it_reads == args.end() || it_reads + 1 == args.end()) {
+		std::cerr << "align_dedup: expecting '-reads FASTQ' in the run options" << std::endl;
+		return 1;
+	}
+
+	// FASTQ: 4 lines a record
+	const std::size_t num_dup = 2000;
+	auto dupfile = workdir / "reads_dup.fastq";
+	{
+		std::ifstream ifs(*(it_reads + 1));
+		std::ofstream ofs(dupfile, std::ios_base::binary);
+		std::vector<std::string> dups;
+		std::size_t num_lines = 0;
+		for (std::string line; std::getline(ifs, line); ++num_lines) {
+			ofs << line << '\n';
+			if (num_lines < num_dup * 4)
+				dups.push_back(num_lines % 4 == 0 ? "@dup_" + line.substr(1) : line);
+		}
+		for (auto const& line : dups) ofs << line << '\n';
+	}
+	*(it_reads + 1) = dupfile.string();
+
+	for (auto const& mode : std::vector<std::vector<std::string>>{ {}, { "-no-best", "-num_alignments", "1" } })
+	{
+		std::string name = mode.empty() ? "best" : "first";
+		auto make_args = [&](const std::string& dir) {
+			auto run_args = args;
+			run_args.push_back((workdir / (name + "_" + dir)).string());
+			run_args.insert(run_args.end(), mode.begin(), mode.end());
+			return run_args;
+		};
+		auto all = run(make_args("all"));
+		check(all.num_parts > 1, "align_dedup: a single part index does not carry the cached results over");
+		check(all.num_dedup_hit == 0, name + ": reads reused a cached alignment without '-dedup'");
+
+		auto dedup_args = make_args("dedup");
+		dedup_args.push_back("-dedup");
+		auto dedup = run(dedup_args);
+		check(dedup.num_dedup_hit > 0, name + ": no read reused a cached alignment");
+		check(mode.empty() || (dedup.num_skipped_done == all.num_skipped_done && dedup.num_skipped_done > 0),
+			name + ": the done reads skipped on the next index part differ with '-dedup'");
+
+		check_same_out(workdir / (name + "_all"), workdir / (name + "_dedup"), name + " with and without '-dedup'");
+		check(all.num_aligned == dedup.num_aligned, name + ": the aligned reads differ with '-dedup'");
+
+		std::cout << "align_dedup: " << name << " index parts: " << dedup.num_parts << " aligned: " << dedup.num_aligned
+			<< " cache hits: " << dedup.num_dedup_hit << " done skipped: " << dedup.num_skipped_done << std::endl;
+	}
+
+	std::cout << "align_dedup: failed: " << num_fail << std::endl;
+	return num_fail;
+} // ~align_dedup
+
+/*
+ * The reads done on an index part are skipped by the feed on the next parts, from the reads file and
+ * from the read cache ('-read_cache'), and the reports are the same as with '--no_skip_done', where
+ * the alignment passes the done reads over itself
+ * @param argv  the run options e.g. -ref .. -reads .. -m .. -threads .., and the last one the scratch directory
+ */
+int align_skip_done(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "align_skip_done: expecting the run options and a scratch directory" << std::endl;
+		return 1;
+	}
+	num_fail = 0;
+	std::filesystem::path workdir = argv[argc - 1];
+	std::vector<std::string> args(argv, argv + argc - 1);
+	// the first alignment found is enough: the read is done for the next index parts (see 'traverse')
+	args.insert(args.end(), { "-no-best", "-num_alignments", "1", "-fastx", "-other", "-blast", "1", "-idx-dir", (workdir / "idx").string(), "-workdir" });
+	std::filesystem::remove_all(workdir);
+
+	auto run_in = [&args, &workdir](const std::string& name, std::vector<std::string> opts) {
+		auto run_args = args;
+		run_args.push_back((workdir / name).string());
+		run_args.insert(run_args.end(), opts.begin(), opts.end());
+		return run(run_args);
+	};
+
+	auto all = run_in("all", { "-no_skip_done" });
+	check(all.num_parts > 1, "align_skip_done: a single part index has no reads to skip");
+	check(all.num_skipped_done == 0, "reads skipped with '-no_skip_done'");
+
+	auto skip = run_in("skip", {});
+	check(skip.num_skipped_done > 0, "no done reads skipped from the reads file");
+	check_same_out(workdir / "all", workdir / "skip", "with and without skipping the done reads");
+	check(all.num_aligned == skip.num_aligned, "the aligned reads differ when skipping the done reads");
+
+	auto cached = run_in("cached", { "-read_cache" });
+	check(cached.num_skipped_done == skip.num_skipped_done, "the done reads skipped from the read cache differ from the reads file");
+	check_same_out(workdir / "all", workdir / "cached", "'-read_cache' with and without skipping the done reads");
+	check(all.num_aligned == cached.num_aligned, "the aligned reads differ when skipping the done reads in the read cache");
+
+	std::cout << "align_skip_done: index parts: " << skip.num_parts << " aligned: " << skip.num_aligned
+		<< " skipped: " << skip.num_skipped_done << " from the read cache: " << cached.num_skipped_done
+		<< " failed: " << num_fail << std::endl;
+	return num_fail;
+} // ~align_skip_done
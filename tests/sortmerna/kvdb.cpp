@@ -34,6 +34,8 @@
  */
 #include <iostream>
 #include <cassert>
+#include <filesystem>
+#include <vector>
 
 #include "kvdb.hpp"
 #include "options.hpp"
@@ -44,4 +46,146 @@ void kvdb_clear()
 	KeyValueDatabase kvdb(dbpath);
 	int ret = kvdb.clear(dbpath);
 	assert(ret == 0);
-}
\ No newline at end of file
+}
+
+/*
+ * read keys: round trip, the reads order, no clash with the other keys e.g. Readstats, Journal
+ * @return number of failures
+ */
+int kvdb_read_key()
+{
+	int num_fail = 0;
+	auto check = [&num_fail](bool is_ok, const std::string& what) {
+		if (!is_ok) {
+			std::cerr << "read_key: FAILED: " << what << std::endl;
+			++num_fail;
+		}
+	};
+
+	const std::size_t slots[] = { 0, 1, 255, 256, 257, 4095, KeyValueDatabase::MAX_READ_SLOTS - 1 };
+	const uint64_t nums[] = { 0, 1, 255, 256, 65535, 65536, 1ULL << 40, ~0ULL };
+	std::string prev;
+	for (auto slot : slots) {
+		for (auto num : nums) {
+			auto key = KeyValueDatabase::read_key(slot, num);
+			std::size_t slot_out = 0;
+			uint64_t num_out = 0;
+			check(key.size() == KeyValueDatabase::READ_KEY_SIZE, "key size");
+			check(KeyValueDatabase::parse_read_key(key, slot_out, num_out) && slot_out == slot && num_out == num,
+				"round trip slot " + std::to_string(slot) + " read " + std::to_string(num));
+			check(prev < key, "key order slot " + std::to_string(slot) + " read " + std::to_string(num));
+			prev = key;
+		}
+	}
+
+	// slots over 255 do not wrap onto the lower ones
+	check(KeyValueDatabase::read_key(256, 7) != KeyValueDatabase::read_key(0, 7), "slot 256 vs 0");
+
+	std::size_t slot_out = 0;
+	uint64_t num_out = 0;
+	for (std::string key : { std::string("journal_12345678901"), std::string("12345678901"), std::string("run_options") })
+		check(!KeyValueDatabase::parse_read_key(key, slot_out, num_out), "not a read key: " + key);
+	return num_fail;
+} // ~kvdb_read_key
+
+/*
+ * Scanner over more slots than a byte i.e. the FWD and REV slots of many chunks, read back chunk by chunk
+ * @param dbpath  directory of a new DB
+ */
+int kvdb_scanner(const std::string& dbpath)
+{
+	int num_fail = 0;
+	const std::size_t num_slots = 600;
+	const uint64_t num_reads = 50;
+	std::filesystem::remove_all(dbpath); // left by a previous run
+	KeyValueDatabase kvdb(dbpath);
+	{
+		KeyValueDatabase::Writer writer(kvdb);
+		for (std::size_t slot = 0; slot < num_slots; ++slot)
+			for (uint64_t num = 0; num < num_reads; num += 1 + slot % 3) // gaps i.e. reads without results
+				writer.put(KeyValueDatabase::read_key(slot, num), std::to_string(slot) + "_" + std::to_string(num));
+	}
+	KeyValueDatabase::Scanner scanner(kvdb);
+	for (std::size_t chunk = 0; chunk < num_slots / 2; ++chunk) {
+		for (uint64_t num = 0; num < num_reads; ++num) {
+			for (std::size_t slot = chunk * 2; slot < chunk * 2 + 2; ++slot) { // FWD, REV in turn
+				auto val = scanner.get(KeyValueDatabase::read_key(slot, num));
+				auto expected = num % (1 + slot % 3) == 0 ? std::to_string(slot) + "_" + std::to_string(num) : std::string();
+				if (val != expected) {
+					std::cerr << "scanner: FAILED: slot " << slot << " read " << num << " got '" << val << "'" << std::endl;
+					++num_fail;
+				}
+			}
+		}
+	}
+	return num_fail;
+} // ~kvdb_scanner
+
+/*
+ * in-memory results over the limit spill to RocksDB: the reads of the table slots,
+ * the reads of slots outside the table, and the other records
+ * @param dbpath  directory of a new DB
+ */
+int kvdb_mem(const std::string& dbpath)
+{
+	int num_fail = 0;
+	std::filesystem::remove_all(dbpath);
+	KeyValueDatabase kvdb(dbpath, false, true, /*mem_max=*/4096);
+	kvdb.init_mem(4, 100);
+	std::vector<std::pair<std::string, std::string>> records;
+	for (std::size_t slot : { 0, 1, 3, 4, 300 }) // 4 and 300 not in the table
+		for (uint64_t num = 0; num < 200; num += 3)
+			records.emplace_back(KeyValueDatabase::read_key(slot, num), std::string(20 + num % 7, 'a' + slot % 26));
+	for (int i = 0; i < 50; ++i)
+		records.emplace_back("misc_" + std::to_string(i), std::string(30, 'm'));
+	for (auto const& rec : records)
+		kvdb.put(rec.first, rec.second);
+	kvdb.put("misc_0", "updated"); // replace a spilled record
+	records[records.size() - 50].second = "updated";
+
+	for (auto const& rec : records) {
+		if (kvdb.get(rec.first) != rec.second) {
+			std::cerr << "kvdb_mem: FAILED: key of size " << rec.first.size() << " got '" << kvdb.get(rec.first) << "'" << std::endl;
+			++num_fail;
+		}
+	}
+	if (!kvdb.get(KeyValueDatabase::read_key(1, 1)).empty() || !kvdb.get(KeyValueDatabase::read_key(4, 1)).empty()) {
+		std::cerr << "kvdb_mem: FAILED: a read without results" << std::endl;
+		++num_fail;
+	}
+	return num_fail;
+} // ~kvdb_mem
+
+/*
+ * '--kvdb_ingest' SST files of two writers, a file per slot, a record put again after a flush
+ * @param dbpath  directory of a new DB
+ */
+int kvdb_ingest(const std::string& dbpath)
+{
+	int num_fail = 0;
+	std::filesystem::remove_all(dbpath);
+	KeyValueDatabase kvdb(dbpath);
+	{
+		KeyValueDatabase::Writer writer_1(kvdb, true), writer_2(kvdb, true);
+		for (std::size_t chunk = 0; chunk < 4; ++chunk) {
+			auto& writer = chunk % 2 ? writer_2 : writer_1;
+			for (uint64_t num = 0; num < 100; ++num) {
+				writer.put(KeyValueDatabase::read_key(chunk * 2, num), "fwd");
+				writer.put(KeyValueDatabase::read_key(chunk * 2 + 1, num), "rev");
+			}
+			writer.flush(); // end of the chunk
+		}
+		writer_1.put(KeyValueDatabase::read_key(0, 5), "again"); // overlaps the file of the slot 0
+	}
+	kvdb.ingest();
+	for (std::size_t slot = 0; slot < 8; ++slot) {
+		for (uint64_t num = 0; num < 100; ++num) {
+			auto expected = slot == 0 && num == 5 ? "again" : slot % 2 ? "rev" : "fwd";
+			if (kvdb.get(KeyValueDatabase::read_key(slot, num)) != expected) {
+				std::cerr << "kvdb_ingest: FAILED: slot " << slot << " read " << num << std::endl;
+				++num_fail;
+			}
+		}
+	}
+	return num_fail;
+} // ~kvdb_ingest
@@ -35,6 +35,7 @@
 #include <string>
 #include <vector>
 #include <iomanip> // setprecision
+#include <filesystem>
 
 #include "readfeed.hpp"
 #include "ThreadPool.hpp"
@@ -47,6 +48,21 @@
 
 // forward
 void kvdb_clear();
+int kvdb_read_key();
+int kvdb_scanner(const std::string& dbpath);
+int kvdb_mem(const std::string& dbpath);
+int kvdb_ingest(const std::string& dbpath);
+int read_resume();
+int read_codec();
+int journal_record(int argc, char** argv);
+int readfeed_codecs(int argc, char** argv);
+int readfeed_sidecars(const std::string& workdir);
+int align_sw_prune(int argc, char** argv);
+int align_index_rc(int argc, char** argv);
+int align_fused_passes(int argc, char** argv);
+int align_stream(int argc, char** argv);
+int align_dedup(int argc, char** argv);
+int align_skip_done(int argc, char** argv);
 
 /**
  * Case 1
@@ -224,6 +240,7 @@ void test_3(int argc, char** argv)
 int main(int argc, char** argv)
 {
 	std::cout << STAMP << "Running with " << argc << " options" << std::endl;
+	int num_fail = 0; // the unit test cases below, which take a scratch directory
 	//Runopts opts(argc, argv, false);
 	if (argc > 2)
 	{
@@ -268,6 +285,45 @@ int main(int argc, char** argv)
 		case 3:
 			test_3(argc, argv);
 			break;
+		case 4:
+			num_fail += kvdb_read_key();
+			num_fail += kvdb_scanner((std::filesystem::path(argv[2]) / "kvdb_scanner").string());
+			num_fail += kvdb_mem((std::filesystem::path(argv[2]) / "kvdb_mem").string());
+			num_fail += kvdb_ingest((std::filesystem::path(argv[2]) / "kvdb_ingest").string());
+			break;
+		case 5:
+			num_fail += read_resume();
+			break;
+		case 6:
+			num_fail += journal_record(argc - 1, argv + 1); // the run options follow the case
+			break;
+		case 7:
+			num_fail += readfeed_codecs(argc - 2, argv + 2);
+			break;
+		case 8:
+			num_fail += readfeed_sidecars((std::filesystem::path(argv[2]) / "readfeed_sidecars").string());
+			break;
+		case 9:
+			num_fail += align_sw_prune(argc - 1, argv + 1); // the run options follow the case
+			break;
+		case 10:
+			num_fail += read_codec();
+			break;
+		case 11:
+			num_fail += align_index_rc(argc - 1, argv + 1); // the run options follow the case
+			break;
+		case 12:
+			num_fail += align_fused_passes(argc - 1, argv + 1); // the run options follow the case
+			break;
+		case 13:
+			num_fail += align_stream(argc - 1, argv + 1); // the run options follow the case
+			break;
+		case 14:
+			num_fail += align_dedup(argc - 1, argv + 1); // the run options follow the case
+			break;
+		case 15:
+			num_fail += align_skip_done(argc - 1, argv + 1); // the run options follow the case
+			break;
 		default:
 			std::cout << "Unknown arg: " << scase << std::endl;
 		}
@@ -277,5 +333,7 @@ int main(int argc, char** argv)
 		std::cerr << "Expecting at least one argument: test case e.g. 0 | 1 | 2 etc." << std::endl;
 	}
 
-	return 0;
+	if (num_fail > 0)
+		std::cerr << "Failed checks: " << num_fail << std::endl;
+	return num_fail > 0 ? 1 : 0;
 } // ~main
\ No newline at end of file
@@ -0,0 +1,306 @@
+/*
+ @copyright 2016-2021  Clarity Genomics BVBA
+ @copyright 2012-2016  Bonsai Bioinformatics Research Group
+ @copyright 2014-2016  Knight Lab, Department of Pediatrics, UCSD, La Jolla
+
+ @parblock
+ SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+ This is a free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ SortMeRNA is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+ @endparblock
+
+ @contributors Jenya Kopylova   jenya.kopylov@gmail.com
+			   Laurent No      laurent.noe@lifl.fr
+			   Pierre Pericard  pierre.pericard@lifl.fr
+			   Daniel McDonald  wasade@gmail.com
+			   Mikal Salson    mikael.salson@lifl.fr
+			   Hlne Touzet    helene.touzet@lifl.fr
+			   Rob Knight       robknight@ucsd.edu
+*/
+
+/* 
+ * FILE: read.cpp
+ * Created: Oct 19, 2026 Mon
+ */
+#include <iostream>
+#include <filesystem>
+#include <atomic>
+#include <vector>
+
+#include "read.hpp"
+#include "readstats.hpp"
+#include "journal.hpp"
+#include "kvdb.hpp"
+#include "options.hpp"
+
+namespace {
+	int num_fail = 0;
+
+	void check(bool is_ok, const std::string& what)
+	{
+		if (!is_ok) {
+			std::cerr << "FAILED: " << what << std::endl;
+			++num_fail;
+		}
+	}
+
+	s_align2 make_align(uint16_t index_num, uint16_t part, uint32_t ref_num, uint16_t score)
+	{
+		s_align2 align;
+		align.index_num = index_num;
+		align.part = part;
+		align.ref_num = ref_num;
+		align.ref_begin1 = 10;
+		align.ref_end1 = 109;
+		align.read_begin1 = 0;
+		align.read_end1 = 99;
+		align.readlen = 100;
+		align.score1 = score;
+		align.strand = true;
+		align.cigar = { 100 << 4 }; // 100M
+		return align;
+	}
+
+	/*
+	 * the Readstats changes and the read fields an alignment on the part makes
+	 * as 'traverse' and 'alignment.cpp' do. '--best 1'
+	 */
+	void align_on(Read& read, uint16_t idx_num, uint16_t idx_part, uint16_t score,
+		std::atomic<uint64_t>& num_aligned, std::vector<uint64_t>& per_db)
+	{
+		if (read.lastIndex != idx_num || read.lastPart != idx_part) {
+			read.is_part_hit = false;
+			read.part_db_moves.clear();
+		}
+		read.lastIndex = idx_num;
+		read.lastPart = idx_part;
+		if (!read.is_hit) {
+			read.is_hit = true;
+			read.is_part_hit = true;
+			++num_aligned;
+			++per_db[idx_num];
+		}
+		if (read.alignment.alignv.empty()) {
+			read.alignment.alignv.push_back(make_align(idx_num, idx_part, 7, score));
+		}
+		else if (read.alignment.alignv[0].score1 < score) {
+			auto old_db = read.alignment.alignv[0].index_num;
+			read.alignment.alignv[0] = make_align(idx_num, idx_part, 7, score);
+			--per_db[old_db];
+			++per_db[idx_num];
+			read.part_db_moves.push_back(old_db);
+		}
+		read.is_new_hit = true;
+	}
+
+	bool is_same(const s_align2& a, const s_align2& b)
+	{
+		return a.cigar == b.cigar && a.ref_num == b.ref_num && a.ref_begin1 == b.ref_begin1 && a.ref_end1 == b.ref_end1
+			&& a.read_begin1 == b.read_begin1 && a.read_end1 == b.read_end1 && a.readlen == b.readlen
+			&& a.score1 == b.score1 && a.part == b.part && a.index_num == b.index_num && a.strand == b.strand;
+	}
+
+	Read restore(Read& read)
+	{
+		Read res;
+		res.id = read.id;
+		res.fromBinString(read.toBinString());
+		return res;
+	}
+} // namespace
+
+/*
+ * A run stopped in the middle of the index part 1 and resumed: the reads aligned on the part
+ * before the stop are skipped, their Readstats changes replayed on the statistics of the part 0.
+ * The result must be the statistics of a run not stopped.
+ * @return number of failures
+ */
+int read_resume()
+{
+	num_fail = 0;
+	std::atomic<uint64_t> num_aligned = 0; // as of the part 0 done i.e. the journal
+	std::vector<uint64_t> per_db = { 0, 0 };
+
+	// the part 0 (index 0)
+	Read a, b, c;
+	a.id = "0_0"; b.id = "0_1"; c.id = "0_2";
+	align_on(a, 0, 0, 50, num_aligned, per_db); // hit on the index 0, replaced by the index 1 below
+	align_on(c, 0, 0, 50, num_aligned, per_db); // aligned on the part 1 after the stop
+	check(num_aligned == 2 && per_db[0] == 2 && per_db[1] == 0, "stats of the part 0");
+	a = restore(a);
+	c = restore(c);
+	Read c_db = c; // not stored on the part 1 before the stop
+	auto journal_aligned = num_aligned.load();
+	auto journal_per_db = per_db;
+
+	// the part 1 (index 1) not stopped
+	align_on(a, 1, 0, 90, num_aligned, per_db); // better score - replaces the alignment on the index 0
+	align_on(b, 1, 0, 60, num_aligned, per_db); // first hit
+	align_on(c, 1, 0, 40, num_aligned, per_db); // no better
+	const auto expected_aligned = num_aligned.load();
+	const auto expected_per_db = per_db;
+	check(expected_aligned == 3 && expected_per_db[0] == 1 && expected_per_db[1] == 2, "stats of the part 1");
+
+	// stopped after 'a' and 'b' were stored, 'c' was not. Resumed from the journal of the part 0
+	Read a_db = restore(a), b_db = restore(b);
+	std::atomic<uint64_t> num_aligned_2 = journal_aligned;
+	std::vector<uint64_t> per_db_2 = journal_per_db;
+	check(a_db.is_aligned_on(1, 0) && b_db.is_aligned_on(1, 0), "aligned on the part 1");
+	check(!c_db.is_aligned_on(1, 0) && c_db.is_aligned_on(0, 0), "'c' aligned on the part 0 only");
+	check(!a_db.is_aligned_on(1, 1) && !Read().is_aligned_on(0, 0), "later part, read not restored");
+	a_db.replay_part_stats(num_aligned_2, per_db_2);
+	b_db.replay_part_stats(num_aligned_2, per_db_2);
+	align_on(c_db, 1, 0, 40, num_aligned_2, per_db_2);
+	check(num_aligned_2 == expected_aligned, "resumed num_aligned " + std::to_string(num_aligned_2.load()));
+	check(per_db_2 == expected_per_db, "resumed reads_matched_per_db");
+	check(a_db.alignment.alignv.size() == 1 && a_db.alignment.alignv[0].index_num == 1, "no duplicate alignments");
+	return num_fail;
+} // ~read_resume
+
+/*
+ * Journal record: round trip, mismatches of the inputs, version, truncation, no CIGAR flag and KVDB format of the statistics
+ * @param argv  options of a run e.g. '--ref <file> --reads <file> --workdir <scratch>'
+ * @return number of failures
+ */
+int journal_record(int argc, char** argv)
+{
+	num_fail = 0;
+	Runopts opts(argc, argv, false);
+	std::filesystem::remove_all(opts.kvdbdir);
+	KeyValueDatabase kvdb(opts.kvdbdir.string());
+	Readstats readstats(0, 0, 0, 0, kvdb, opts);
+	std::string dbkey = "journal_" + readstats.dbkey;
+
+	{
+		Journal journal(opts, readstats);
+		check(journal.restore(kvdb) == Journal::STATE::NONE, "no journal");
+		check(!journal.is_done(0, 0), "nothing done");
+		journal.store(kvdb, readstats, 1, 2);
+	}
+	{
+		Journal journal(opts, readstats);
+		check(journal.restore(kvdb) == Journal::STATE::MATCH, "journal restored");
+		check(journal.is_done(0, 5) && journal.is_done(1, 0) && journal.is_done(1, 2), "parts done");
+		check(!journal.is_done(1, 3) && !journal.is_done(2, 0), "parts not done");
+	}
+
+	auto record = kvdb.get(dbkey);
+	auto restore = [&](const std::string& val) {
+		kvdb.put(dbkey, val);
+		Journal journal(opts, readstats);
+		return journal.restore(kvdb);
+	};
+	for (std::size_t len = 1; len < record.size(); len += 3)
+		check(restore(record.substr(0, len)) == Journal::STATE::MISMATCH, "truncated to " + std::to_string(len));
+	auto bad = record;
+	bad[0] ^= 0x7F;
+	check(restore(bad) == Journal::STATE::MISMATCH, "version");
+	bad = record;
+	bad[8] ^= 0x01; // in the fingerprint
+	check(restore(bad) == Journal::STATE::MISMATCH, "fingerprint");
+	check(restore(record + "x") == Journal::STATE::MISMATCH, "trailing bytes");
+
+	// no CIGAR (score-only alignment) is stored with the statistics of the part done
+	readstats.is_cigar = false;
+	Journal(opts, readstats).store(kvdb, readstats, 1, 2);
+	check(!Readstats(0, 0, 0, 0, kvdb, opts).is_cigar, "no CIGAR restored");
+
+	// the statistics of an older version: no CIGAR flag nor format i.e. the read ID string keys.
+	// Restored here as the constructor refuses them
+	auto stats = kvdb.get(readstats.dbkey);
+	kvdb.put(readstats.dbkey, stats.substr(0, stats.size() - sizeof(readstats.is_cigar) - sizeof(readstats.kvdb_format)));
+	check(readstats.restoreFromDb(kvdb) && readstats.is_cigar && readstats.kvdb_format == 1, "statistics of an older version");
+	kvdb.put(readstats.dbkey, stats);
+	check(readstats.restoreFromDb(kvdb) && readstats.kvdb_format == KeyValueDatabase::FORMAT_VERSION, "KVDB format restored");
+
+	opts.cmdline += " --other"; // different options
+	check(restore(record) == Journal::STATE::MISMATCH, "different options");
+	return num_fail;
+} // ~journal_record
+
+/*
+ * Read record codec: round trip of all the stored fields, unknown version, truncated and corrupt records
+ * @return number of failures
+ */
+int read_codec()
+{
+	num_fail = 0;
+	Read read;
+	read.id = "0_0";
+	check(read.toBinString().empty(), "no alignments - nothing stored");
+	check(!read.fromBinString("") && !read.isRestored, "empty record");
+
+	read.is_done = true;
+	read.is_hit = true;
+	read.null_align_output = false;
+	read.is_part_hit = true;
+	read.lastIndex = 2;
+	read.lastPart = 300;
+	read.part_db_moves = { 0, 1, 1 };
+	read.c_yid_ycov = 5;
+	read.n_yid_ncov = 0;
+	read.n_nid_ycov = 70000;
+	read.n_denovo = 1;
+	read.max_SW_count = 10;
+	read.num_alignments = -1;
+	read.hit_seeds = 1234567;
+	read.alignment.min_index = 1;
+	read.alignment.max_index = 2;
+	read.alignment.alignv.push_back(make_align(2, 300, 4000000000U, 65535)); // max values
+	read.alignment.alignv.push_back(make_align(0, 0, 0, 0)); // ref_num below the previous one
+	auto& align = read.alignment.alignv.back();
+	align.strand = false;
+	align.ref_begin1 = 1000;
+	align.ref_end1 = 10; // reversed coordinates i.e. a negative delta
+	align.read_begin1 = -1;
+	align.read_end1 = 0;
+	align.cigar = { 3 << 4 | 1, 50 << 4, 0x7FFFFFF << 4 | 4, 0 }; // 3I 50M large S, empty op
+	read.alignment.alignv.push_back(make_align(1, 1, 17, 80));
+	read.alignment.alignv.back().cigar.clear();
+
+	auto bin = read.toBinString();
+	Read res;
+	res.id = read.id;
+	check(res.decodeBinString(bin) == Read::RECORD::OK, "round trip decoded");
+	check(res.is_done == read.is_done && res.is_hit == read.is_hit && res.null_align_output == read.null_align_output
+		&& res.is_part_hit == read.is_part_hit, "flags");
+	check(res.lastIndex == read.lastIndex && res.lastPart == read.lastPart && res.part_db_moves == read.part_db_moves,
+		"last part and DB moves");
+	check(res.c_yid_ycov == read.c_yid_ycov && res.n_yid_ncov == read.n_yid_ncov && res.n_nid_ycov == read.n_nid_ycov
+		&& res.n_denovo == read.n_denovo && res.max_SW_count == read.max_SW_count
+		&& res.num_alignments == read.num_alignments && res.hit_seeds == read.hit_seeds, "counters");
+	check(res.alignment.min_index == 1 && res.alignment.max_index == 2
+		&& res.alignment.alignv.size() == read.alignment.alignv.size(), "alignment");
+	for (std::size_t i = 0; i < res.alignment.alignv.size() && i < read.alignment.alignv.size(); ++i)
+		check(is_same(res.alignment.alignv[i], read.alignment.alignv[i]), "alignment " + std::to_string(i));
+	check(res.toBinString() == bin, "encoded again");
+	check(res.fromBinString(bin) && res.isRestored, "restored");
+
+	// the decoder must not read past the record on any damage. Also run with ASan
+	for (std::size_t len = 1; len < bin.size(); ++len)
+		check(Read().decodeBinString(bin.substr(0, len)) == Read::RECORD::CORRUPT, "truncated to " + std::to_string(len));
+	check(Read().decodeBinString(bin + '\0') == Read::RECORD::CORRUPT, "trailing byte");
+	auto bad = bin;
+	bad[0] = static_cast<char>(bad[0] + 1);
+	check(Read().decodeBinString(bad) == Read::RECORD::VERSION, "newer version");
+	bad[0] = 1;
+	check(Read().decodeBinString(bad) == Read::RECORD::VERSION, "version 1 i.e. the raw layout");
+	for (std::size_t pos = 1; pos < bin.size(); ++pos) {
+		bad = bin;
+		bad[pos] = static_cast<char>(0xFF); // e.g. a count turned into a huge varint
+		Read().decodeBinString(bad);
+	}
+	bad = bin.substr(0, 2) + std::string(16, static_cast<char>(0xFF)); // varint longer than 64 bits
+	check(Read().decodeBinString(bad) == Read::RECORD::CORRUPT, "overlong varint");
+	return num_fail;
+} // ~read_codec
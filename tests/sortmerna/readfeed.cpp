@@ -0,0 +1,229 @@
+/*
+ @copyright 2016-2021  Clarity Genomics BVBA
+ @copyright 2012-2016  Bonsai Bioinformatics Research Group
+ @copyright 2014-2016  Knight Lab, Department of Pediatrics, UCSD, La Jolla
+
+ @parblock
+ SortMeRNA - next-generation reads filter for metatranscriptomic or total RNA
+ This is a free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ SortMeRNA is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with SortMeRNA. If not, see <http://www.gnu.org/licenses/>.
+ @endparblock
+
+ @contributors Jenya Kopylova   jenya.kopylov@gmail.com
+			   Laurent No      laurent.noe@lifl.fr
+			   Pierre Pericard  pierre.pericard@lifl.fr
+			   Daniel McDonald  wasade@gmail.com
+			   Mikal Salson    mikael.salson@lifl.fr
+			   Hlne Touzet    helene.touzet@lifl.fr
+			   Rob Knight       robknight@ucsd.edu
+*/
+
+/* 
+ * FILE: readfeed.cpp
+ * Created: Oct 19, 2026 Mon
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <chrono>
+#if defined(HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "readfeed.hpp"
+
+namespace {
+	int num_fail = 0;
+
+	void check(bool is_ok, const std::string& what)
+	{
+		if (!is_ok) {
+			std::cerr << "FAILED: " << what << std::endl;
+			++num_fail;
+		}
+	}
+
+	struct Feed {
+		std::vector<std::string> reads; // records of all the chunks in order
+		std::vector<size_t> chunk_reads; // number of reads per chunk
+	};
+
+	/*
+	 * read the file by 2 parts x 2 chunks, twice (rewind in between) as the alignment does.
+	 * The second pass has to yield the same reads
+	 */
+	Feed read_all(const std::string& readsfile, const std::filesystem::path& workdir, const std::string& label)
+	{
+		std::vector<std::string> files{ readsfile };
+		auto dir = workdir / label;
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir);
+		Feed res;
+		Readfeed feed(FEED_TYPE::INDEXED, files, 2, dir, false, 2);
+		feed.init_reading();
+		for (int pass = 0; pass < 2; ++pass) {
+			std::vector<std::string> reads;
+			for (unsigned i = 0; i < feed.num_chunks; ++i) {
+				size_t num = 0;
+				for (std::string read; feed.next(i, read); ++num)
+					reads.push_back(read.substr(read.find('\n') + 1)); // w/o the '<chunk>_<read>' id
+				if (pass == 0) res.chunk_reads.push_back(num);
+			}
+			if (pass == 0)
+				res.reads = reads;
+			else
+				check(reads == res.reads, label + ": the second pass differs from the first");
+			feed.rewind_in();
+		}
+		return res;
+	}
+
+#if defined(HAVE_ZSTD)
+	/* compress 'data' into 'path'. The frames hold 'frame_size' bytes each, or all the data if 0 */
+	void write_zstd(const std::string& data, const std::filesystem::path& path, size_t frame_size)
+	{
+		std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (frame_size == 0) frame_size = data.size();
+		for (size_t pos = 0; pos < data.size(); pos += frame_size) {
+			auto len = std::min(frame_size, data.size() - pos);
+			std::string frame(ZSTD_compressBound(len), '\0');
+			auto n = ZSTD_compress(&frame[0], frame.size(), data.data() + pos, len, 3);
+			ofs.write(frame.data(), static_cast<std::streamsize>(n));
+		}
+	}
+#endif
+} // namespace
+
+/*
+ * The reads of the compressed files are the same as of the flat file, in the same order
+ * @param argv  flat reads file | its gzip | its bzip2 | scratch directory
+ */
+int readfeed_codecs(int argc, char** argv)
+{
+	if (argc < 4) {
+		std::cerr << "readfeed_codecs: expecting <reads> <reads.gz> <reads.bz2> <workdir>" << std::endl;
+		return 1;
+	}
+	num_fail = 0;
+	std::filesystem::path workdir = argv[3];
+	auto flat = read_all(argv[0], workdir, "flat");
+	check(flat.reads.size() > 0, "flat: no reads");
+	check(flat.chunk_reads.size() == 4 && flat.chunk_reads[1] > 0, "flat: reads are not split into the chunks");
+
+	auto gz = read_all(argv[1], workdir, "gz");
+	check(gz.reads == flat.reads, "gz: reads differ from the flat file");
+	auto bz2 = read_all(argv[2], workdir, "bz2");
+	check(bz2.reads == flat.reads, "bz2: reads differ from the flat file");
+
+#if defined(HAVE_ZSTD)
+	std::ifstream ifs(argv[0], std::ios_base::in | std::ios_base::binary);
+	std::stringstream ss;
+	ss << ifs.rdbuf();
+	auto data = ss.str();
+	std::filesystem::create_directories(workdir);
+
+	write_zstd(data, workdir / "single.fastq.zst", 0);
+	auto single = read_all((workdir / "single.fastq.zst").string(), workdir, "zst_single");
+	check(single.reads == flat.reads, "zstd single frame: reads differ from the flat file");
+	// no seek points - all the reads go to the first chunk
+	check(!single.chunk_reads.empty() && single.chunk_reads[0] == flat.reads.size(),
+		"zstd single frame: not read by the first chunk");
+
+	write_zstd(data, workdir / "multi.fastq.zst", data.size() / 10 + 1);
+	auto multi = read_all((workdir / "multi.fastq.zst").string(), workdir, "zst_multi");
+	check(multi.reads == flat.reads, "zstd frames: reads differ from the flat file");
+	check(multi.chunk_reads == flat.chunk_reads, "zstd frames: chunks differ from the flat file");
+#endif
+
+	std::cout << "readfeed_codecs: " << flat.reads.size() << " reads, failed: " << num_fail << std::endl;
+	return num_fail;
+} // ~readfeed_codecs
+
+/*
+ * The read cache and the reads index are only used for the reads file they were made from:
+ * same size, modification time and content fingerprint (see FileId)
+ * @param workdir  scratch directory
+ */
+int readfeed_sidecars(const std::string& workdir)
+{
+	num_fail = 0;
+	std::filesystem::path dir = workdir;
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+
+	auto readsfile = dir / "reads.fasta";
+	auto write_reads = [&readsfile](const std::string& seq) {
+		std::ofstream ofs(readsfile, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		ofs << ">r1\n" << seq << "\n>r2\nGGGGCCCCAAAATTTT\n";
+	};
+	write_reads("ACGTACGTNNACGTAC");
+	FileId id(readsfile);
+	auto mtime = std::filesystem::last_write_time(readsfile);
+	check(id == FileId(readsfile), "FileId: not stable");
+
+	// read cache
+	ReadCache cache;
+	cache.path = dir / "readcache.bin";
+	cache.open_write(id, 0, 100);
+	cache.put("r1", "ACGTACGTNNACGTAC", "");
+	cache.close(); // not finished
+	check(!cache.open_read(id, 0, 100), "ReadCache: incomplete cache opened");
+	cache.open_write(id, 0, 100);
+	cache.put("r1", "ACGTACGTNNACGTAC", "");
+	cache.finish();
+	check(cache.open_read(id, 0, 100), "ReadCache: valid cache not opened");
+	std::string readstr;
+	check(cache.get(readstr) && readstr.find("ACGTACGTNNACGTAC") != std::string::npos, "ReadCache: record differs");
+	check(!cache.open_read(id, 0, 99), "ReadCache: opened for another byte range");
+
+	FileId touched = id;
+	touched.mtime += 1;
+	check(!cache.open_read(touched, 0, 100), "ReadCache: opened for another modification time");
+	// same size and time, changed content e.g. restored time stamp
+	write_reads("ACGTACGTNNACGTAA");
+	std::filesystem::last_write_time(readsfile, mtime);
+	FileId changed(readsfile);
+	check(changed.size == id.size && changed.mtime == id.mtime, "FileId: size or time of the rewrite differ");
+	check(changed.fingerprint != id.fingerprint, "FileId: fingerprint does not see the change");
+	check(!cache.open_read(changed, 0, 100), "ReadCache: opened for a changed file");
+	cache.close();
+
+	// reads index
+	write_reads("ACGTACGTNNACGTAC");
+	std::filesystem::last_write_time(readsfile, mtime);
+	ReadIndex ridx;
+	ridx.init(dir, readsfile, 2);
+	ridx.num_reads = 2;
+	ridx.set_checkpoints({ 4, 21, 25, 42 }, 1);
+	ridx.store();
+	ReadIndex loaded;
+	loaded.init(dir, readsfile, 2);
+	check(loaded.load() && loaded.num_reads == 2 && loaded.num_records == 2, "ReadIndex: valid index not loaded");
+	loaded.init(dir, readsfile, 4);
+	check(!loaded.load(), "ReadIndex: loaded for another number of lines per record");
+
+	write_reads("ACGTACGTNNACGTAA");
+	std::filesystem::last_write_time(readsfile, mtime);
+	loaded.init(dir, readsfile, 2);
+	check(!loaded.load(), "ReadIndex: loaded for a changed file");
+	write_reads("ACGTACGTNNACGTAC"); // same content, touched
+	std::filesystem::last_write_time(readsfile, mtime + std::chrono::seconds(10));
+	loaded.init(dir, readsfile, 2);
+	check(loaded.file_id.fingerprint == id.fingerprint && !loaded.load(), "ReadIndex: loaded for another modification time");
+
+	std::cout << "readfeed_sidecars: failed: " << num_fail << std::endl;
+	return num_fail;
+} // ~readfeed_sidecars